@@ -13,6 +13,9 @@
 #include <algorithm>
 #include <iomanip>
 #include <math.h>
+#include <unordered_map>
+#include "compressed_stream.h"
+#include "pipeline.h"
 
 using std::string;
 using std::cout;
@@ -44,19 +47,44 @@ struct transition
 	double gA;
 };
 
+// result of one block of lines
+struct parsed_batch
+{
+	std::vector<transition> lines;
+	string error;	// first line with unknown levels
+};
+
 // program start
 int main(int argc, char* argv[])
 {
 	if(argc < 3)
 	{
-		cout << "Usage: adamant_to_toss <level-file> <line-file>" << std::endl;
+		cout << "Usage: adamant_to_toss <level-file> <line-file> <options>" << std::endl;
+		cout << "files may be gzip/zstd compressed" << std::endl;
+		cout << "Options: out=<file>, threads=<number>" << std::endl;
+		cout << "out: write the TOSS lines to a file instead of the screen, compressed for .gz/.zst" << std::endl;
+		cout << "threads: number of parser threads (default: all cores)" << std::endl;
 		return 0;
 	}
 
+	string out_file;
+	unsigned nthreads = std::thread::hardware_concurrency();
+	for(int i = 3; i < argc; i++)
+	{
+		string s(argv[i]);
+		if (s.substr(0,4) == "out=")
+			out_file = s.substr(4);
+		else if (s.substr(0,8) == "threads=")
+		{
+			std::stringstream ss(s.substr(8));
+			ss >> nthreads;
+		}
+	}
+
 	// buffers for input, in/out stream, line buffer
 	std::vector<level> vec_levels;
 	std::vector<transition> vec_lines;
-	std::ifstream in;
+	cifstream in;
 	std::stringstream out;
 	string line;
 
@@ -91,64 +119,95 @@ int main(int argc, char* argv[])
 	if(in.is_open())
 	{
 		out << std::endl << "  Wavelength         Lower Level         Upper Level   log gf        gA" << std::endl << std::endl;
-		// read in transitions
-		while(getline(in,line))
-		{
-			std::stringstream s(line);
-			int id_low, id_up;
-			string s1;
-			double wvl, gf, A;
-			s >> id_low >> s1 >> id_up >> s1 >> s1 >> wvl >> A >> gf;
-
-			level l_low,l_up;
-			int found = 0;
 
-			// check / assign level references
-			for(const level &elem : vec_levels)
+		// level ids -> index (first level with that id), read only for
+		// the parser threads
+		std::unordered_map<int, size_t> ids;
+		for(size_t i = 0; i < vec_levels.size(); i++)
+			ids.emplace(vec_levels[i].id, i);
+
+		// read in transitions: reader thread, parser threads, results in
+		// file order; only the first unknown level reference is kept
+		string error;
+		run_line_pipeline<parsed_batch>(in, nthreads,
+			[&](const string& text, parsed_batch& r)
 			{
-				if(found == 2)
-					break;
-
-				if(id_low == elem.id || id_up == elem.id)
+				for_each_line(text, [&](const string& line)
 				{
-					found++;
-					if(1 == found)
-						l_low = elem;
-					else
+					std::stringstream s(line);
+					int id_low, id_up;
+					string s1;
+					double wvl, gf, A;
+					s >> id_low >> s1 >> id_up >> s1 >> s1 >> wvl >> A >> gf;
+
+					// check / assign level references
+					auto lo = ids.find(id_low);
+					auto hi = ids.find(id_up);
+					if(lo == ids.end() || hi == ids.end() || id_low == id_up)
 					{
-						if(l_low.energy > elem.energy)
-						{
-							l_up = l_low;
-							l_low = elem;
-						}
-						else
-							l_up = elem;
+						if(r.error.empty())
+							r.error = line;
+						return;
 					}
-				}
-			}
-
-			if(found != 2)
+					// same as scanning the level list: the first one found
+					// is the lower one unless the second has less energy
+					level l_low = vec_levels[std::min(lo->second, hi->second)];
+					level l_up = vec_levels[std::max(lo->second, hi->second)];
+					if(l_low.energy > l_up.energy)
+						std::swap(l_low, l_up);
+
+					// add to vector
+					if(r.error.empty())
+						r.lines.push_back(transition{wvl, l_low, l_up, log10(gf), A * (2*l_up.J + 1)});
+				});
+			},
+			[&](parsed_batch& r)
 			{
-				cout << "** Error: couldn't find corresponding levels to " << endl << line << endl;
-				return 1;
-			}
-
-			// add to vector
-			vec_lines.push_back(transition{wvl, l_low, l_up, log10(gf), A * (2*l_up.J + 1)});
+				if(!error.empty())
+					return;
+				vec_lines.insert(vec_lines.end(), std::make_move_iterator(r.lines.begin()), std::make_move_iterator(r.lines.end()));
+				error = r.error;
+			});
+		if(!error.empty())
+		{
+			cout << "** Error: couldn't find corresponding levels to " << endl << error << endl;
+			return 1;
 		}
 		in.close();
 
 		// sort lines
 		std::sort(vec_lines.begin(),vec_lines.end(),[](const transition& lhs, const transition& rhs){return lhs.wvl < rhs.wvl;});
-		// prepare / output
-		for(const transition &t : vec_lines)
+		// prepare / output: blocks of lines are formatted while the
+		// writer thread writes the last ones
+		cofstream file;
+		if(!out_file.empty())
+			file.open(out_file);
+		std::ostream& os = out_file.empty() ? (std::ostream&)cout : (std::ostream&)file;
+		async_writer writer(os);
+		for(size_t i0 = 0; i0 < vec_lines.size() || i0 == 0; i0 += 10000)
 		{
-			out << std::setw(12) << std::fixed << std::setprecision(3) << t.wvl << " "
-					<< std::setw(10) << std::setprecision(1) << t.low.energy << " (" << t.low.parity << ") " << std::setw(4) << t.low.J << " "
-					<< std::setw(10) << std::setprecision(1) << t.up.energy << " (" << t.up.parity << ") " << std::setw(4) << t.up.J
-					<< "  " << std::setprecision(3) << std::setw(7) << t.loggf << " " << std::scientific << std::setw(5) << std::setprecision(3) << t.gA << endl;
+			for(size_t i = i0; i < std::min(vec_lines.size(), i0 + 10000); i++)
+			{
+				const transition &t = vec_lines[i];
+				out << std::setw(12) << std::fixed << std::setprecision(3) << t.wvl << " "
+						<< std::setw(10) << std::setprecision(1) << t.low.energy << " (" << t.low.parity << ") " << std::setw(4) << t.low.J << " "
+						<< std::setw(10) << std::setprecision(1) << t.up.energy << " (" << t.up.parity << ") " << std::setw(4) << t.up.J
+						<< "  " << std::setprecision(3) << std::setw(7) << t.loggf << " " << std::scientific << std::setw(5) << std::setprecision(3) << t.gA << endl;
+			}
+			writer.write(out.str());
+			out.str("");
+		}
+		writer.close();
+		if(!out_file.empty())
+		{
+			file.close();
+			if(file.fail())
+			{
+				cout << "** ERROR: couldn't write file: " << out_file << endl;
+				return -1;
+			}
+			cout << "** written to: " << out_file << endl;
 		}
-		cout << out.str();
 	}
 	else
 	{
@@ -0,0 +1,225 @@
+//========================================================================
+// Name        : atomic_chain.cpp
+// Author      : Michael Knoerzer
+// Version     : 1.0 (2026-10-18)
+// Copyright   : Copyright (c) 2026
+// Description : Whole chain in one run: reads a NIST or ADAMANT source
+//             : once and writes the TOSS line list, the TOSS level file,
+//             : the Grotrian diagram (WRPLOT) and the fplot idents from
+//             : the same in-memory table, no text round trips in between
+//             : C++11 !
+//========================================================================
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstdio>
+#include "atomic_data.h"
+#include "diagnostics.h"
+#include "grotrian_layout.h"
+#include "fplot_idents.h"
+using namespace std;
+
+// A10 level name as in the level files of toss_to_grotrian:
+// code (3) + last subshell (3) + J (1) + term (2) + parity (1)
+string toss_level_name(const string& code, const atomic_level& l)
+{
+	string config = l.config, term = l.term;
+	auto us = config.find('_');
+	if (term.empty() && us != string::npos)
+	{
+		term = config.substr(us + 1);
+		config = config.substr(0, us);
+	}
+	string conf = grotrian_short_conf(config);
+	transform(conf.begin(), conf.end(), conf.begin(), ::toupper);
+	transform(term.begin(), term.end(), term.begin(), ::toupper);
+	return toss_level_record::name::format(code, conf, to_string(min(9, (int)l.J)), term, l.p ? "O" : "");
+}
+
+// ofstream with a message if it cannot be opened
+bool open_output(ofstream& out, const string& file)
+{
+	out.open(file.c_str());
+	if (!out.is_open())
+		cout << "** ERROR: couldn't open file: " << file << endl;
+	return out.is_open();
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc < 3)
+	{
+		cout << "\nUsage: atomic_chain <source> <ionlimit> <options>\n";
+		cout << "\nSources: nist:<file>, adamant:<level file>,<line file>\n";
+		cout << "ionlimit in cm^-1\n";
+		cout << "\nWrites <out>_out_toss, <out>_levels, <out>_grotrian and <out>_fplot\n";
+		cout << "\nOptions: out=<prefix>, code=<string>, e=<number>, n=<number>, l=<number>, c=<Term><parity>,\n";
+		cout << "         off=<number>, zoom=<Emin>:<Emax>, scale=<number>, u=<true/false>, diag=<number>, rej=<file>\n";
+		cout << "out:   prefix of the output files (default: the source file)\n";
+		cout << "code:  element code at the start of the level names (3 characters)\n";
+		cout << "e, n, l, c, off, zoom: levels left out of the Grotrian diagram and windows, see toss_to_grotrian\n";
+		cout << "scale, u: ident length of the fplot idents, see toss_to_fplot\n";
+		cout << "diag is the number of bad records printed per error, rej writes all of them to a file" << endl;
+		return 0;
+	}
+
+	// default values
+	string source = argv[1];
+	double ionlimit = atof(argv[2]);
+	string prefix = source.substr(source.find(':') + 1);
+	prefix = prefix.substr(0, prefix.find(','));
+	string code = "ION";
+	double scale = 1.0;
+	bool asUnit = false;
+	grotrian_options opt;
+	diagnostics diag;
+
+	for (int i = 3; i < argc; i++)
+	{
+		string s(argv[i]);
+		if (s.substr(0, 4) == "out=")
+		{
+			prefix = s.substr(4);
+		}
+		else if (s.substr(0, 5) == "code=")
+		{
+			code = s.substr(5);
+		}
+		else if (s.substr(0, 2) == "e=")
+		{
+			stringstream ss(s.substr(2));
+			ss >> opt.skip_e;
+		}
+		else if (s.substr(0, 2) == "n=")
+		{
+			stringstream ss(s.substr(2));
+			ss >> opt.skip_n;
+		}
+		else if (s.substr(0, 2) == "l=")
+		{
+			stringstream ss(s.substr(2));
+			ss >> opt.skip_l;
+		}
+		else if (s.substr(0, 2) == "c=")
+		{
+			opt.skip_conf.push_back(s.substr(2));
+		}
+		else if (s.substr(0, 4) == "off=")
+		{
+			stringstream ss(s.substr(4));
+			ss >> opt.offset;
+		}
+		else if (s.substr(0, 5) == "zoom=")
+		{
+			if (!grotrian_zoom(s.substr(5), opt))
+				cout << "** could not read zoom window: " << s.substr(5) << endl;
+		}
+		else if (s.substr(0, 6) == "scale=")
+		{
+			stringstream ss(s.substr(6));
+			ss >> scale;
+		}
+		else if (s.substr(0, 2) == "u=")
+		{
+			stringstream ss(s.substr(2));
+			ss >> boolalpha >> asUnit;
+		}
+		else if (s.substr(0, 5) == "diag=")
+		{
+			stringstream ss(s.substr(5));
+			ss >> diag.max_examples;
+		}
+		else if (s.substr(0, 4) == "rej=")
+		{
+			if (!diag.open_rejects(s.substr(4)))
+				cout << "** could not open file: " << s.substr(4) << endl;
+		}
+	}
+
+	if (!(ionlimit > 0.0))
+	{
+		cout << "** ERROR: ionization limit must be > 0: " << argv[2] << endl;
+		return -1;
+	}
+
+	// one table for all outputs, lines refer to levels by index
+	atomic_data data;
+	atomic_reader reader;
+	cout << "** attempting to read source: " << source << endl;
+	if (!reader.read(source, data))
+	{
+		cout << "** ERROR: couldn't read source: " << source << endl;
+		return -1;
+	}
+	if (data.levels.empty())
+	{
+		cout << "** found no levels **" << endl;
+		return -1;
+	}
+	cout << "** " << data.levels.size() << " levels, " << data.lines.size() << " lines";
+	if (data.bad_records > 0)
+		cout << " (" << data.bad_records << " bad records skipped)";
+	cout << endl;
+
+	// TOSS line list
+	ofstream out;
+	if (!open_output(out, prefix + "_out_toss"))
+		return -1;
+	write_toss(out, data);
+	out.close();
+
+	// TOSS level file, energies rounded as in the line list
+	if (!open_output(out, prefix + "_levels"))
+		return -1;
+	vector<int> order(data.levels.size());
+	for (size_t i = 0; i < order.size(); i++)
+		order[i] = i;
+	stable_sort(order.begin(), order.end(), [&](int i, int j) { return data.levels[i].energy < data.levels[j].energy; });
+	char buf[64];
+	string last;
+	for (int i : order)
+	{
+		snprintf(buf, sizeof(buf), "%.*f ", toss_energy_digits, data.levels[i].energy);
+		string name = toss_level_name(code, data.levels[i]);
+		// toss_to_grotrian finds levels by energy and would give all lines
+		// of these levels to the first one
+		if (buf == last)
+			diag.report("levels with the same rounded energy", buf + name);
+		last = buf;
+		out << buf << name << "\n";
+	}
+	out.close();
+
+	// Grotrian diagram
+	grotrian_layout lay = build_grotrian_layout(data, ionlimit, opt, diag);
+	if (lay.levels.empty())
+	{
+		cout << "** found no levels for the Grotrian diagram **" << endl;
+	}
+	else
+	{
+		if (!open_output(out, prefix + "_grotrian"))
+			return -1;
+		write_grotrian(out, lay, source, opt);
+		out.close();
+	}
+
+	// f over lambda idents
+	vector<fplot_ident> idents = make_fplot_idents(data, diag);
+	if (!open_output(out, prefix + "_fplot"))
+		return -1;
+	write_fplot(out, idents, scale, asUnit);
+	out.close();
+
+	cout << "** Grotrian diagram: " << lay.levels.size() << " levels, " << lay.lines.size() << " lines" << endl;
+	cout << "** fplot: " << idents.size() << " idents" << endl;
+	cout << "** written to: " << prefix << "_out_toss, " << prefix << "_levels, " << prefix << "_grotrian, " << prefix << "_fplot" << endl;
+	diag.summary(cout);
+
+	return 0;
+}
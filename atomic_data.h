@@ -0,0 +1,672 @@
+//========================================================================
+// Name        : atomic_data.h
+// Author      : Michael Knoerzer
+// Version     : 1.0 (2026-10-18)
+// Copyright   : Copyright (c) 2026
+// Description : Common level/transition tables and readers for the
+//             : NIST, ADAMANT, TOSS and TMAD formats (also gzip/zstd),
+//             : header only library used by the tools
+//             : C++11 !
+//========================================================================
+#ifndef ATOMIC_DATA_H
+#define ATOMIC_DATA_H
+
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <stdexcept>
+#include <cstdint>
+#include <cstdio>
+#include <ostream>
+#include <math.h>
+#include "compressed_stream.h"
+#include "record_schema.h"
+
+// one level, energies in cm^-1 above the ground state
+struct atomic_level
+{
+	double energy;
+	double J;
+	int p;				// parity, 0 = even, 1 = odd
+	std::string config;
+	std::string term;
+	std::string name;	// identifier in the source (ADAMANT id, TMAD name, ...)
+};
+
+// one radiative transition, low/up are indices into the level table
+struct atomic_line
+{
+	int low;
+	int up;
+	double wvl;			// Angstrom
+	double loggf;
+	double gA;
+};
+
+struct atomic_data;
+
+// one transition together with its levels
+struct transition_ref
+{
+	const atomic_line& line;
+	const atomic_level& low;
+	const atomic_level& up;
+};
+
+// range over the transitions of a table:
+// for (const auto& t : data.transitions()) ... t.low.energy, t.line.wvl
+class transition_range
+{
+public:
+	class iterator
+	{
+	public:
+		iterator(const atomic_data* _data, size_t _pos): data(_data), pos(_pos) {}
+		transition_ref operator*() const;
+		iterator& operator++() { ++pos; return *this; }
+		bool operator==(const iterator& o) const { return pos == o.pos; }
+		bool operator!=(const iterator& o) const { return pos != o.pos; }
+	private:
+		const atomic_data* data;
+		size_t pos;
+	};
+
+	explicit transition_range(const atomic_data* _data): data(_data) {}
+	iterator begin() const { return iterator(data, 0); }
+	iterator end() const;
+	size_t size() const;
+
+private:
+	const atomic_data* data;
+};
+
+// level/line table of one ion from one source
+struct atomic_data
+{
+	std::string source;
+	double ionlimit = 0.0;	// cm^-1, 0 if the source does not know it
+	int bad_records = 0;	// records that could not be read
+	bool J_truncated = false;	// only the integer part of J is known (TOSS level names)
+	std::vector<atomic_level> levels;
+	std::vector<atomic_line> lines;
+
+	transition_range transitions() const { return transition_range(this); }
+
+	// empty table, the memory of the vectors is kept for the next read
+	void clear()
+	{
+		source.clear();
+		ionlimit = 0.0;
+		bad_records = 0;
+		J_truncated = false;
+		levels.clear();
+		lines.clear();
+	}
+
+	void reserve(size_t n_levels, size_t n_lines)
+	{
+		levels.reserve(n_levels);
+		lines.reserve(n_lines);
+	}
+};
+
+inline transition_ref transition_range::iterator::operator*() const
+{
+	const atomic_line& t = data->lines[pos];
+	return transition_ref { t, data->levels[t.low], data->levels[t.up] };
+}
+
+inline transition_range::iterator transition_range::end() const
+{
+	return iterator(data, data->lines.size());
+}
+
+inline size_t transition_range::size() const
+{
+	return data->lines.size();
+}
+
+// constants used by all converters
+const double c_light = 2.99792458e10;	// cm/s
+const double gf_to_gA = 1.49919E-16;	// f = gA * 1.49919E-16 * wvl^2 / g_low
+
+// key for levels that are only known by energy, J and parity
+// (NIST and TOSS line lists); energy is kept to 1/1000 cm^-1
+inline uint64_t level_key(double energy, double J, int p)
+{
+	uint64_t e = (uint64_t)llround(energy * 1000.0);
+	uint64_t j = (uint64_t)llround(J * 2.0);
+	return (e << 9) ^ (j << 1) ^ (uint64_t)(p & 1);
+}
+
+// level table with lookup by energy/J/parity, used while reading line lists
+struct level_index
+{
+	std::unordered_map<uint64_t, int> map;
+
+	int get(atomic_data& data, const atomic_level& lev)
+	{
+		uint64_t key = level_key(lev.energy, lev.J, lev.p);
+		auto it = map.find(key);
+		if (it != map.end())
+			return it->second;
+		int idx = data.levels.size();
+		data.levels.push_back(lev);
+		map.emplace(key, idx);
+		return idx;
+	}
+};
+
+// J given as "3/2" or "1.5"
+inline double parse_J(const std::string& s)
+{
+	std::size_t found = s.find('/');
+	if (found != std::string::npos)
+		return std::stof(s.substr(0, found)) / std::stof(s.substr(found + 1));
+	return std::stof(s);
+}
+
+// parity from a string like "o", "e", "(o)", "odd"
+inline int parse_parity(const std::string& s)
+{
+	for (char c : s)
+	{
+		if (c == 'o' || c == 'O' || c == '*' || c == '-')
+			return 1;
+		if (c == 'e' || c == 'E' || c == '+')
+			return 0;
+	}
+	return 0;
+}
+
+// finish a transition read from a line list: make sure low is the lower level
+inline void add_line(atomic_data& data, level_index& idx, atomic_level low, atomic_level up, double wvl, double loggf, double gA)
+{
+	if (low.energy > up.energy)
+		std::swap(low, up);
+	atomic_line t;
+	t.low = idx.get(data, low);
+	t.up = idx.get(data, up);
+	t.wvl = wvl;
+	t.loggf = loggf;
+	t.gA = gA;
+	data.lines.push_back(t);
+}
+
+//------------------------------------------------------------------------
+// NIST ASD pipe formatted table (same fields as nist_to_toss)
+//------------------------------------------------------------------------
+inline bool read_nist(const std::string& file, atomic_data& data)
+{
+	cifstream in(file);
+	if (!in.is_open())
+		return false;
+
+	level_index idx;
+	std::string line;
+	while (getline(in, line))
+	{
+		int bars = 0;
+		int energies = 0;
+		atomic_level l_low, l_up;
+		double wvl = 0.0, gA = 0.0, loggf = 0.0;
+		std::string tmp;
+		std::stringstream ss(line);
+		l_low.p = l_up.p = 0;
+		l_low.energy = l_up.energy = 0.0;
+
+		while (ss >> tmp)
+		{
+			// skip ---------
+			if (tmp.size() > 10 && "-----" == tmp.substr(1, 5))
+				break;
+
+			if ("|" == tmp)
+			{
+				bars++;
+				continue;
+			}
+
+			try
+			{
+				switch (bars)
+				{
+				case 0:
+					wvl = std::stof(tmp);
+					break;
+				case 5:
+					gA = std::stof(tmp);
+					break;
+				case 6:
+					loggf = std::stof(tmp);
+					break;
+				case 8:
+					// "Ei - Ek", the dash is no number
+					try
+					{
+						double d = std::stof(tmp);
+						if (0 == energies)
+							l_low.energy = d;
+						else if (1 == energies)
+							l_up.energy = d;
+						else
+							bars = 99;
+						energies++;
+					}
+					catch (std::invalid_argument const&)
+					{
+					}
+					break;
+				case 9:
+					tmp.erase(std::remove(tmp.begin(), tmp.end(), '?'), tmp.end());
+					l_low.config = tmp;
+					break;
+				case 10:
+					l_low.term = tmp;
+					l_low.p = (tmp.find('*') != std::string::npos) ? 1 : 0;
+					break;
+				case 11:
+					l_low.J = parse_J(tmp);
+					l_low.name = l_low.config + "_" + l_low.term;
+					break;
+				case 12:
+					tmp.erase(std::remove(tmp.begin(), tmp.end(), '?'), tmp.end());
+					l_up.config = tmp;
+					break;
+				case 13:
+					l_up.term = tmp;
+					l_up.p = (tmp.find('*') != std::string::npos) ? 1 : 0;
+					break;
+				case 14:
+					l_up.J = parse_J(tmp);
+					l_up.name = l_up.config + "_" + l_up.term;
+					bars = 50;
+					break;
+				default:
+					break;
+				}
+			}
+			catch (std::exception const&)
+			{
+				// bad line, skip
+				bars = 99;
+			}
+
+			if (50 == bars)
+			{
+				add_line(data, idx, l_low, l_up, wvl, loggf, gA);
+				break;
+			}
+			if (99 == bars)
+			{
+				data.bad_records++;
+				break;
+			}
+		}
+	}
+	return true;
+}
+
+//------------------------------------------------------------------------
+// ADAMANT level + line files (same fields as adamant_to_toss)
+//------------------------------------------------------------------------
+inline bool read_adamant(const std::string& level_file, const std::string& line_file, atomic_data& data)
+{
+	cifstream in(level_file);
+	if (!in.is_open())
+		return false;
+
+	std::unordered_map<int, int> ids;
+	std::string line;
+	while (getline(in, line))
+	{
+		std::stringstream s(line);
+		int id;
+		std::string P, conf;
+		atomic_level lev;
+		if (!(s >> id >> lev.energy >> lev.J >> P >> conf >> conf))
+			continue;
+		lev.p = parse_parity(P);
+		lev.config = conf;
+		lev.name = std::to_string(id);
+		ids[id] = data.levels.size();
+		data.levels.push_back(lev);
+	}
+	in.close();
+
+	// levels only
+	if (line_file.empty())
+		return true;
+	in.open(line_file.c_str());
+	if (!in.is_open())
+		return false;
+	while (getline(in, line))
+	{
+		std::stringstream s(line);
+		int id_low, id_up;
+		std::string s1;
+		double wvl, gf, A;
+		if (!(s >> id_low >> s1 >> id_up >> s1 >> s1 >> wvl >> A >> gf))
+			continue;
+
+		auto lo = ids.find(id_low);
+		auto hi = ids.find(id_up);
+		if (lo == ids.end() || hi == ids.end())
+		{
+			data.bad_records++;
+			continue;
+		}
+		atomic_line t;
+		t.low = lo->second;
+		t.up = hi->second;
+		if (data.levels[t.low].energy > data.levels[t.up].energy)
+			std::swap(t.low, t.up);
+		t.wvl = wvl;
+		t.loggf = log10(gf);
+		t.gA = A * (2 * data.levels[t.up].J + 1);
+		data.lines.push_back(t);
+	}
+	return true;
+}
+
+//------------------------------------------------------------------------
+// TOSS line list as written by nist_to_toss / adamant_to_toss
+//------------------------------------------------------------------------
+inline bool read_toss(const std::string& file, atomic_data& data)
+{
+	cifstream in(file);
+	if (!in.is_open())
+		return false;
+
+	level_index idx;
+	std::string line;
+	while (getline(in, line))
+	{
+		std::stringstream ss(line);
+		atomic_level l_low, l_up;
+		std::string p_low, p_up;
+		double wvl, loggf, gA;
+		if (!(ss >> wvl >> l_low.energy >> p_low >> l_low.J >> l_up.energy >> p_up >> l_up.J >> loggf >> gA))
+			continue;
+		l_low.p = parse_parity(p_low);
+		l_up.p = parse_parity(p_up);
+		add_line(data, idx, l_low, l_up, wvl, loggf, gA);
+	}
+	return true;
+}
+
+// header of a TOSS line list, cf: with the CF column of nist_to_toss
+inline void write_toss_header(std::ostream& out, bool cf = true)
+{
+	out << std::endl << "  Wavelength         Lower Level         Upper Level   log gf        gA" << (cf ? "       CF" : "") << std::endl << std::endl;
+}
+
+// decimals of the level energies in TOSS files; toss_to_grotrian finds the
+// levels of a line by exact energy, so a level file written for a line
+// list has to round the same way
+const int toss_energy_digits = 1;
+
+// one line in the layout of nist_to_toss/adamant_to_toss into buf,
+// returns the number of characters (without the trailing 0)
+inline int format_toss_line(char* buf, size_t size, const atomic_level& low, const atomic_level& up, double wvl, double loggf, double gA, bool cf = true)
+{
+	return snprintf(buf, size, "%12.3f %10.*f (%c) %4.1f %10.*f (%c) %4.1f  %7.3f %.3e%s\n",
+		wvl, toss_energy_digits, low.energy, low.p ? 'o' : 'e', low.J, toss_energy_digits, up.energy, up.p ? 'o' : 'e', up.J, loggf, gA, cf ? "    0.000" : "");
+}
+
+inline void write_toss(std::ostream& out, const atomic_data& data, bool cf = true)
+{
+	char buf[256];
+	write_toss_header(out, cf);
+	for (const auto& t : data.lines)
+	{
+		int n = format_toss_line(buf, sizeof(buf), data.levels[t.low], data.levels[t.up], t.wvl, t.loggf, t.gA, cf);
+		out.write(buf, std::min(n, (int)sizeof(buf) - 1));
+	}
+}
+
+//------------------------------------------------------------------------
+// TOSS level file (A10 names) as read by toss_to_grotrian
+// the name has one character for J, its integer part: J = 3/2 is read as
+// 1, so g = 2J+1 is wrong for all levels of an odd electron ion
+//------------------------------------------------------------------------
+inline bool read_toss_levels(const std::string& file, atomic_data& data)
+{
+	cifstream in(file);
+	if (!in.is_open())
+		return false;
+	data.J_truncated = true;
+
+	std::string line;
+	while (getline(in, line))
+	{
+		atomic_level lev;
+		std::stringstream ss(line);
+		if (!(ss >> lev.energy))
+			continue;
+		std::string rest;
+		getline(ss, rest);
+		rest.erase(0, rest.find_first_not_of(" \t"));
+		rest.erase(rest.find_last_not_of(" \t\r") + 1);
+		if (rest.size() < toss_level_record::term::end)
+		{
+			data.bad_records++;
+			continue;
+		}
+		lev.name = rest;
+		lev.config = toss_level_record::conf::get(rest).str();
+		std::transform(lev.config.begin(), lev.config.end(), lev.config.begin(), ::tolower);
+		lev.term = toss_level_record::term::get(rest).str();
+		std::transform(lev.term.begin(), lev.term.end(), lev.term.begin(), ::toupper);
+		int j;
+		parse_int(toss_level_record::j::get(rest), j);
+		lev.J = j;
+		text_view p = toss_level_record::parity::get(rest);
+		lev.p = (p == "O" || p == "o") ? 1 : 0;
+		data.levels.push_back(lev);
+	}
+	return true;
+}
+
+//------------------------------------------------------------------------
+// TMAD model atom, L/LTE and RBB sections (same fields as tmad_to_grotrian)
+//------------------------------------------------------------------------
+inline bool read_tmad(const std::string& file, atomic_data& data)
+{
+	cifstream in(file);
+	if (!in.is_open())
+		return false;
+
+	enum { SEARCH_ATOM, READ_ATOM, SEARCH_CONTENT, READ_LEVELS, READ_RBB } s = SEARCH_ATOM;
+	std::unordered_map<std::string, int> names;
+	std::vector<double> ion_energy;
+	int alen = 3;
+	std::string line;
+	while (getline(in, line))
+	{
+		// skip comments
+		if (line.substr(0, 1) == ".")
+			continue;
+
+		std::stringstream ss(line);
+		switch (s)
+		{
+		case SEARCH_ATOM:
+			if (line.substr(0, 4) == "ATOM")
+				s = READ_ATOM;
+			break;
+
+		case READ_ATOM:
+		{
+			std::string atom;
+			int charge = 0;
+			ss >> atom >> charge;
+			alen = (atom.size() == 2) ? 3 : (int)(atom + std::to_string(charge + 1)).size();
+			s = SEARCH_CONTENT;
+			break;
+		}
+
+		case SEARCH_CONTENT:
+			if (line == "L" || line == "LTE")
+				s = READ_LEVELS;
+			else if (line == "RBB")
+				s = READ_RBB;
+			break;
+
+		case READ_LEVELS:
+		{
+			if (line == "0")
+			{
+				s = SEARCH_CONTENT;
+				break;
+			}
+			if (line.size() < tmad_level_record::frequency::pos)
+			{
+				data.bad_records++;
+				break;
+			}
+			atomic_level lev;
+			double eHz, g;
+			lev.name = tmad_level_record::name::get(line).str();
+			lev.config = parse_word(tmad_level_record::code_conf::get(line).sub(alen)).str();
+			lev.term = parse_word(tmad_level_record::term::get(line)).str();
+			lev.p = (lev.term.size() == 3) ? 1 : 0;
+			if (lev.term.size() == 3)
+				lev.term.resize(2);
+			ss.str(tmad_level_record::frequency::rest(line).str());
+			ss.clear();
+			if (!(ss >> eHz >> g))
+			{
+				data.bad_records++;
+				break;
+			}
+			lev.J = (g - 1) / 2;
+			// ground state should be the first level
+			if (data.levels.empty())
+				data.ionlimit = eHz / c_light;
+			lev.energy = data.ionlimit - eHz / c_light;
+			names[lev.name] = data.levels.size();
+			data.levels.push_back(lev);
+			break;
+		}
+
+		case READ_RBB:
+		{
+			if (line == "0")
+			{
+				s = SEARCH_CONTENT;
+				break;
+			}
+			if (line.size() < tmad_rbb_record::form::pos)
+			{
+				data.bad_records++;
+				break;
+			}
+			auto lo = names.find(tmad_rbb_record::low::get(line).str());
+			auto hi = names.find(tmad_rbb_record::up::get(line).str());
+			if (lo == names.end() || hi == names.end())
+			{
+				data.bad_records++;
+				break;
+			}
+			atomic_line t;
+			t.low = lo->second;
+			t.up = hi->second;
+			if (data.levels[t.low].energy > data.levels[t.up].energy)
+				std::swap(t.low, t.up);
+			double f = 0.0;
+			ss.str(tmad_rbb_record::form::rest(line).str());
+			ss.clear();
+			// should be like " 3 3 f_ik"
+			ss >> f >> f >> f;
+			const atomic_level& low = data.levels[t.low];
+			t.wvl = 1.0e8 / (data.levels[t.up].energy - low.energy);
+			double gf = (2 * low.J + 1) * f;
+			t.loggf = log10(gf);
+			t.gA = gf / gf_to_gA / t.wvl / t.wvl;
+			data.lines.push_back(t);
+			break;
+		}
+		}
+	}
+	return true;
+}
+
+//------------------------------------------------------------------------
+// read any source given as <format>:<file>[,<file>]
+// nist:<file>, adamant:<levels>[,<lines>], toss:<file>, tosslev:<file>,
+// tmad:<file>
+//------------------------------------------------------------------------
+inline bool read_source(const std::string& spec, atomic_data& data)
+{
+	data.source = spec;
+	auto pos = spec.find(':');
+	if (pos == std::string::npos)
+		return false;
+	std::string format = spec.substr(0, pos);
+	std::string files = spec.substr(pos + 1);
+
+	if (format == "nist")
+		return read_nist(files, data);
+	if (format == "toss")
+		return read_toss(files, data);
+	if (format == "tosslev")
+		return read_toss_levels(files, data);
+	if (format == "tmad")
+		return read_tmad(files, data);
+	if (format == "adamant")
+	{
+		auto comma = files.find(',');
+		if (comma == std::string::npos)
+			return read_adamant(files, "", data);
+		return read_adamant(files.substr(0, comma), files.substr(comma + 1), data);
+	}
+
+	return false;
+}
+
+// options of atomic_reader
+struct read_options
+{
+	bool levels_only = false;	// transitions are not needed
+	size_t reserve_levels = 0;	// expected table size, saves reallocations
+	size_t reserve_lines = 0;	// while reading large files
+};
+
+//------------------------------------------------------------------------
+// reader for programs converting many ions in one process: the readers
+// have no global state, so one instance per thread can read in parallel;
+// the table is cleared but keeps its memory, reading ion after ion into
+// the same table allocates only for the strings
+//------------------------------------------------------------------------
+class atomic_reader
+{
+public:
+	explicit atomic_reader(const read_options& _opt = read_options()): opt(_opt) {}
+
+	const read_options& options() const { return opt; }
+
+	bool read(const std::string& spec, atomic_data& data) const
+	{
+		data.clear();
+		data.reserve(opt.reserve_levels, opt.reserve_lines);
+		std::string s = spec;
+		// ADAMANT: the level file alone is enough
+		if (opt.levels_only && s.substr(0, 8) == "adamant:")
+			s = s.substr(0, s.find(','));
+		if (!read_source(s, data))
+			return false;
+		data.source = spec;
+		if (opt.levels_only)
+			data.lines.clear();
+		return true;
+	}
+
+private:
+	read_options opt;
+};
+
+#endif
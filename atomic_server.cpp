@@ -0,0 +1,453 @@
+//========================================================================
+// Name        : atomic_server.cpp
+// Author      : Michael Knoerzer
+// Version     : 1.0 (2026-10-18)
+// Copyright   : Copyright (c) 2026
+// Description : Local server: keeps the level/line tables of many ions
+//             : in memory and answers Grotrian, fplot and line queries
+//             : on a Unix domain socket, one thread per connection;
+//             : the socket is only open for the user running the server
+//             : compile with -pthread
+//             : C++11 !
+//========================================================================
+
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <future>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include <csignal>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/stat.h>
+#include "atomic_data.h"
+#include "diagnostics.h"
+#include "grotrian_layout.h"
+#include "fplot_idents.h"
+using namespace std;
+
+// one ion as kept in memory, never changed after loading
+struct ion_entry
+{
+	atomic_data data;
+	vector<fplot_ident> idents;		// sorted by wavelength
+	vector<int> by_wvl;				// line indices sorted by wavelength
+	diagnostics diag;				// messages while preparing the idents
+	double load_ms = 0.0;
+};
+
+typedef shared_ptr<const ion_entry> ion_ptr;
+
+//------------------------------------------------------------------------
+// ion cache: a source is parsed once, concurrent requests for the same
+// source wait for the same load instead of parsing it again
+//------------------------------------------------------------------------
+class ion_cache
+{
+public:
+	ion_ptr get(const string& source)
+	{
+		shared_future<ion_ptr> f;
+		bool load = false;
+		{
+			lock_guard<mutex> lock(m);
+			auto it = ions.find(source);
+			if (it == ions.end())
+			{
+				promise<ion_ptr> p;
+				f = p.get_future().share();
+				ions[source] = f;
+				pending[source] = std::move(p);
+				load = true;
+			}
+			else
+				f = it->second;
+		}
+		if (load)
+		{
+			// an exception (i.e. bad_alloc) is a failed load, the waiting
+			// requests have to get an answer
+			ion_ptr ion;
+			try
+			{
+				ion = read(source);
+			}
+			catch (...)
+			{
+				ion = nullptr;
+			}
+			lock_guard<mutex> lock(m);
+			// failed loads are not kept, the next request tries again
+			if (!ion)
+				ions.erase(source);
+			pending[source].set_value(ion);
+			pending.erase(source);
+		}
+		return f.get();
+	}
+
+	bool drop(const string& source)
+	{
+		lock_guard<mutex> lock(m);
+		return pending.count(source) == 0 && ions.erase(source) > 0;
+	}
+
+	// loaded sources with their sizes
+	string list()
+	{
+		vector<pair<string, shared_future<ion_ptr>>> all;
+		{
+			lock_guard<mutex> lock(m);
+			for (const auto& i : ions)
+			{
+				if (pending.count(i.first) == 0)
+					all.push_back(i);
+			}
+		}
+		stringstream ss;
+		ss << fixed << setprecision(1);
+		for (const auto& i : all)
+		{
+			ion_ptr ion = i.second.get();
+			ss << i.first << " levels=" << ion->data.levels.size() << " lines=" << ion->data.lines.size() << " load_ms=" << ion->load_ms << "\n";
+		}
+		return ss.str();
+	}
+
+private:
+	static ion_ptr read(const string& source)
+	{
+		auto t0 = chrono::steady_clock::now();
+		shared_ptr<ion_entry> ion = make_shared<ion_entry>();
+		atomic_reader reader;
+		if (!reader.read(source, ion->data) || ion->data.levels.empty())
+			return ion_ptr();
+		ion->idents = make_fplot_idents(ion->data, ion->diag);
+		ion->by_wvl.resize(ion->data.lines.size());
+		for (size_t i = 0; i < ion->by_wvl.size(); i++)
+			ion->by_wvl[i] = i;
+		const auto& lines = ion->data.lines;
+		stable_sort(ion->by_wvl.begin(), ion->by_wvl.end(), [&](int i, int j) { return lines[i].wvl < lines[j].wvl; });
+		ion->load_ms = chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+		return ion;
+	}
+
+	mutex m;
+	map<string, shared_future<ion_ptr>> ions;
+	map<string, promise<ion_ptr>> pending;
+};
+
+// key=value arguments of a request
+struct request_args
+{
+	grotrian_options opt;
+	double ionlimit = 0.0;
+	double wmin = 0.0;
+	double wmax = 9.9e+30;
+	double scale = 1.0;
+	bool asUnit = false;
+	string error;
+};
+
+request_args parse_args(const vector<string>& words, size_t first)
+{
+	request_args a;
+	for (size_t i = first; i < words.size(); i++)
+	{
+		const string& s = words[i];
+		auto eq = s.find('=');
+		if (eq == string::npos)
+		{
+			a.error = "expected key=value: " + s;
+			break;
+		}
+		string key = s.substr(0, eq);
+		stringstream ss(s.substr(eq + 1));
+		bool ok = true;
+		if (key == "ion")
+			ok = (bool)(ss >> a.ionlimit);
+		else if (key == "e")
+			ok = (bool)(ss >> a.opt.skip_e);
+		else if (key == "n")
+			ok = (bool)(ss >> a.opt.skip_n);
+		else if (key == "l")
+			ok = (bool)(ss >> a.opt.skip_l);
+		else if (key == "c")
+			a.opt.skip_conf.push_back(ss.str());
+		else if (key == "off")
+			ok = (bool)(ss >> a.opt.offset);
+		else if (key == "zoom")
+			ok = grotrian_zoom(ss.str(), a.opt);
+		else if (key == "wmin")
+			ok = (bool)(ss >> a.wmin);
+		else if (key == "wmax")
+			ok = (bool)(ss >> a.wmax);
+		else if (key == "scale")
+			ok = (bool)(ss >> a.scale);
+		else if (key == "u")
+			ok = (bool)(ss >> boolalpha >> a.asUnit);
+		else
+			ok = false;
+		if (!ok)
+		{
+			a.error = "bad argument: " + s;
+			break;
+		}
+	}
+	return a;
+}
+
+//------------------------------------------------------------------------
+// one request line -> answer; false if the answer is an error
+//------------------------------------------------------------------------
+bool handle_request(ion_cache& cache, const string& request, string& answer)
+{
+	vector<string> words;
+	stringstream ws(request);
+	string w;
+	while (ws >> w)
+		words.push_back(w);
+	if (words.empty())
+	{
+		answer = "empty request";
+		return false;
+	}
+	const string& cmd = words[0];
+
+	if (cmd == "list")
+	{
+		answer = cache.list();
+		return true;
+	}
+	if (words.size() < 2)
+	{
+		answer = "missing source";
+		return false;
+	}
+	const string& source = words[1];
+	if (cmd == "drop")
+	{
+		if (!cache.drop(source))
+		{
+			answer = "not loaded: " + source;
+			return false;
+		}
+		answer = "";
+		return true;
+	}
+
+	if (cmd != "load" && cmd != "grotrian" && cmd != "fplot" && cmd != "lines")
+	{
+		answer = "unknown command: " + cmd;
+		return false;
+	}
+	request_args a = parse_args(words, 2);
+	if (!a.error.empty())
+	{
+		answer = a.error;
+		return false;
+	}
+	ion_ptr ion = cache.get(source);
+	if (!ion)
+	{
+		answer = "couldn't read source: " + source;
+		return false;
+	}
+	const atomic_data& data = ion->data;
+	stringstream out;
+
+	if (cmd == "load")
+	{
+		out << "levels=" << data.levels.size() << " lines=" << data.lines.size() << " bad=" << data.bad_records << "\n";
+	}
+	else if (cmd == "grotrian")
+	{
+		// Grotrian diagram with the given cuts, as toss_to_grotrian
+		double ionlimit = a.ionlimit > 0.0 ? a.ionlimit : data.ionlimit;
+		if (ionlimit <= 0.0)
+		{
+			answer = "no ionization limit, use ion=<cm^-1>";
+			return false;
+		}
+		diagnostics diag;
+		grotrian_layout lay = build_grotrian_layout(data, ionlimit, a.opt, diag);
+		if (lay.levels.empty())
+		{
+			answer = "found no levels";
+			return false;
+		}
+		write_grotrian(out, lay, source, a.opt);
+		diag.summary(out);
+	}
+	else if (cmd == "fplot")
+	{
+		// idents in the wavelength window, as toss_to_fplot
+		fplot_ident lo, hi;
+		lo.wvl = a.wmin;
+		lo.f = -9.9e+30;
+		hi.wvl = a.wmax;
+		hi.f = 9.9e+30;
+		auto first = lower_bound(ion->idents.begin(), ion->idents.end(), lo);
+		auto last = upper_bound(first, ion->idents.end(), hi);
+		write_fplot(out, first, last, a.scale, a.asUnit);
+	}
+	else
+	{
+		// TOSS lines in the wavelength window
+		const auto& lines = data.lines;
+		auto first = lower_bound(ion->by_wvl.begin(), ion->by_wvl.end(), a.wmin, [&](int i, double w) { return lines[i].wvl < w; });
+		auto last = upper_bound(first, ion->by_wvl.end(), a.wmax, [&](double w, int i) { return w < lines[i].wvl; });
+		char buf[256];
+		for (; first != last; ++first)
+		{
+			const atomic_line& t = lines[*first];
+			int n = format_toss_line(buf, sizeof(buf), data.levels[t.low], data.levels[t.up], t.wvl, t.loggf, t.gA);
+			out.write(buf, min(n, (int)sizeof(buf) - 1));
+		}
+	}
+	answer = out.str();
+	return true;
+}
+
+//------------------------------------------------------------------------
+// connection: request lines in, "OK <bytes>\n<answer>" or "ERR <text>\n"
+// out, until the client closes the socket; a request longer than
+// max_request is answered with ERR and the connection is closed
+//------------------------------------------------------------------------
+const size_t max_request = 1 << 16;
+
+bool send_all(int fd, const string& s)
+{
+	size_t done = 0;
+	while (done < s.size())
+	{
+		ssize_t n = send(fd, s.data() + done, s.size() - done, MSG_NOSIGNAL);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n <= 0)
+			return false;
+		done += n;
+	}
+	return true;
+}
+
+void serve_connection(int fd, ion_cache& cache)
+{
+	string buffer;
+	char chunk[4096];
+	bool open = true;
+	while (open)
+	{
+		ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n <= 0)
+			break;
+		buffer.append(chunk, n);
+		size_t nl;
+		while (open && (nl = buffer.find('\n')) != string::npos)
+		{
+			string request = buffer.substr(0, nl);
+			buffer.erase(0, nl + 1);
+			if (!request.empty() && request.back() == '\r')
+				request.pop_back();
+			if (request == "quit")
+			{
+				open = false;
+				break;
+			}
+			string answer;
+			bool ok = handle_request(cache, request, answer);
+			if (ok)
+				open = send_all(fd, "OK " + to_string(answer.size()) + "\n" + answer);
+			else
+				open = send_all(fd, "ERR " + answer + "\n");
+		}
+		if (open && buffer.size() > max_request)
+		{
+			send_all(fd, "ERR request longer than " + to_string(max_request) + " bytes\n");
+			open = false;
+		}
+	}
+	close(fd);
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc < 2)
+	{
+		cout << "\nUsage: atomic_server <socket> <options>\n";
+		cout << "\nOptions: load=<source> (several allowed)\n";
+		cout << "load:  read these sources before the first connection\n";
+		cout << "\nRequests, one per line, sources as in toss_to_tmad (nist:<file>, ...):\n";
+		cout << "  load <source>                      read and keep the source\n";
+		cout << "  grotrian <source> [ion= e= n= l= c= off= zoom=]   WRPLOT input as toss_to_grotrian\n";
+		cout << "  fplot <source> [wmin= wmax= scale= u=]      idents as toss_to_fplot\n";
+		cout << "  lines <source> [wmin= wmax=]       TOSS lines in the wavelength window\n";
+		cout << "  drop <source>, list, quit\n";
+		cout << "Answers: \"OK <bytes>\" + answer or \"ERR <message>\"\n";
+		cout << "The socket is created with mode 0600, only the same user can connect" << endl;
+		return 0;
+	}
+
+	string path = argv[1];
+	ion_cache cache;
+	for (int i = 2; i < argc; i++)
+	{
+		string s(argv[i]);
+		if (s.substr(0, 5) == "load=")
+		{
+			cout << "** loading: " << s.substr(5) << (cache.get(s.substr(5)) ? "" : " ** ERROR: couldn't read source") << endl;
+		}
+	}
+
+	int server = socket(AF_UNIX, SOCK_STREAM, 0);
+	sockaddr_un addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	if (server < 0 || path.size() >= sizeof(addr.sun_path))
+	{
+		cout << "** ERROR: couldn't create socket: " << path << endl;
+		return -1;
+	}
+	strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+	unlink(path.c_str());
+	// only the owner may connect: the server opens any file it can read
+	// on request, the socket must not give that to other users
+	mode_t old_mask = umask(0177);
+	int bound = bind(server, (sockaddr*)&addr, sizeof(addr));
+	umask(old_mask);
+	if (bound != 0 || listen(server, 64) != 0)
+	{
+		cout << "** ERROR: couldn't listen on: " << path << " (" << strerror(errno) << ")" << endl;
+		return -1;
+	}
+	signal(SIGPIPE, SIG_IGN);
+	cout << "** listening on: " << path << endl;
+
+	while (true)
+	{
+		int fd = accept(server, NULL, NULL);
+		if (fd < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			cout << "** ERROR: accept failed (" << strerror(errno) << ")" << endl;
+			break;
+		}
+		thread(serve_connection, fd, std::ref(cache)).detach();
+	}
+	close(server);
+	unlink(path.c_str());
+	return 0;
+}
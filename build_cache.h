@@ -0,0 +1,357 @@
+//========================================================================
+// Name        : build_cache.h
+// Author      : Michael Knoerzer
+// Version     : 1.0 (2026-10-18)
+// Copyright   : Copyright (c) 2026
+// Description : Build cache for the tools (cache=<dir>): a run is keyed
+//             : by an FNV-1a hash of the tool, its options and the
+//             : content of its input files; printed output and written
+//             : files are stored content addressed in <dir>/objects, a
+//             : later run with the same key only copies them back.
+//             : Intermediate results (i.e. Grotrian layouts) can be
+//             : stored under keys of their own
+//             : C++11 !
+//========================================================================
+#ifndef BUILD_CACHE_H
+#define BUILD_CACHE_H
+
+#include <string>
+#include <vector>
+#include <sstream>
+#include <fstream>
+#include <ostream>
+#include <streambuf>
+#include <cstdio>
+#include <cstdint>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <atomic>
+#ifdef _WIN32
+#include <direct.h>
+#include <process.h>
+#define getpid _getpid
+#else
+#include <unistd.h>
+#endif
+#include "diagnostics.h"
+
+// 64 bit FNV-1a over everything added
+struct build_hash
+{
+	uint64_t h = 14695981039346656037ULL;
+
+	void add(const char* p, size_t n)
+	{
+		for (size_t i = 0; i < n; i++)
+		{
+			h ^= (unsigned char)p[i];
+			h *= 1099511628211ULL;
+		}
+	}
+
+	// with its length, so "ab","c" and "a","bc" differ
+	void add(const std::string& s)
+	{
+		std::string len = std::to_string(s.size()) + ":";
+		add(len.data(), len.size());
+		add(s.data(), s.size());
+	}
+
+	// content of a file; a missing file is a value of its own, false
+	bool add_file(const std::string& file)
+	{
+		FILE* f = fopen(file.c_str(), "rb");
+		if (!f)
+		{
+			add("<missing>");
+			return false;
+		}
+		std::vector<char> buf(1 << 16);
+		size_t n, total = 0;
+		while ((n = fread(&buf[0], 1, buf.size(), f)) > 0)
+		{
+			add(&buf[0], n);
+			total += n;
+		}
+		fclose(f);
+		add(std::to_string(total));
+		return true;
+	}
+
+	std::string hex() const
+	{
+		char s[17];
+		snprintf(s, sizeof(s), "%016llx", (unsigned long long)h);
+		return s;
+	}
+};
+
+inline std::string build_hash_of(const std::string& data)
+{
+	build_hash h;
+	h.add(data);
+	return h.hex();
+}
+
+// key of a whole run: tool (and its build), options and the content of
+// the input files; cache= and threads= do not change the output
+inline std::string build_run_key(const std::string& tool, const std::vector<std::string>& args, const std::vector<std::string>& inputs)
+{
+	build_hash h;
+	h.add(tool);
+	for (const auto& a : args)
+	{
+		if (a.substr(0, 6) != "cache=" && a.substr(0, 8) != "threads=")
+			h.add(a);
+	}
+	for (const auto& f : inputs)
+		h.add_file(f);
+	return h.hex();
+}
+
+//------------------------------------------------------------------------
+// copy of everything written to a stream (i.e. cout), the stream itself
+// still gets it; the old buffer is back after the destructor
+//------------------------------------------------------------------------
+class output_capture : public std::streambuf
+{
+public:
+	output_capture(std::ostream& os) : os(os), old(os.rdbuf())
+	{
+		os.rdbuf(this);
+	}
+	~output_capture()
+	{
+		os.rdbuf(old);
+	}
+
+	const std::string& text() const { return captured; }
+
+protected:
+	int overflow(int c) override
+	{
+		if (c == EOF)
+			return 0;
+		captured += (char)c;
+		return old->sputc((char)c);
+	}
+	std::streamsize xsputn(const char* s, std::streamsize n) override
+	{
+		captured.append(s, n);
+		return old->sputn(s, n);
+	}
+	int sync() override
+	{
+		return old->pubsync();
+	}
+
+private:
+	std::ostream& os;
+	std::streambuf* old;
+	std::string captured;
+};
+
+//------------------------------------------------------------------------
+// <dir>/<key>.run      manifest of a run: "text <object>" for the printed
+//                      output, "file <object> <name>" per written file
+// <dir>/<key>.val      any other value stored by key
+// <dir>/objects/<hash>[-<n>] the contents, named by their own hash
+// everything is written to a temporary name and renamed, so a cache
+// shared by several runs never has half written entries
+//------------------------------------------------------------------------
+class build_cache
+{
+public:
+	bool open(const std::string& directory)
+	{
+		dir = directory;
+		make_dir(dir);
+		make_dir(dir + "/objects");
+		struct stat st;
+		return stat((dir + "/objects").c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+	}
+
+	bool is_open() const { return !dir.empty(); }
+
+	// printed output to out and the files of the run back in place;
+	// false (nothing written) if the key or one of its objects is missing
+	bool restore(const std::string& key, std::ostream& out) const
+	{
+		std::string manifest, text;
+		if (!read_file(dir + "/" + key + ".run", manifest))
+			return false;
+		std::vector<std::pair<std::string, std::string>> files;
+		std::stringstream ss(manifest);
+		std::string kind, object;
+		bool has_text = false;
+		while (ss >> kind >> object)
+		{
+			std::string data;
+			if (!read_file(object_file(object), data))
+				return false;
+			if (kind == "text")
+			{
+				text = data;
+				has_text = true;
+				continue;
+			}
+			std::string name;
+			ss.get();
+			getline(ss, name);
+			files.push_back(std::make_pair(name, data));
+		}
+		if (!has_text)
+			return false;
+		for (const auto& f : files)
+		{
+			if (!write_file(f.first, f.second))
+				return false;
+		}
+		out << text;
+		return true;
+	}
+
+	// printed output and written files of a successful run
+	bool store(const std::string& key, const std::string& text, const std::vector<std::string>& files) const
+	{
+		std::stringstream manifest;
+		std::string object;
+		if (!put_object(text, object))
+			return false;
+		manifest << "text " << object << "\n";
+		for (const auto& f : files)
+		{
+			std::string data;
+			if (!read_file(f, data) || !put_object(data, object))
+				return false;
+			manifest << "file " << object << " " << f << "\n";
+		}
+		return write_file(dir + "/" + key + ".run", manifest.str());
+	}
+
+	bool get(const std::string& key, std::string& data) const
+	{
+		return read_file(dir + "/" + key + ".val", data);
+	}
+
+	bool put(const std::string& key, const std::string& data) const
+	{
+		return write_file(dir + "/" + key + ".val", data);
+	}
+
+private:
+	static void make_dir(const std::string& d)
+	{
+#ifdef _WIN32
+		_mkdir(d.c_str());
+#else
+		mkdir(d.c_str(), 0777);
+#endif
+	}
+
+	std::string object_file(const std::string& object) const
+	{
+		return dir + "/objects/" + object;
+	}
+
+	// same content, same object: written only once; the hash only names
+	// the object, an existing one is compared byte by byte and another
+	// content with the same hash gets the next free name <hash>-<n>
+	bool put_object(const std::string& data, std::string& object) const
+	{
+		const std::string hash = build_hash_of(data);
+		object = hash;
+		for (int n = 1;; n++)
+		{
+			struct stat st;
+			if (stat(object_file(object).c_str(), &st) != 0)
+				return write_file(object_file(object), data);
+			std::string existing;
+			if ((size_t)st.st_size == data.size() && read_file(object_file(object), existing) && existing == data)
+				return true;
+			object = hash + "-" + std::to_string(n);
+		}
+	}
+
+	static bool read_file(const std::string& file, std::string& data)
+	{
+		std::ifstream in(file.c_str(), std::ios::binary);
+		if (!in.is_open())
+			return false;
+		std::stringstream ss;
+		ss << in.rdbuf();
+		data = ss.str();
+		return !in.bad();
+	}
+
+	static bool write_file(const std::string& file, const std::string& data)
+	{
+		static std::atomic<unsigned> serial(0);
+		std::string tmp = file + ".tmp" + std::to_string((long long)getpid()) + "_" + std::to_string(serial++);
+		{
+			std::ofstream out(tmp.c_str(), std::ios::binary);
+			out.write(data.data(), data.size());
+			out.close();
+			if (out.fail())
+			{
+				remove(tmp.c_str());
+				return false;
+			}
+		}
+		if (rename(tmp.c_str(), file.c_str()) != 0)
+		{
+			remove(tmp.c_str());
+			return false;
+		}
+		return true;
+	}
+
+	std::string dir;
+};
+
+//------------------------------------------------------------------------
+// strings with their length in front, for values of the cache which
+// hold the messages of a read: log text and diagnostics events
+//------------------------------------------------------------------------
+inline void write_cache_string(std::ostream& out, const std::string& s)
+{
+	out << s.size() << " " << s << "\n";
+}
+
+inline bool read_cache_string(std::istream& in, std::string& s)
+{
+	size_t n;
+	if (!(in >> n) || in.get() != ' ')
+		return false;
+	s.resize(n);
+	if (n > 0 && !in.read(&s[0], n))
+		return false;
+	return in.get() == '\n';
+}
+
+inline void write_cache_log(std::ostream& out, const std::string& log, const diagnostics_log& diag)
+{
+	write_cache_string(out, log);
+	out << diag.events.size() << "\n";
+	for (const auto& e : diag.events)
+	{
+		write_cache_string(out, e.first);
+		write_cache_string(out, e.second);
+	}
+}
+
+inline bool read_cache_log(std::istream& in, std::string& log, diagnostics_log& diag)
+{
+	size_t n;
+	if (!read_cache_string(in, log) || !(in >> n))
+		return false;
+	diag.events.resize(n);
+	for (auto& e : diag.events)
+	{
+		if (!read_cache_string(in, e.first) || !read_cache_string(in, e.second))
+			return false;
+	}
+	return true;
+}
+
+#endif
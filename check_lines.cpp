@@ -0,0 +1,254 @@
+//========================================================================
+// Name        : check_lines.cpp
+// Author      : Michael Knoerzer
+// Version     : 1.0 (2026-10-18)
+// Copyright   : Copyright (c) 2026
+// Description : Checks lines in TOSS format for consistency:
+//             : f-value from log gf vs. f-value from gA and
+//             : tabulated wavelength vs. Ritz wavelength from the levels
+//             : compile with -O3 -fno-trapping-math, see vec_math.h
+//             : C++11 !
+//========================================================================
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <math.h>
+#include <stdio.h>
+#include "vec_math.h"
+#include "compressed_stream.h"
+using namespace std;
+
+// TOSS line list as columns
+struct toss_columns
+{
+	vector<double> wvl, e_low, j_low, e_up, j_up, loggf, gA;
+
+	size_t size() const { return wvl.size(); }
+};
+
+// histogram with fixed bins, plus under-/overflow
+struct histogram
+{
+	double min, step;
+	vector<long> bins;
+	long under = 0, over = 0;
+
+	histogram(double _min, double _max, double _step): min(_min), step(_step), bins((size_t)((_max - _min) / _step + 0.5), 0) {}
+
+	void add(double d)
+	{
+		if (d < min)
+			under++;
+		else
+		{
+			size_t b = (size_t)((d - min) / step);
+			if (b >= bins.size())
+				over++;
+			else
+				bins[b]++;
+		}
+	}
+
+	void print(ostream& out) const
+	{
+		long top = max(under, over);
+		for (long b : bins)
+			top = max(top, b);
+		if (top == 0)
+			top = 1;
+		out << fixed << setprecision(2);
+		out << "   " << setw(10) << "< " << setw(6) << min << " : " << setw(9) << under << " " << string(50 * under / top, '#') << endl;
+		for (size_t i = 0; i < bins.size(); i++)
+		{
+			out << "   " << setw(6) << (min + i * step) << " .. " << setw(6) << (min + (i + 1) * step) << " : "
+				<< setw(9) << bins[i] << " " << string(50 * bins[i] / top, '#') << endl;
+		}
+		out << "   " << setw(10) << ">= " << setw(6) << (min + bins.size() * step) << " : " << setw(9) << over << " " << string(50 * over / top, '#') << endl;
+	}
+};
+
+// flags for rejected lines
+enum { REJ_F = 1, REJ_WVL = 2, REJ_INVALID = 4 };
+
+// f/f(gA) ratio and Ritz wavelength for one block of lines, gf = 10^loggf;
+// restrict parameters: too many columns for the runtime alias checks
+void check_block(size_t m, const double* VEC_RESTRICT wvl, const double* VEC_RESTRICT e_low, const double* VEC_RESTRICT e_up,
+	const double* VEC_RESTRICT j_low, const double* VEC_RESTRICT gA, const double* VEC_RESTRICT gf, bool air,
+	double* VEC_RESTRICT ratio, double* VEC_RESTRICT ritz)
+{
+	for (size_t i = 0; i < m; i++)
+	{
+		// f = gf / g_low, f2 = gA * 1.49919E-16 * wvl^2 / g_low
+		// invalid lines (no gA, reversed levels) get ratio 0
+		double g_low = 2 * j_low[i] + 1;
+		double f = gf[i] / g_low;
+		double f2 = gA[i] * 1.49919E-16 * wvl[i] * wvl[i] / g_low;
+		double de = e_up[i] - e_low[i];
+		bool valid = (f2 > 0.0) & (de > 0.0);
+		ratio[i] = valid ? f / f2 : 0.0;
+
+		// Ritz wavelength in vacuum, optionally converted to air (Edlen 1966)
+		double vac = valid ? 1.0e8 / de : 0.0;
+		double s2 = (1.0e-4 * de) * (1.0e-4 * de);
+		double nair = 1.0 + 8.34254e-5 + 2.406147e-2 / (130.0 - s2) + 1.5998e-4 / (38.9 - s2);
+		bool use_air = air & (vac > 2000.0) & (vac < 20000.0);
+		ritz[i] = use_air ? vac / nair : vac;
+	}
+}
+
+// flags from the results of check_block
+void flag_block(size_t m, const double* VEC_RESTRICT wvl, const double* VEC_RESTRICT ratio, const double* VEC_RESTRICT ritz,
+	double ftol, double wtol, unsigned char* VEC_RESTRICT flags)
+{
+	for (size_t i = 0; i < m; i++)
+	{
+		double dw = (wvl[i] - ritz[i]) / wvl[i];
+		double dq = 1.0 - ratio[i];
+		int flag = (dq > ftol || dq < -ftol) ? REJ_F : 0;
+		flag |= (dw > wtol || dw < -wtol) ? REJ_WVL : 0;
+		flag |= (ratio[i] > 0.0) ? 0 : REJ_INVALID;
+		flags[i] = (unsigned char)flag;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc < 2)
+	{
+		cout << "Checks lines in TOSS format (f-value/gA and Ritz wavelengths)" << endl << "------------------------------------------------" << endl;
+		cout << "Usage: check_lines <filename> <options>" << endl;
+		cout << "Options: ftol=<number>, wtol=<number>, air=<true/false>, rej=<file>" << endl;
+		cout << "ftol: allowed |1 - f/f(gA)| (default 0.5, as in toss_to_fplot)" << endl;
+		cout << "wtol: allowed relative deviation from the Ritz wavelength (default 1e-4)" << endl;
+		cout << "air:  tabulated wavelengths between 2000 and 20000 A are air wavelengths" << endl;
+		cout << "rej:  file for rejected lines (default <filename>_rejects)" << endl;
+		return 0;
+	}
+
+	// default values
+	double ftol = 0.5;
+	double wtol = 1.0e-4;
+	bool air = false;
+	string rej_file = string(argv[1]) + "_rejects";
+
+	for (int i = 2; i < argc; i++)
+	{
+		string s(argv[i]);
+		if (s.substr(0, 5) == "ftol=")
+		{
+			stringstream ss(s.substr(5));
+			ss >> ftol;
+		}
+		else if (s.substr(0, 5) == "wtol=")
+		{
+			stringstream ss(s.substr(5));
+			ss >> wtol;
+		}
+		else if (s.substr(0, 4) == "air=")
+		{
+			stringstream ss(s.substr(4));
+			ss >> boolalpha >> air;
+		}
+		else if (s.substr(0, 4) == "rej=")
+		{
+			rej_file = s.substr(4);
+		}
+	}
+
+	// read in columns
+	toss_columns col;
+	cifstream in;
+	string line;
+	cout << "** attempting to open file: " << argv[1] << endl;
+	in.open(argv[1]);
+	if (!in.is_open())
+	{
+		cout << "** ERROR: couldn't open file: " << argv[1] << endl;
+		return -1;
+	}
+	while (getline(in, line))
+	{
+		double wvl, e_low, j_low, e_up, j_up, loggf, gA;
+		string p_low, p_up;
+		stringstream ss(line);
+		if (!(ss >> wvl >> e_low >> p_low >> j_low >> e_up >> p_up >> j_up >> loggf >> gA))
+			continue;
+		col.wvl.push_back(wvl);
+		col.e_low.push_back(e_low);
+		col.j_low.push_back(j_low);
+		col.e_up.push_back(e_up);
+		col.j_up.push_back(j_up);
+		col.loggf.push_back(loggf);
+		col.gA.push_back(gA);
+	}
+	in.close();
+	cout << "** " << col.size() << " lines read" << endl;
+
+	// results per line
+	const size_t n = col.size();
+	vector<double> ratio(n), ritz(n);
+	vector<unsigned char> flags(n);
+
+	// batched kernels, one block stays in L1 cache
+	const size_t block = 1024;
+	vector<double> gf(block);
+	for (size_t i0 = 0; i0 < n; i0 += block)
+	{
+		const size_t m = min(block, n - i0);
+		vpow10(&col.loggf[i0], &gf[0], m);
+		check_block(m, &col.wvl[i0], &col.e_low[i0], &col.e_up[i0], &col.j_low[i0], &col.gA[i0], &gf[0], air, &ratio[i0], &ritz[i0]);
+		flag_block(m, &col.wvl[i0], &ratio[i0], &ritz[i0], ftol, wtol, &flags[i0]);
+	}
+
+	// aggregate
+	histogram h_f(-2.0, 2.0, 0.2);
+	histogram h_w(-9.0, 0.0, 0.5);
+	long n_f = 0, n_w = 0, n_inv = 0;
+	ofstream rej;
+	vector<char> rej_buf(1 << 20);
+	rej.rdbuf()->pubsetbuf(&rej_buf[0], rej_buf.size());
+	rej.open(rej_file.c_str());
+	if (rej.is_open())
+		rej << "#  wavelength flag  f/f(gA)   Ritz wvl" << endl;
+	char buf[128];
+	for (size_t i = 0; i < n; i++)
+	{
+		if (flags[i] & REJ_INVALID)
+			n_inv++;
+		else
+		{
+			h_f.add(log10(ratio[i]));
+			double dw = fabs(col.wvl[i] - ritz[i]) / col.wvl[i];
+			h_w.add(dw > 0.0 ? log10(dw) : -99.0);
+			if (flags[i] & REJ_F)
+				n_f++;
+			if (flags[i] & REJ_WVL)
+				n_w++;
+		}
+		if (flags[i] && rej.is_open())
+		{
+			const char* code = (flags[i] & REJ_INVALID) ? "E" : ((flags[i] & REJ_F) ? ((flags[i] & REJ_WVL) ? "FW" : "F") : "W");
+			int len = snprintf(buf, sizeof(buf), "%12.3f %-3s %10.3e %12.3f\n", col.wvl[i], code, ratio[i], ritz[i]);
+			rej.write(buf, len);
+		}
+	}
+	rej.close();
+
+	// summary
+	cout << endl << "** histogram of log10(f/f(gA)):" << endl;
+	h_f.print(cout);
+	cout << endl << "** histogram of log10(|wvl - Ritz wvl| / wvl):" << endl;
+	h_w.print(cout);
+	cout << endl;
+	cout << "** lines checked:            " << n << endl;
+	cout << "** deviating f-value/gA (F): " << n_f << endl;
+	cout << "** deviating wavelength (W): " << n_w << endl;
+	cout << "** invalid gA/energies (E):  " << n_inv << endl;
+	cout << "** rejected lines written to: " << rej_file << endl;
+
+	return 0;
+}
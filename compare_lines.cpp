@@ -0,0 +1,318 @@
+//========================================================================
+// Name        : compare_lines.cpp
+// Author      : Michael Knoerzer
+// Version     : 1.0 (2026-10-18)
+// Copyright   : Copyright (c) 2026
+// Description : Compares levels and lines of the same ion from
+//             : different sources (NIST, ADAMANT, TOSS, TMAD)
+//             : C++11 !
+//========================================================================
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <numeric>
+#include <iomanip>
+#include <math.h>
+#include "atomic_data.h"
+using namespace std;
+
+// simple running statistics
+struct stats
+{
+	int n = 0;
+	double sum = 0.0;
+	double sum2 = 0.0;
+	double min = 9.9e+30;
+	double max = -9.9e+30;
+
+	void add(double d)
+	{
+		n++;
+		sum += d;
+		sum2 += d * d;
+		min = std::min(min, d);
+		max = std::max(max, d);
+	}
+	double mean() const { return n ? sum / n : 0.0; }
+	double rms() const { return n ? sqrt(sum2 / n) : 0.0; }
+};
+
+// one matched line pair
+struct line_match
+{
+	int ref;
+	int src;
+	double dwvl;
+	double dloggf;
+};
+
+// match levels of src against ref by sort-merge over energy
+// result[i] = index in ref of src level i, -1 if no match
+vector<int> match_levels(const atomic_data& ref, const atomic_data& src, double tol, bool use_J)
+{
+	vector<int> a(ref.levels.size()), b(src.levels.size());
+	iota(a.begin(), a.end(), 0);
+	iota(b.begin(), b.end(), 0);
+	sort(a.begin(), a.end(), [&](int i, int j) { return ref.levels[i].energy < ref.levels[j].energy; });
+	sort(b.begin(), b.end(), [&](int i, int j) { return src.levels[i].energy < src.levels[j].energy; });
+
+	vector<int> result(src.levels.size(), -1);
+	vector<bool> taken(ref.levels.size(), false);
+	size_t lo = 0;
+	for (int i : b)
+	{
+		const atomic_level& l = src.levels[i];
+		// advance lower end of the energy window
+		while (lo < a.size() && ref.levels[a[lo]].energy < l.energy - tol)
+			lo++;
+
+		// nearest free level with same J and parity inside the window
+		int best = -1;
+		double best_d = tol;
+		for (size_t k = lo; k < a.size() && ref.levels[a[k]].energy <= l.energy + tol; k++)
+		{
+			const atomic_level& r = ref.levels[a[k]];
+			if (taken[a[k]] || r.p != l.p || (use_J && fabs(r.J - l.J) > 0.01))
+				continue;
+			double d = fabs(r.energy - l.energy);
+			if (d <= best_d)
+			{
+				best = a[k];
+				best_d = d;
+			}
+		}
+		if (best >= 0)
+		{
+			result[i] = best;
+			taken[best] = true;
+		}
+	}
+	return result;
+}
+
+inline uint64_t pair_key(int low, int up)
+{
+	return ((uint64_t)(uint32_t)low << 32) | (uint32_t)up;
+}
+
+void print_line(ostream& out, const atomic_data& d, const atomic_line& t)
+{
+	const atomic_level& lo = d.levels[t.low];
+	const atomic_level& up = d.levels[t.up];
+	out << setw(12) << fixed << setprecision(3) << t.wvl << " "
+		<< setw(10) << setprecision(2) << lo.energy << " (" << (lo.p ? "o" : "e") << ") " << setw(4) << setprecision(1) << lo.J << " "
+		<< setw(10) << setprecision(2) << up.energy << " (" << (up.p ? "o" : "e") << ") " << setw(4) << setprecision(1) << up.J
+		<< "  " << setprecision(3) << setw(7) << t.loggf << endl;
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc < 3)
+	{
+		cout << "\nUsage: compare_lines <source> <source> [<source> ...] <options>\n";
+		cout << "\nSources: nist:<file>, adamant:<level file>,<line file>, toss:<file>, tmad:<file>\n";
+		cout << "All sources are compared to the first one\n";
+		cout << "\nOptions: tol=<number>, j=<true/false>, list=<number>, out=<file>\n";
+		cout << "tol is the energy tolerance in cm^-1 for matching levels (default 1.0)\n";
+		cout << "j=false matches levels by energy and parity only (i.e., for TMAD terms)\n";
+		cout << "list is the number of unmatched lines printed per source (default 10)\n";
+		cout << "out writes all matched line pairs to a file" << endl;
+		return 0;
+	}
+
+	// default values
+	double tol = 1.0;
+	bool use_J = true;
+	int list = 10;
+	string out_file;
+	vector<string> specs;
+
+	for (int i = 1; i < argc; i++)
+	{
+		string s(argv[i]);
+		if (s.substr(0, 4) == "tol=")
+		{
+			stringstream ss(s.substr(4));
+			ss >> tol;
+		}
+		else if (s.substr(0, 2) == "j=")
+		{
+			stringstream ss(s.substr(2));
+			ss >> boolalpha >> use_J;
+		}
+		else if (s.substr(0, 5) == "list=")
+		{
+			stringstream ss(s.substr(5));
+			ss >> list;
+		}
+		else if (s.substr(0, 4) == "out=")
+		{
+			out_file = s.substr(4);
+		}
+		else
+			specs.push_back(s);
+	}
+	if (specs.size() < 2)
+	{
+		cout << "** need at least two sources" << endl;
+		return -1;
+	}
+
+	// read in all sources
+	vector<atomic_data> data(specs.size());
+	for (size_t i = 0; i < specs.size(); i++)
+	{
+		cout << "** attempting to read source: " << specs[i] << endl;
+		if (!read_source(specs[i], data[i]))
+		{
+			cout << "** ERROR: couldn't read source: " << specs[i] << endl;
+			return -1;
+		}
+		cout << "** " << data[i].levels.size() << " levels, " << data[i].lines.size() << " lines";
+		if (data[i].bad_records > 0)
+			cout << ", " << data[i].bad_records << " bad records";
+		cout << endl;
+	}
+
+	ofstream out;
+	if (!out_file.empty())
+	{
+		out.open(out_file.c_str());
+		out << "# wvl_ref wvl_src dwvl loggf_ref loggf_src dloggf source" << endl;
+	}
+
+	const atomic_data& ref = data[0];
+
+	// hash table (low, up) -> line of reference
+	unordered_map<uint64_t, int> ref_lines;
+	ref_lines.reserve(ref.lines.size() * 2);
+	int ref_dups = 0;
+	for (size_t i = 0; i < ref.lines.size(); i++)
+	{
+		if (!ref_lines.emplace(pair_key(ref.lines[i].low, ref.lines[i].up), i).second)
+			ref_dups++;
+	}
+	if (ref_dups > 0)
+		cout << "** " << ref_dups << " duplicate level pairs in reference, only the first is compared" << endl;
+
+	for (size_t s = 1; s < data.size(); s++)
+	{
+		const atomic_data& src = data[s];
+		cout << endl << "** comparing " << src.source << " to " << ref.source << endl;
+
+		// levels
+		vector<int> lmap = match_levels(ref, src, tol, use_J);
+		int matched = count_if(lmap.begin(), lmap.end(), [](int i) { return i >= 0; });
+		cout << "** levels matched: " << matched << ", only in reference: " << (ref.levels.size() - matched)
+			<< ", only in source: " << (src.levels.size() - matched) << endl;
+
+		stats s_dE;
+		for (size_t i = 0; i < lmap.size(); i++)
+		{
+			if (lmap[i] >= 0)
+				s_dE.add(src.levels[i].energy - ref.levels[lmap[i]].energy);
+		}
+
+		// lines
+		vector<bool> found(ref.lines.size(), false);
+		vector<line_match> matches;
+		vector<int> only_src;
+		int no_level = 0;
+		for (size_t i = 0; i < src.lines.size(); i++)
+		{
+			const atomic_line& t = src.lines[i];
+			int lo = lmap[t.low];
+			int up = lmap[t.up];
+			if (lo < 0 || up < 0)
+			{
+				no_level++;
+				only_src.push_back(i);
+				continue;
+			}
+			auto it = ref_lines.find(pair_key(lo, up));
+			if (it == ref_lines.end())
+				it = ref_lines.find(pair_key(up, lo));
+			if (it == ref_lines.end())
+			{
+				only_src.push_back(i);
+				continue;
+			}
+			const atomic_line& r = ref.lines[it->second];
+			found[it->second] = true;
+			matches.push_back({ it->second, (int)i, t.wvl - r.wvl, t.loggf - r.loggf });
+		}
+		int missing = count(found.begin(), found.end(), false);
+
+		cout << "** lines matched: " << matches.size() << ", only in reference: " << missing
+			<< ", only in source: " << only_src.size() << " (" << no_level << " with unmatched levels)" << endl;
+
+		stats s_dw, s_rw, s_gf;
+		for (const auto& m : matches)
+		{
+			s_dw.add(m.dwvl);
+			s_rw.add(m.dwvl / ref.lines[m.ref].wvl);
+			s_gf.add(m.dloggf);
+			if (out.is_open())
+			{
+				out << fixed << setprecision(3) << ref.lines[m.ref].wvl << " " << src.lines[m.src].wvl << " "
+					<< setprecision(4) << m.dwvl << " " << setprecision(3) << ref.lines[m.ref].loggf << " "
+					<< src.lines[m.src].loggf << " " << m.dloggf << " " << s << endl;
+			}
+		}
+
+		cout << scientific << setprecision(3);
+		if (s_dE.n > 0)
+		{
+			cout << "** level energy offset (cm^-1): mean " << s_dE.mean() << " rms " << s_dE.rms()
+				<< " min " << s_dE.min << " max " << s_dE.max << endl;
+		}
+		if (matches.size() > 0)
+		{
+			cout << "** wavelength offset (A):       mean " << s_dw.mean() << " rms " << s_dw.rms()
+				<< " min " << s_dw.min << " max " << s_dw.max << endl;
+			cout << "** relative wavelength offset:  mean " << s_rw.mean() << " rms " << s_rw.rms()
+				<< " min " << s_rw.min << " max " << s_rw.max << endl;
+			cout << "** gf ratio (source/reference): mean " << pow(10, s_gf.mean()) << " rms(log) " << s_gf.rms()
+				<< " min " << pow(10, s_gf.min) << " max " << pow(10, s_gf.max) << endl;
+
+			// worst gf ratios
+			sort(matches.begin(), matches.end(), [](const line_match& i, const line_match& j) { return fabs(i.dloggf) > fabs(j.dloggf); });
+			cout << "** largest gf deviations (reference, delta log gf):" << endl;
+			for (int i = 0; i < list && i < (int)matches.size(); i++)
+			{
+				cout << "*** " << setw(8) << fixed << setprecision(3) << matches[i].dloggf << " ";
+				print_line(cout, ref, ref.lines[matches[i].ref]);
+			}
+		}
+
+		// missing lines
+		if (missing > 0)
+		{
+			cout << "** lines only in reference:" << endl;
+			int n = 0;
+			for (size_t i = 0; i < found.size() && n < list; i++)
+			{
+				if (found[i])
+					continue;
+				cout << "*** ";
+				print_line(cout, ref, ref.lines[i]);
+				n++;
+			}
+		}
+		if (only_src.size() > 0)
+		{
+			cout << "** lines only in source:" << endl;
+			for (int i = 0; i < list && i < (int)only_src.size(); i++)
+			{
+				cout << "*** ";
+				print_line(cout, src, src.lines[only_src[i]]);
+			}
+		}
+	}
+
+	return 0;
+}
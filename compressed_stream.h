@@ -0,0 +1,469 @@
+//========================================================================
+// Name        : compressed_stream.h
+// Author      : Michael Knoerzer
+// Version     : 1.0 (2026-10-18)
+// Copyright   : Copyright (c) 2026
+// Description : Drop-in replacements for ifstream/ofstream that read
+//             : gzip/zstd files transparently (detected by magic bytes)
+//             : and write them for .gz/.zst names; (de)compression runs
+//             : in a background thread connected by a ring of blocks
+//             : gzip: zlib with -DHAVE_ZLIB -lz, else the gzip command
+//             : zstd: the zstd command
+//             : compile with -pthread
+//             : C++11 !
+//========================================================================
+#ifndef COMPRESSED_STREAM_H
+#define COMPRESSED_STREAM_H
+
+#include <string>
+#include <vector>
+#include <istream>
+#include <ostream>
+#include <fstream>
+#include <streambuf>
+#include <functional>
+#include <memory>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+enum stream_compression { COMPRESSION_NONE, COMPRESSION_GZIP, COMPRESSION_ZSTD };
+
+// compression of an existing file from its first bytes
+inline stream_compression file_compression(const std::string& file)
+{
+	unsigned char magic[4] = { 0, 0, 0, 0 };
+	FILE* f = fopen(file.c_str(), "rb");
+	if (!f)
+		return COMPRESSION_NONE;
+	size_t n = fread(magic, 1, 4, f);
+	fclose(f);
+	if (n >= 2 && magic[0] == 0x1f && magic[1] == 0x8b)
+		return COMPRESSION_GZIP;
+	if (n >= 4 && magic[0] == 0x28 && magic[1] == 0xb5 && magic[2] == 0x2f && magic[3] == 0xfd)
+		return COMPRESSION_ZSTD;
+	return COMPRESSION_NONE;
+}
+
+// compression of a file to be written from its name
+inline stream_compression name_compression(const std::string& file)
+{
+	auto ends_with = [&](const std::string& ext)
+	{
+		return file.size() > ext.size() && file.compare(file.size() - ext.size(), ext.size(), ext) == 0;
+	};
+	if (ends_with(".gz"))
+		return COMPRESSION_GZIP;
+	if (ends_with(".zst"))
+		return COMPRESSION_ZSTD;
+	return COMPRESSION_NONE;
+}
+
+// file name as one argument for popen
+inline std::string shell_quote(const std::string& s)
+{
+	std::string q = "'";
+	for (char c : s)
+	{
+		if (c == '\'')
+			q += "'\\''";
+		else
+			q += c;
+	}
+	return q + "'";
+}
+
+//------------------------------------------------------------------------
+// ring of blocks between a producer and a consumer thread: the consumer
+// keeps its block until it asks for the next one
+//------------------------------------------------------------------------
+struct block_ring
+{
+	std::vector<std::vector<char>> blocks;
+	std::vector<size_t> fill;
+	size_t head = 0;		// next block to read
+	size_t tail = 0;		// next block to write
+	size_t count = 0;		// written and not released blocks
+	bool done = false;		// producer finished
+	bool abort = false;		// consumer gives up
+	std::mutex m;
+	std::condition_variable cv;
+
+	block_ring(size_t n = 8, size_t size = 1 << 18): blocks(n, std::vector<char>(size)), fill(n, 0) {}
+
+	// free block for the producer, nullptr on abort
+	std::vector<char>* wait_free()
+	{
+		std::unique_lock<std::mutex> lock(m);
+		cv.wait(lock, [&]() { return count < blocks.size() || abort; });
+		return abort ? nullptr : &blocks[tail];
+	}
+
+	void commit(size_t n)
+	{
+		std::lock_guard<std::mutex> lock(m);
+		fill[tail] = n;
+		tail = (tail + 1) % blocks.size();
+		count++;
+		cv.notify_all();
+	}
+
+	void finish()
+	{
+		std::lock_guard<std::mutex> lock(m);
+		done = true;
+		cv.notify_all();
+	}
+
+	// next full block for the consumer, -1 if the producer is done
+	int wait_full(size_t& n)
+	{
+		std::unique_lock<std::mutex> lock(m);
+		cv.wait(lock, [&]() { return count > 0 || done; });
+		if (count == 0)
+			return -1;
+		n = fill[head];
+		return head;
+	}
+
+	void release()
+	{
+		std::lock_guard<std::mutex> lock(m);
+		head = (head + 1) % blocks.size();
+		count--;
+		cv.notify_all();
+	}
+
+	void stop()
+	{
+		std::lock_guard<std::mutex> lock(m);
+		abort = true;
+		cv.notify_all();
+	}
+};
+
+//------------------------------------------------------------------------
+// decompressing streambuf, the background thread fills the ring
+//------------------------------------------------------------------------
+class decompress_buf : public std::streambuf
+{
+public:
+	~decompress_buf() { close(); }
+
+	bool open(const std::string& file, stream_compression c)
+	{
+		close();
+		ring.reset(new block_ring());
+#ifdef HAVE_ZLIB
+		if (c == COMPRESSION_GZIP)
+		{
+			// gzread handles concatenated members, too
+			gz = gzopen(file.c_str(), "rb");
+			if (!gz)
+				return false;
+			gzbuffer(gz, 1 << 17);
+			source = [this](char* buf, size_t n) -> long { return gzread(gz, buf, (unsigned)n); };
+		}
+#endif
+		if (!source)
+		{
+			std::string cmd = (c == COMPRESSION_ZSTD ? "zstd -dcq " : "gzip -dc ") + shell_quote(file);
+			pipe = popen(cmd.c_str(), "r");
+			if (!pipe)
+				return false;
+			source = [this](char* buf, size_t n) -> long { return (long)fread(buf, 1, n, pipe); };
+		}
+		worker = std::thread([this]()
+		{
+			std::vector<char>* b;
+			while ((b = ring->wait_free()) != nullptr)
+			{
+				long n = source(&(*b)[0], b->size());
+				if (n <= 0)
+					break;
+				ring->commit(n);
+			}
+			ring->finish();
+		});
+		is_open_ = true;
+		return true;
+	}
+
+	// false if the decompressor failed (i.e. not installed, corrupt data)
+	bool close()
+	{
+		if (!is_open_)
+			return true;
+		ring->stop();
+		worker.join();
+		bool ok = true;
+#ifdef HAVE_ZLIB
+		if (gz)
+			gzclose(gz);
+		gz = nullptr;
+#endif
+		if (pipe)
+			ok = pclose(pipe) == 0;
+		pipe = nullptr;
+		source = nullptr;
+		current = -1;
+		pos = 0;
+		setg(nullptr, nullptr, nullptr);
+		is_open_ = false;
+		return ok;
+	}
+
+	bool is_open() const { return is_open_; }
+
+protected:
+	int_type underflow() override
+	{
+		if (gptr() < egptr())
+			return traits_type::to_int_type(*gptr());
+		if (!is_open_)
+			return traits_type::eof();
+		if (current >= 0)
+		{
+			pos += egptr() - eback();
+			ring->release();
+		}
+		size_t n = 0;
+		current = ring->wait_full(n);
+		if (current < 0)
+		{
+			setg(nullptr, nullptr, nullptr);
+			return traits_type::eof();
+		}
+		char* b = &ring->blocks[current][0];
+		setg(b, b, b + n);
+		return traits_type::to_int_type(*gptr());
+	}
+
+	// tellg and forward seeks (skipping), enough for sequential readers
+	pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) override
+	{
+		if (dir == std::ios_base::cur)
+			return seekpos(tell() + off, which);
+		if (dir == std::ios_base::beg)
+			return seekpos(off, which);
+		return pos_type(off_type(-1));
+	}
+
+	pos_type seekpos(pos_type p, std::ios_base::openmode) override
+	{
+		off_type target = p;
+		while (tell() < target)
+		{
+			off_type step = std::min<off_type>(target - tell(), egptr() - gptr());
+			if (step == 0)
+			{
+				if (traits_type::eq_int_type(underflow(), traits_type::eof()))
+					return pos_type(off_type(-1));
+				continue;
+			}
+			gbump((int)step);
+		}
+		return tell() == target ? pos_type(target) : pos_type(off_type(-1));
+	}
+
+private:
+	off_type tell() const { return pos + (gptr() - eback()); }
+
+	std::unique_ptr<block_ring> ring;
+	std::function<long(char*, size_t)> source;
+	std::thread worker;
+	FILE* pipe = nullptr;
+#ifdef HAVE_ZLIB
+	gzFile gz = nullptr;
+#endif
+	int current = -1;		// block held by the reader
+	off_type pos = 0;		// bytes of all released blocks
+	bool is_open_ = false;
+};
+
+//------------------------------------------------------------------------
+// compressing streambuf, the background thread empties the ring
+//------------------------------------------------------------------------
+class compress_buf : public std::streambuf
+{
+public:
+	~compress_buf() { close(); }
+
+	bool open(const std::string& file, stream_compression c)
+	{
+		close();
+		ring.reset(new block_ring());
+#ifdef HAVE_ZLIB
+		if (c == COMPRESSION_GZIP)
+		{
+			gz = gzopen(file.c_str(), "wb6");
+			if (!gz)
+				return false;
+			sink = [this](const char* buf, size_t n) { return gzwrite(gz, buf, (unsigned)n) == (int)n; };
+		}
+#endif
+		if (!sink)
+		{
+			std::string cmd = (c == COMPRESSION_ZSTD ? "zstd -qc > " : "gzip -c > ") + shell_quote(file);
+			pipe = popen(cmd.c_str(), "w");
+			if (!pipe)
+				return false;
+			sink = [this](const char* buf, size_t n) { return fwrite(buf, 1, n, pipe) == n; };
+		}
+		worker = std::thread([this]()
+		{
+			size_t n;
+			int b;
+			while ((b = ring->wait_full(n)) >= 0)
+			{
+				if (!sink(&ring->blocks[b][0], n))
+					failed = true;
+				ring->release();
+			}
+		});
+		is_open_ = true;
+		return next_block();
+	}
+
+	// flushes everything, false if writing failed
+	bool close()
+	{
+		if (!is_open_)
+			return true;
+		flush_block();
+		ring->finish();
+		worker.join();
+		bool ok = !failed;
+#ifdef HAVE_ZLIB
+		if (gz)
+			ok = gzclose(gz) == Z_OK && ok;
+		gz = nullptr;
+#endif
+		if (pipe)
+			ok = pclose(pipe) == 0 && ok;
+		pipe = nullptr;
+		sink = nullptr;
+		setp(nullptr, nullptr);
+		is_open_ = false;
+		return ok;
+	}
+
+	bool is_open() const { return is_open_; }
+
+protected:
+	int_type overflow(int_type c) override
+	{
+		if (!is_open_)
+			return traits_type::eof();
+		flush_block();
+		if (!next_block())
+			return traits_type::eof();
+		if (!traits_type::eq_int_type(c, traits_type::eof()))
+		{
+			*pptr() = traits_type::to_char_type(c);
+			pbump(1);
+		}
+		return traits_type::not_eof(c);
+	}
+
+	// the data is handed over when the block is full or at close
+	int sync() override { return failed ? -1 : 0; }
+
+private:
+	bool next_block()
+	{
+		std::vector<char>* b = ring->wait_free();
+		if (!b)
+			return false;
+		setp(&(*b)[0], &(*b)[0] + b->size());
+		return true;
+	}
+
+	void flush_block()
+	{
+		if (pbase())
+			ring->commit(pptr() - pbase());
+		setp(nullptr, nullptr);
+	}
+
+	std::unique_ptr<block_ring> ring;
+	std::function<bool(const char*, size_t)> sink;
+	std::thread worker;
+	FILE* pipe = nullptr;
+#ifdef HAVE_ZLIB
+	gzFile gz = nullptr;
+#endif
+	bool failed = false;
+	bool is_open_ = false;
+};
+
+//------------------------------------------------------------------------
+// ifstream/ofstream with the same open/is_open/close
+//------------------------------------------------------------------------
+class cifstream : public std::istream
+{
+public:
+	cifstream(): std::istream(nullptr) {}
+	explicit cifstream(const std::string& file): std::istream(nullptr) { open(file); }
+
+	void open(const std::string& file)
+	{
+		close();
+		compression = file_compression(file);
+		bool ok = compression == COMPRESSION_NONE ? plain.open(file.c_str(), std::ios_base::in) != nullptr : packed.open(file, compression);
+		rdbuf(compression == COMPRESSION_NONE ? (std::streambuf*)&plain : (std::streambuf*)&packed);
+		clear(ok ? std::ios_base::goodbit : std::ios_base::failbit);
+	}
+
+	bool is_open() const { return plain.is_open() || packed.is_open(); }
+
+	void close()
+	{
+		if ((plain.is_open() && !plain.close()) || !packed.close())
+			setstate(std::ios_base::failbit);
+	}
+
+	bool compressed() const { return compression != COMPRESSION_NONE; }
+
+private:
+	std::filebuf plain;
+	decompress_buf packed;
+	stream_compression compression = COMPRESSION_NONE;
+};
+
+class cofstream : public std::ostream
+{
+public:
+	cofstream(): std::ostream(nullptr) {}
+	explicit cofstream(const std::string& file): std::ostream(nullptr) { open(file); }
+
+	void open(const std::string& file)
+	{
+		close();
+		stream_compression c = name_compression(file);
+		bool ok = c == COMPRESSION_NONE ? plain.open(file.c_str(), std::ios_base::out) != nullptr : packed.open(file, c);
+		rdbuf(c == COMPRESSION_NONE ? (std::streambuf*)&plain : (std::streambuf*)&packed);
+		clear(ok ? std::ios_base::goodbit : std::ios_base::failbit);
+	}
+
+	bool is_open() const { return plain.is_open() || packed.is_open(); }
+
+	void close()
+	{
+		flush();
+		if ((plain.is_open() && !plain.close()) || !packed.close())
+			setstate(std::ios_base::failbit);
+	}
+
+private:
+	std::filebuf plain;
+	compress_buf packed;
+};
+
+#endif
@@ -0,0 +1,194 @@
+//========================================================================
+// Name        : csv_scan.h
+// Author      : Michael Knoerzer
+// Version     : 1.0 (2026-10-18)
+// Copyright   : Copyright (c) 2026
+// Description : Splits CSV/TSV data into records and fields without
+//             : copying: 64 bytes at a time, delimiters/quotes/line ends
+//             : are found as bit masks (SSE2, plain loop otherwise) and
+//             : quoted parts are masked out by a prefix xor
+//             : C++11 !
+//========================================================================
+#ifndef CSV_SCAN_H
+#define CSV_SCAN_H
+
+#include <string>
+#include <vector>
+#include <cstring>
+#include <algorithm>
+#include <cstdint>
+#include "parse_arena.h"
+#if defined(__SSE2__) && defined(__GNUC__)
+#include <emmintrin.h>
+#define CSV_SCAN_SSE2 1
+#endif
+
+// one field, points into the scanned data
+struct csv_field
+{
+	const char* p;
+	size_t n;
+
+	std::string str() const { return std::string(p, n); }
+};
+
+// bit i set if p[i] is a quote/delimiter/line end, 64 bytes
+inline void csv_block_masks(const char* p, char delim, uint64_t& quote, uint64_t& sep, uint64_t& nl)
+{
+	quote = sep = nl = 0;
+#ifdef CSV_SCAN_SSE2
+	const __m128i q = _mm_set1_epi8('"');
+	const __m128i d = _mm_set1_epi8(delim);
+	const __m128i n = _mm_set1_epi8('\n');
+	for (int i = 0; i < 4; i++)
+	{
+		__m128i x = _mm_loadu_si128((const __m128i*)(p + 16 * i));
+		quote |= (uint64_t)(unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(x, q)) << (16 * i);
+		sep |= (uint64_t)(unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(x, d)) << (16 * i);
+		nl |= (uint64_t)(unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(x, n)) << (16 * i);
+	}
+#else
+	for (int i = 0; i < 64; i++)
+	{
+		quote |= (uint64_t)(p[i] == '"') << i;
+		sep |= (uint64_t)(p[i] == delim) << i;
+		nl |= (uint64_t)(p[i] == '\n') << i;
+	}
+#endif
+}
+
+// bit i = xor of the bits 0..i: 1 between an opening and a closing quote
+inline uint64_t csv_prefix_xor(uint64_t x)
+{
+	x ^= x << 1;
+	x ^= x << 2;
+	x ^= x << 4;
+	x ^= x << 8;
+	x ^= x << 16;
+	x ^= x << 32;
+	return x;
+}
+
+inline int csv_ctz(uint64_t x)
+{
+#ifdef __GNUC__
+	return __builtin_ctzll(x);
+#else
+	int n = 0;
+	while (!(x & 1))
+	{
+		x >>= 1;
+		n++;
+	}
+	return n;
+#endif
+}
+
+// record by record over a buffer, fields keep their quotes
+struct csv_scanner
+{
+	const char* data;
+	size_t size;
+	char delim;
+	size_t base = 0;			// offset of the current 64 byte block
+	uint64_t structural = 0;	// delimiters/line ends outside quotes, not used yet
+	uint64_t inside = 0;		// all bits set if the block starts inside quotes
+	size_t start = 0;			// start of the current field
+
+	csv_scanner(const char* _data, size_t _size, char _delim): data(_data), size(_size), delim(_delim)
+	{
+		load();
+	}
+
+	// fields of the next record, false at the end of the data
+	bool next(std::vector<csv_field>& fields)
+	{
+		fields.clear();
+		if (start >= size)
+			return false;
+		while (true)
+		{
+			while (structural == 0)
+			{
+				base += 64;
+				if (base >= size)
+				{
+					push(fields, start, size);
+					start = size;
+					return true;
+				}
+				load();
+			}
+			size_t pos = base + csv_ctz(structural);
+			structural &= structural - 1;
+			push(fields, start, pos);
+			start = pos + 1;
+			if (data[pos] == '\n')
+				return true;
+		}
+	}
+
+private:
+	void load()
+	{
+		const char* p = data + base;
+		char tmp[64];
+		if (size - base < 64)
+		{
+			memset(tmp, 0, sizeof(tmp));
+			memcpy(tmp, p, size - base);
+			p = tmp;
+		}
+		uint64_t quote, sep, nl;
+		csv_block_masks(p, delim, quote, sep, nl);
+		uint64_t in = csv_prefix_xor(quote) ^ inside;
+		inside = (in >> 63) ? ~(uint64_t)0 : 0;
+		structural = (sep | nl) & ~in;
+	}
+
+	void push(std::vector<csv_field>& fields, size_t b, size_t e)
+	{
+		if (e > b && data[e - 1] == '\r')
+			e--;
+		fields.push_back({ data + b, e - b });
+	}
+};
+
+// field without blanks, quotes and the ="..." of spreadsheet exports
+inline text_view csv_trim(const csv_field& f)
+{
+	const char* b = f.p;
+	const char* e = f.p + f.n;
+	while (b < e && (*b == ' ' || *b == '\t' || *b == '"' || *b == '='))
+		b++;
+	while (e > b && (e[-1] == ' ' || e[-1] == '\t' || e[-1] == '"'))
+		e--;
+	return text_view(b, e - b);
+}
+
+inline std::string csv_value(const csv_field& f)
+{
+	std::string s = csv_trim(f).str();
+	// "" inside quotes
+	s.erase(std::remove(s.begin(), s.end(), '"'), s.end());
+	return s;
+}
+
+// the same in place, only a value with "" inside is copied to arena
+inline text_view csv_value(const csv_field& f, parse_arena& arena)
+{
+	text_view v = csv_trim(f);
+	return v.find('"') == std::string::npos ? v : arena.copy_without(v, '"');
+}
+
+// delimiter of a header line: tab or comma, 0 if it is no CSV/TSV header
+inline char csv_delimiter(const std::string& header)
+{
+	if (header.find('\t') != std::string::npos)
+		return '\t';
+	if (header.find(',') != std::string::npos)
+		return ',';
+	return 0;
+}
+
+#endif
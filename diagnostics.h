@@ -0,0 +1,115 @@
+//========================================================================
+// Name        : diagnostics.h
+// Author      : Michael Knoerzer
+// Version     : 1.0 (2026-10-18)
+// Copyright   : Copyright (c) 2026
+// Description : Collects messages about bad/suspicious records:
+//             : counts per category, keeps the first N examples and
+//             : optionally writes every record to a (buffered) file,
+//             : prints a summary at the end instead of one line each
+//             : C++11 !
+//========================================================================
+#ifndef DIAGNOSTICS_H
+#define DIAGNOSTICS_H
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iostream>
+#include <utility>
+
+struct diagnostics
+{
+	struct category
+	{
+		std::string name;
+		long count;
+		std::vector<std::string> examples;
+	};
+
+	size_t max_examples;
+	std::vector<category> categories;	// in order of first occurrence
+	std::ofstream rejects;
+	std::vector<char> buffer;
+
+	diagnostics(size_t n = 5): max_examples(n) {}
+
+	// all records are written to this file, too
+	bool open_rejects(const std::string& file)
+	{
+		buffer.resize(1 << 20);
+		rejects.rdbuf()->pubsetbuf(&buffer[0], buffer.size());
+		rejects.open(file.c_str());
+		return rejects.is_open();
+	}
+
+	category& get(const std::string& name)
+	{
+		for (auto& c : categories)
+		{
+			if (c.name == name)
+				return c;
+		}
+		categories.push_back({ name, 0, std::vector<std::string>() });
+		return categories.back();
+	}
+
+	// count one event, record is the offending input line
+	void report(const std::string& name, const std::string& record)
+	{
+		category& c = get(name);
+		c.count++;
+		if (c.examples.size() < max_examples)
+			c.examples.push_back(record);
+		if (rejects.is_open())
+			rejects << name << ": " << record << '\n';
+	}
+
+	long count(const std::string& name) const
+	{
+		for (const auto& c : categories)
+		{
+			if (c.name == name)
+				return c.count;
+		}
+		return 0;
+	}
+
+	// counts and examples of all categories
+	void summary(std::ostream& out, const std::string& prefix = "** ")
+	{
+		if (rejects.is_open())
+			rejects.flush();
+		if (categories.empty())
+			return;
+		out << prefix << "diagnostics summary:" << std::endl;
+		for (const auto& c : categories)
+		{
+			out << prefix << c.count << " x " << c.name << std::endl;
+			for (const auto& e : c.examples)
+				out << prefix << "   " << e << std::endl;
+			if (c.count > (long)c.examples.size())
+				out << prefix << "   ... " << (c.count - c.examples.size()) << " more" << std::endl;
+		}
+	}
+};
+
+// messages of one thread/batch, replayed into the diagnostics later so
+// counts, examples and the rejects file keep the input order
+struct diagnostics_log
+{
+	std::vector<std::pair<std::string, std::string>> events;
+
+	void report(const std::string& name, const std::string& record)
+	{
+		events.push_back(std::make_pair(name, record));
+	}
+
+	void replay(diagnostics& diag) const
+	{
+		for (const auto& e : events)
+			diag.report(e.first, e.second);
+	}
+};
+
+#endif
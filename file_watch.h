@@ -0,0 +1,190 @@
+//========================================================================
+// Name        : file_watch.h
+// Author      : Michael Knoerzer
+// Version     : 1.0 (2026-10-18)
+// Copyright   : Copyright (c) 2026
+// Description : Waits for changes of input files (watch mode of the
+//             : tools): inotify on Linux, watching the directories so
+//             : editors which save to a new file and rename it are seen,
+//             : size/modification time polling elsewhere; output files
+//             : are replaced by rename, readers never see half of one
+//             : C++11 !
+//========================================================================
+#ifndef FILE_WATCH_H
+#define FILE_WATCH_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <functional>
+#include <thread>
+#include <chrono>
+#include <cstdio>
+#include <sys/stat.h>
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#include <climits>
+#endif
+
+class file_watch
+{
+public:
+	file_watch(const std::vector<std::string>& files) : files(files)
+	{
+		for (const auto& f : files)
+			stamps.push_back(stamp(f));
+#ifdef __linux__
+		fd = inotify_init1(IN_CLOEXEC);
+		for (size_t i = 0; i < files.size() && fd >= 0; i++)
+		{
+			std::string dir, name;
+			split(files[i], dir, name);
+			int wd = inotify_add_watch(fd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_ATTRIB);
+			if (wd < 0)
+			{
+				close(fd);
+				fd = -1;
+				break;
+			}
+			watched[std::make_pair(wd, name)] = i;
+		}
+#endif
+	}
+
+	~file_watch()
+	{
+#ifdef __linux__
+		if (fd >= 0)
+			close(fd);
+#endif
+	}
+
+	file_watch(const file_watch&) = delete;
+	file_watch& operator=(const file_watch&) = delete;
+
+	// inotify in use, else polling
+	bool notified() const { return fd >= 0; }
+
+	//--------------------------------------------------------------------
+	// blocks until at least one of the files changed, then waits until
+	// quiet_ms pass without a further event (one save can be several
+	// writes); returns the changed files by index, every one once
+	//--------------------------------------------------------------------
+	std::vector<int> wait(int quiet_ms = 50)
+	{
+		std::vector<char> changed(files.size(), 0);
+		bool any = false;
+		while (!any)
+		{
+			any = next(-1, changed);
+			while (any && next(quiet_ms, changed))
+				;
+		}
+		std::vector<int> res;
+		for (size_t i = 0; i < files.size(); i++)
+		{
+			if (changed[i])
+				res.push_back(i);
+		}
+		return res;
+	}
+
+private:
+	typedef std::pair<long long, long long> file_stamp;	// size, mtime in ns
+
+	static file_stamp stamp(const std::string& file)
+	{
+		struct stat st;
+		if (stat(file.c_str(), &st) != 0)
+			return file_stamp(-1, -1);
+#ifdef __linux__
+		return file_stamp(st.st_size, st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec);
+#else
+		return file_stamp(st.st_size, st.st_mtime * 1000000000LL);
+#endif
+	}
+
+	static void split(const std::string& file, std::string& dir, std::string& name)
+	{
+		auto pos = file.find_last_of('/');
+		dir = pos == std::string::npos ? "." : (pos == 0 ? "/" : file.substr(0, pos));
+		name = pos == std::string::npos ? file : file.substr(pos + 1);
+	}
+
+	// events within timeout_ms (-1: no limit) into changed; false if none;
+	// a file counts as changed only if its size or time differs
+	bool next(int timeout_ms, std::vector<char>& changed)
+	{
+		bool got = false;
+#ifdef __linux__
+		if (fd >= 0)
+		{
+			struct pollfd p = { fd, POLLIN, 0 };
+			if (poll(&p, 1, timeout_ms) <= 0)
+				return false;
+			alignas(struct inotify_event) char buf[16 * (sizeof(struct inotify_event) + NAME_MAX + 1)];
+			ssize_t n = read(fd, buf, sizeof(buf));
+			for (ssize_t pos = 0; pos < n;)
+			{
+				const struct inotify_event* e = (const struct inotify_event*)(buf + pos);
+				pos += sizeof(struct inotify_event) + e->len;
+				if (e->len == 0)
+					continue;
+				auto it = watched.find(std::make_pair(e->wd, std::string(e->name)));
+				if (it != watched.end())
+					got |= check(it->second, changed);
+			}
+			// events of other files in the directories: wait on
+			return got || timeout_ms < 0 ? got : next(timeout_ms, changed);
+		}
+#endif
+		// polling: every 200 ms, timeout rounded up
+		int waited = 0;
+		do
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(200));
+			waited += 200;
+			for (size_t i = 0; i < files.size(); i++)
+				got |= check(i, changed);
+		} while (!got && (timeout_ms < 0 || waited < timeout_ms));
+		return got;
+	}
+
+	bool check(size_t i, std::vector<char>& changed)
+	{
+		file_stamp now = stamp(files[i]);
+		if (now == stamps[i])
+			return false;
+		stamps[i] = now;
+		changed[i] = 1;
+		return true;
+	}
+
+	std::vector<std::string> files;
+	std::vector<file_stamp> stamps;
+	int fd = -1;
+	std::map<std::pair<int, std::string>, size_t> watched;
+};
+
+//------------------------------------------------------------------------
+// output by write(temporary name), then renamed to file; the temporary
+// name keeps the extension (png/ppm/gz by name); false if either failed
+//------------------------------------------------------------------------
+inline bool replace_file(const std::string& file, std::function<bool(const std::string&)> write)
+{
+	auto slash = file.find_last_of('/');
+	auto dot = file.find_last_of('.');
+	if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+		dot = file.size();
+	std::string tmp = file.substr(0, dot) + ".tmp" + file.substr(dot);
+	if (!write(tmp) || rename(tmp.c_str(), file.c_str()) != 0)
+	{
+		remove(tmp.c_str());
+		return false;
+	}
+	return true;
+}
+
+#endif
@@ -0,0 +1,97 @@
+//========================================================================
+// Name        : fplot_idents.h
+// Author      : Michael Knoerzer
+// Version     : 1.0 (2026-10-18)
+// Copyright   : Copyright (c) 2026
+// Description : WRPLOT idents for an f over lambda plot (same output as
+//             : toss_to_fplot) from an in-memory level/line table
+//             : C++11 !
+//========================================================================
+#ifndef FPLOT_IDENTS_H
+#define FPLOT_IDENTS_H
+
+#include <string>
+#include <vector>
+#include <sstream>
+#include <ostream>
+#include <iomanip>
+#include <algorithm>
+#include <math.h>
+#include "atomic_data.h"
+#include "diagnostics.h"
+
+struct fplot_ident
+{
+	double wvl;
+	double f;
+	std::string loggf;	// label
+
+	bool operator<(const fplot_ident& o) const
+	{
+		if (wvl != o.wvl)
+			return wvl < o.wvl;
+		if (f != o.f)
+			return f < o.f;
+		return loggf < o.loggf;
+	}
+};
+
+// f-value of one line from log gf; false (and info for the diagnostics)
+// if f from log gf and from gA deviate by more than 50%
+inline bool make_fplot_ident(double wvl, double j_low, double loggf, double gA, fplot_ident& id, std::string& info)
+{
+	int g_low = (2 * j_low) + 1;
+	double f = pow(10, loggf) / g_low;
+	double f2 = gA * gf_to_gA * wvl * wvl / g_low;
+	double ratio = f / f2;
+	double diff = fabs(1 - ratio);
+	if (diff > 0.5)
+	{
+		std::stringstream ss;
+		ss << std::fixed << std::setprecision(4);
+		ss << wvl << " gA:" << gA << " f:" << f << " f2:" << f2 << " ratio:" << ratio << " diff:" << diff << " jlow:" << j_low << " glow:" << g_low;
+		info = ss.str();
+		return false;
+	}
+	id.wvl = wvl;
+	id.f = f;
+	id.loggf = std::to_string(loggf);
+	return true;
+}
+
+// idents of all lines of a table, sorted by wavelength
+inline std::vector<fplot_ident> make_fplot_idents(const atomic_data& data, diagnostics& diag)
+{
+	std::vector<fplot_ident> res;
+	res.reserve(data.lines.size());
+	fplot_ident id;
+	std::string info;
+	for (const auto& t : data.transitions())
+	{
+		if (make_fplot_ident(t.line.wvl, t.low.J, t.line.loggf, t.line.gA, id, info))
+			res.push_back(id);
+		else
+			diag.report("deviating f-value/gA", info);
+	}
+	std::sort(res.begin(), res.end());
+	return res;
+}
+
+// ident length in cm, or in units of the y axis (asUnit)
+template<class It>
+inline void write_fplot(std::ostream& out, It first, It last, double scale = 1.0, bool asUnit = false)
+{
+	out << std::fixed << std::setprecision(4);
+	for (; first != last; ++first)
+	{
+		out << "\\IDLENG " << first->f * scale << (asUnit ? "U" : "") << "\n";
+		out << "\\IDENT  " << first->wvl << "    " << first->loggf << "\n";
+	}
+}
+
+inline void write_fplot(std::ostream& out, const std::vector<fplot_ident>& idents, double scale = 1.0, bool asUnit = false)
+{
+	write_fplot(out, idents.begin(), idents.end(), scale, asUnit);
+}
+
+#endif
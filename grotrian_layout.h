@@ -0,0 +1,1058 @@
+//========================================================================
+// Name        : grotrian_layout.h
+// Author      : Michael Knoerzer
+// Version     : 1.0 (2026-10-18)
+// Copyright   : Copyright (c) 2026
+// Description : Layout of a Grotrian diagram (same columns, positions
+//             : and WRPLOT output as toss_to_grotrian/tmad_to_grotrian)
+//             : from parsed levels or an in-memory level/line table,
+//             : lines are matched by level index, not by printed energy;
+//             : energy windows (zoom) as panels of their own, plots can
+//             : be placed side by side (panel) for series of ions
+//             : C++11 !
+//========================================================================
+#ifndef GROTRIAN_LAYOUT_H
+#define GROTRIAN_LAYOUT_H
+
+#include <string>
+#include <vector>
+#include <sstream>
+#include <ostream>
+#include <iomanip>
+#include <algorithm>
+#include <cctype>
+#include <map>
+#include <unordered_map>
+#include <tuple>
+#include <thread>
+#include <atomic>
+#include <math.h>
+#include "atomic_data.h"
+#include "diagnostics.h"
+
+// angular momentum letters, index = l
+const std::string grotrian_L_letters = "SPDFGHIKLMNOQRTUVWXYZ";
+
+// l from a letter, -1 if unknown
+inline int grotrian_det_L(char c)
+{
+	auto pos = grotrian_L_letters.find((char)toupper(c));
+	return pos == std::string::npos ? -1 : (int)pos;
+}
+
+inline std::string grotrian_get_L(int l)
+{
+	if (l < 0 || l >= (int)grotrian_L_letters.size())
+		return "?";
+	return grotrian_L_letters.substr(l, 1);
+}
+
+// last subshell of a configuration, i.e. "2s2.2p2.(3P).3d" -> "3d",
+// at most 3 characters like the level names of toss_to_grotrian
+inline std::string grotrian_short_conf(const std::string& config)
+{
+	for (int i = (int)config.size() - 2; i >= 0; i--)
+	{
+		if (!isdigit(config[i]) || !islower(config[i + 1]))
+			continue;
+		int start = i;
+		while (start > 0 && isdigit(config[start - 1]))
+			start--;
+		return config.substr(start, 3);
+	}
+	std::string s = config.substr(0, 3);
+	std::transform(s.begin(), s.end(), s.begin(), ::tolower);
+	return s;
+}
+
+// one level as drawn
+struct grotrian_level
+{
+	int index;		// in the level table, -1 if none
+	int mult;
+	int n;
+	int l;
+	int p;
+	int column;		// x position in units, separators included
+	double energy;
+	std::string conf;
+};
+
+//------------------------------------------------------------------------
+// levels as columns (structure of arrays): grouping and sorting compare
+// only the columns they need and move indices, not levels; every
+// configuration is kept once, the levels refer to it by id
+//------------------------------------------------------------------------
+struct grotrian_level_table
+{
+	std::vector<int> index;
+	std::vector<int> mult;
+	std::vector<int> n;
+	std::vector<int> l;
+	std::vector<int> p;
+	std::vector<int> column;
+	std::vector<double> energy;
+	std::vector<int> conf;				// id in confs
+	std::vector<std::string> confs;		// every configuration once
+	std::unordered_map<std::string, int> conf_ids;
+
+	size_t size() const { return energy.size(); }
+	bool empty() const { return energy.empty(); }
+
+	void clear()
+	{
+		*this = grotrian_level_table();
+	}
+
+	void reserve(size_t k)
+	{
+		index.reserve(k);
+		mult.reserve(k);
+		n.reserve(k);
+		l.reserve(k);
+		p.reserve(k);
+		column.reserve(k);
+		energy.reserve(k);
+		conf.reserve(k);
+	}
+
+	void push_back(const grotrian_level& g)
+	{
+		index.push_back(g.index);
+		mult.push_back(g.mult);
+		n.push_back(g.n);
+		l.push_back(g.l);
+		p.push_back(g.p);
+		column.push_back(g.column);
+		energy.push_back(g.energy);
+		auto it = conf_ids.find(g.conf);
+		if (it == conf_ids.end())
+		{
+			it = conf_ids.emplace(g.conf, (int)confs.size()).first;
+			confs.push_back(g.conf);
+		}
+		conf.push_back(it->second);
+	}
+
+	const std::string& conf_of(size_t i) const { return confs[conf[i]]; }
+
+	// one level as struct (a copy)
+	grotrian_level row(size_t i) const
+	{
+		grotrian_level g;
+		g.index = index[i];
+		g.mult = mult[i];
+		g.n = n[i];
+		g.l = l[i];
+		g.p = p[i];
+		g.column = column[i];
+		g.energy = energy[i];
+		g.conf = conf_of(i);
+		return g;
+	}
+
+	// the given rows in this order, the configurations are shared
+	grotrian_level_table select(const std::vector<int>& rows) const
+	{
+		grotrian_level_table t;
+		gather(index, rows, t.index);
+		gather(mult, rows, t.mult);
+		gather(n, rows, t.n);
+		gather(l, rows, t.l);
+		gather(p, rows, t.p);
+		gather(column, rows, t.column);
+		gather(energy, rows, t.energy);
+		gather(conf, rows, t.conf);
+		t.confs = confs;
+		t.conf_ids = conf_ids;
+		return t;
+	}
+
+private:
+	template<class T>
+	static void gather(const std::vector<T>& from, const std::vector<int>& rows, std::vector<T>& to)
+	{
+		to.resize(rows.size());
+		for (size_t i = 0; i < rows.size(); i++)
+			to[i] = from[rows[i]];
+	}
+};
+
+// one connecting line, low/up are indices into grotrian_layout::levels
+struct grotrian_line
+{
+	int low;
+	int up;
+	double wvl;
+	double gf;
+};
+
+// columns of one multiplicity: one per (l, parity)
+struct grotrian_group
+{
+	int mult;
+	int first;		// first column
+	std::vector<std::pair<int, int>> lp;
+};
+
+// levels/configurations left out of the diagram and the style of the
+// tools: toss_to_grotrian draws levels with pen 2 and sorts the lines by
+// wavelength, tmad_to_grotrian keeps them in file order
+struct grotrian_options
+{
+	double skip_e = 9.9e+30;
+	int skip_n = 26;
+	int skip_l = 23;
+	double offset = 0.0;
+	std::vector<std::string> skip_conf;	// i.e. 3Po or 4Se
+
+	bool sort_lines = true;
+	std::string kind = "TOSS";			// "Grotrian Diagram of <kind> File"
+	int level_pen = 2;
+	int label_color = 2;
+	std::string label_size = "0.17";
+
+	std::vector<std::pair<double, double>> zoom;	// windows Emin/Emax, empty: whole diagram
+};
+
+// position of the plots on the A3 page (cm) and the energy the y axis
+// is scaled to, 0: the ionization limit of the layout
+struct grotrian_panel
+{
+	double ofs_x = 2.0;
+	double width = 38.0;
+	double top = 0.0;
+};
+
+// zoom window "Emin:Emax" in cm^-1; false if it is none
+inline bool grotrian_zoom(const std::string& s, grotrian_options& opt)
+{
+	std::stringstream ss(s);
+	double emin, emax;
+	char colon = 0;
+	if (!(ss >> emin >> colon >> emax) || colon != ':' || emin >= emax)
+		return false;
+	opt.zoom.push_back(std::make_pair(emin, emax));
+	return true;
+}
+
+struct grotrian_layout
+{
+	double ionlimit = 0.0;
+	double unit = 0.0;
+	int total = 0;						// columns incl. separators
+	std::vector<grotrian_group> groups;	// by multiplicity
+	grotrian_level_table levels;		// by group, l, energy
+	std::vector<grotrian_line> lines;	// by wavelength or as given
+
+	double low() const;
+	double high() const;
+};
+
+inline double grotrian_layout::low() const
+{
+	double e = 9.9e+30;
+	for (double x : levels.energy)
+		e = std::min(e, x);
+	return e;
+}
+
+inline double grotrian_layout::high() const
+{
+	double e = -9.9e+30;
+	for (double x : levels.energy)
+		e = std::max(e, x);
+	return e;
+}
+
+// multiplicity and l from a term like "3P", error message if it is no
+// LS term
+inline bool grotrian_term(const std::string& term, grotrian_level& g, std::string& error)
+{
+	g.mult = term.size() > 0 && isdigit(term[0]) ? term[0] - '0' : 0;
+	if (g.mult < 1 || g.mult > 9)
+	{
+		error = "Error with multiplicity";
+		return false;
+	}
+	g.l = term.size() > 1 ? grotrian_det_L(term[1]) : -1;
+	if (g.l < 0)
+	{
+		error = "Error with total angular momentum L";
+		return false;
+	}
+	return true;
+}
+
+// level of the table as drawn
+inline bool make_grotrian_level(const atomic_level& a, grotrian_level& g, std::string& error)
+{
+	// ADAMANT keeps the term in the configuration: "3s3p_3P"
+	std::string config = a.config, term = a.term;
+	auto us = config.find('_');
+	if (term.empty() && us != std::string::npos)
+	{
+		term = config.substr(us + 1);
+		config = config.substr(0, us);
+	}
+	g.energy = a.energy;
+	g.p = a.p;
+	g.conf = grotrian_short_conf(config);
+	g.n = atoi(g.conf.substr(0, 2).c_str());
+	return grotrian_term(term, g, error);
+}
+
+// energy, n, l or term excluded by the options
+inline bool grotrian_skip(double energy, int n, int l, int mult, int p, const grotrian_options& opt)
+{
+	if (energy >= opt.skip_e || n >= opt.skip_n || l >= opt.skip_l)
+		return true;
+	if (opt.skip_conf.empty())
+		return false;
+	std::string term = std::to_string(mult) + grotrian_get_L(l) + (p ? "o" : "e");
+	return std::find(opt.skip_conf.begin(), opt.skip_conf.end(), term) != opt.skip_conf.end();
+}
+
+inline bool grotrian_skip(const grotrian_level& g, const grotrian_options& opt)
+{
+	return grotrian_skip(g.energy, g.n, g.l, g.mult, g.p, opt);
+}
+
+inline bool grotrian_skip(const grotrian_level_table& t, size_t i, const grotrian_options& opt)
+{
+	return grotrian_skip(t.energy[i], t.n[i], t.l[i], t.mult[i], t.p[i], opt);
+}
+
+// one multiplicity of a layout: its levels (positions in the list of its
+// members) sorted by l and energy, and the (l, parity) columns
+struct grotrian_group_order
+{
+	int mult;
+	std::vector<int> order;
+	std::vector<std::pair<int, int>> lp;
+};
+
+// members are the positions of the levels of one multiplicity in the
+// level list, in list order
+inline grotrian_group_order order_grotrian_group(const grotrian_level_table& levels, const std::vector<int>& members)
+{
+	grotrian_group_order g;
+	g.mult = members.empty() ? 0 : levels.mult[members[0]];
+	g.order.resize(members.size());
+	for (size_t i = 0; i < members.size(); i++)
+		g.order[i] = i;
+	// l and energy of the members side by side, the sort reads nothing else
+	std::vector<std::pair<int, double>> key(members.size());
+	for (size_t i = 0; i < members.size(); i++)
+		key[i] = std::make_pair(levels.l[members[i]], levels.energy[members[i]]);
+	std::stable_sort(g.order.begin(), g.order.end(), [&](int a, int b)
+	{
+		if (key[a].first != key[b].first)
+			return key[a].first < key[b].first;
+		return key[a].second < key[b].second;
+	});
+	for (int k : g.order)
+	{
+		auto lp = std::make_pair(levels.l[members[k]], levels.p[members[k]]);
+		if (std::find(g.lp.begin(), g.lp.end(), lp) == g.lp.end())
+			g.lp.push_back(lp);
+	}
+	std::sort(g.lp.begin(), g.lp.end());
+	return g;
+}
+
+// positions of the levels of every multiplicity, by multiplicity
+inline std::map<int, std::vector<int>> grotrian_members(const grotrian_level_table& levels)
+{
+	std::map<int, std::vector<int>> members;
+	for (size_t i = 0; i < levels.size(); i++)
+		members[levels.mult[i]].push_back(i);
+	return members;
+}
+
+//------------------------------------------------------------------------
+// ordered groups -> columns (a free column between groups) and positions;
+// lines refer to the given levels and are renumbered to the drawing order
+//------------------------------------------------------------------------
+inline grotrian_layout assemble_grotrian_layout(const grotrian_level_table& levels, const std::map<int, std::vector<int>>& members,
+	const std::vector<const grotrian_group_order*>& groups, std::vector<grotrian_line> lines, double ionlimit, const grotrian_options& opt)
+{
+	grotrian_layout lay;
+	lay.ionlimit = ionlimit;
+
+	// drawing order as a permutation, the columns are gathered once
+	std::vector<int> perm, column;
+	perm.reserve(levels.size());
+	column.reserve(levels.size());
+	std::vector<int> drawn(levels.size());
+	for (const grotrian_group_order* g : groups)
+	{
+		const std::vector<int>& m = members.at(g->mult);
+		int first = lay.groups.empty() ? 0 : lay.groups.back().first + lay.groups.back().lp.size() + 1;
+		lay.groups.push_back({ g->mult, first, g->lp });
+		lay.total += 1 + g->lp.size();
+		for (int k : g->order)
+		{
+			auto lp = std::make_pair(levels.l[m[k]], levels.p[m[k]]);
+			drawn[m[k]] = perm.size();
+			perm.push_back(m[k]);
+			column.push_back(first + (std::find(g->lp.begin(), g->lp.end(), lp) - g->lp.begin()));
+		}
+	}
+	lay.levels = levels.select(perm);
+	lay.levels.column.swap(column);
+	lay.unit = lay.total > 0 ? 100.0 / lay.total : 0.0;
+
+	for (auto& t : lines)
+	{
+		t.low = drawn[t.low];
+		t.up = drawn[t.up];
+	}
+	lay.lines.swap(lines);
+	if (opt.sort_lines)
+	{
+		std::sort(lay.lines.begin(), lay.lines.end(), [](const grotrian_line& i, const grotrian_line& j)
+		{
+			if (i.wvl == j.wvl)
+				return i.gf < j.gf;
+			return i.wvl < j.wvl;
+		});
+	}
+	return lay;
+}
+
+//------------------------------------------------------------------------
+// levels -> groups of same multiplicity -> one column per (l, parity),
+// a free column between groups; lines refer to the given levels and are
+// renumbered to the drawing order
+//------------------------------------------------------------------------
+inline grotrian_layout layout_grotrian(const grotrian_level_table& levels, std::vector<grotrian_line> lines, double ionlimit, const grotrian_options& opt)
+{
+	std::map<int, std::vector<int>> members = grotrian_members(levels);
+	std::vector<grotrian_group_order> order;
+	for (const auto& m : members)
+		order.push_back(order_grotrian_group(levels, m.second));
+	std::vector<const grotrian_group_order*> groups;
+	for (const auto& g : order)
+		groups.push_back(&g);
+	return assemble_grotrian_layout(levels, members, groups, lines, ionlimit, opt);
+}
+
+//------------------------------------------------------------------------
+// layout built again after a change of the levels (watch mode): only
+// multiplicities whose levels changed are sorted again, the others keep
+// their order; the result is the same as from layout_grotrian
+//------------------------------------------------------------------------
+struct grotrian_incremental_layout
+{
+	struct group
+	{
+		std::vector<std::tuple<int, int, double>> key;	// l, parity, energy of the members
+		grotrian_group_order order;
+	};
+	std::map<int, group> groups;	// by multiplicity
+	size_t rebuilt = 0;				// groups sorted again by the last update
+
+	grotrian_layout update(const grotrian_level_table& levels, const std::vector<grotrian_line>& lines, double ionlimit, const grotrian_options& opt)
+	{
+		std::map<int, std::vector<int>> members = grotrian_members(levels);
+		std::vector<const grotrian_group_order*> order;
+		std::map<int, group> next;
+		rebuilt = 0;
+		for (const auto& m : members)
+		{
+			group g;
+			for (int i : m.second)
+				g.key.push_back(std::make_tuple(levels.l[i], levels.p[i], levels.energy[i]));
+			auto old = groups.find(m.first);
+			if (old != groups.end() && old->second.key == g.key)
+				g.order = old->second.order;
+			else
+			{
+				g.order = order_grotrian_group(levels, m.second);
+				rebuilt++;
+			}
+			next[m.first] = g;
+		}
+		groups.swap(next);
+		for (const auto& g : groups)
+			order.push_back(&g.second.order);
+		return assemble_grotrian_layout(levels, members, order, lines, ionlimit, opt);
+	}
+};
+
+// layout of a level/line table, index = level in the table; levels
+// without LS term are reported, lines whose levels are not drawn are left
+// out
+inline grotrian_layout build_grotrian_layout(const atomic_data& data, double ionlimit, const grotrian_options& opt, diagnostics& diag)
+{
+	std::vector<int> drawn(data.levels.size(), -1);
+	grotrian_level_table levels;
+	for (size_t i = 0; i < data.levels.size(); i++)
+	{
+		const atomic_level& a = data.levels[i];
+		grotrian_level g;
+		std::string error;
+		if (!make_grotrian_level(a, g, error))
+		{
+			std::stringstream ss;
+			ss << std::fixed << std::setprecision(3) << a.energy << " " << a.config << " " << a.term << " J=" << a.J;
+			diag.report(error, ss.str());
+			continue;
+		}
+		if (grotrian_skip(g, opt))
+			continue;
+		g.index = i;
+		drawn[i] = levels.size();
+		levels.push_back(g);
+	}
+
+	std::vector<grotrian_line> lines;
+	for (const auto& t : data.lines)
+	{
+		if (drawn[t.low] < 0 || drawn[t.up] < 0)
+			continue;
+		lines.push_back({ drawn[t.low], drawn[t.up], t.wvl, pow(10.0, t.loggf) });
+	}
+	return layout_grotrian(levels, lines, ionlimit, opt);
+}
+
+// the options a layout depends on (cuts, order of the lines), as text
+// for a cache key; offset, zoom and the style of the output do not count
+inline std::string grotrian_layout_signature(const grotrian_options& opt)
+{
+	std::stringstream ss;
+	ss << std::setprecision(17) << opt.skip_e << " " << opt.skip_n << " " << opt.skip_l << " " << opt.sort_lines;
+	for (const auto& c : opt.skip_conf)
+		ss << " c=" << c;
+	return ss.str();
+}
+
+//------------------------------------------------------------------------
+// layout as text and back (build cache), doubles with 17 digits so the
+// output from a stored layout is the same as from a new one
+//------------------------------------------------------------------------
+inline void write_grotrian_layout(std::ostream& out, const grotrian_layout& lay)
+{
+	out << std::setprecision(17);
+	out << "GROTRIAN-LAYOUT 1 " << lay.ionlimit << " " << lay.unit << " " << lay.total << "\n";
+	out << lay.groups.size() << "\n";
+	for (const auto& g : lay.groups)
+	{
+		out << g.mult << " " << g.first << " " << g.lp.size();
+		for (const auto& lp : g.lp)
+			out << " " << lp.first << " " << lp.second;
+		out << "\n";
+	}
+	const grotrian_level_table& t = lay.levels;
+	out << t.size() << "\n";
+	for (size_t i = 0; i < t.size(); i++)
+	{
+		out << t.index[i] << " " << t.mult[i] << " " << t.n[i] << " " << t.l[i] << " " << t.p[i] << " " << t.column[i] << " " << t.energy[i] << " ";
+		out << t.conf_of(i).size() << " " << t.conf_of(i) << "\n";
+	}
+	out << lay.lines.size() << "\n";
+	for (const auto& t : lay.lines)
+		out << t.low << " " << t.up << " " << t.wvl << " " << t.gf << "\n";
+}
+
+inline bool read_grotrian_layout(std::istream& in, grotrian_layout& lay)
+{
+	std::string magic;
+	int version;
+	size_t n;
+	if (!(in >> magic >> version >> lay.ionlimit >> lay.unit >> lay.total) || magic != "GROTRIAN-LAYOUT" || version != 1)
+		return false;
+	if (!(in >> n))
+		return false;
+	lay.groups.resize(n);
+	for (auto& g : lay.groups)
+	{
+		if (!(in >> g.mult >> g.first >> n))
+			return false;
+		g.lp.resize(n);
+		for (auto& lp : g.lp)
+			in >> lp.first >> lp.second;
+	}
+	if (!(in >> n))
+		return false;
+	size_t levels = n;
+	lay.levels.clear();
+	lay.levels.reserve(levels);
+	for (size_t i = 0; i < levels; i++)
+	{
+		grotrian_level l;
+		if (!(in >> l.index >> l.mult >> l.n >> l.l >> l.p >> l.column >> l.energy >> n) || in.get() != ' ')
+			return false;
+		l.conf.resize(n);
+		if (n > 0)
+			in.read(&l.conf[0], n);
+		lay.levels.push_back(l);
+	}
+	if (!(in >> n))
+		return false;
+	lay.lines.resize(n);
+	for (auto& t : lay.lines)
+		in >> t.low >> t.up >> t.wvl >> t.gf;
+	return !in.fail();
+}
+
+//------------------------------------------------------------------------
+// levels and lines of a layout sorted by energy, a window is then found
+// by binary search instead of testing every primitive; a line is sorted
+// once by its lower and once by its upper end
+//------------------------------------------------------------------------
+struct grotrian_energy_index
+{
+	std::vector<int> levels;		// by energy
+	std::vector<double> level_e;
+	std::vector<double> line_lo;	// lower/upper end, index = line
+	std::vector<double> line_hi;
+	std::vector<int> by_lo;			// lines by lower end
+	std::vector<double> lo_e;
+	std::vector<int> by_hi;			// lines by upper end
+	std::vector<double> hi_e;
+
+	explicit grotrian_energy_index(const grotrian_layout& lay);
+
+	// visible levels and lines (crossing or inside the window), in
+	// drawing order
+	void select(double emin, double emax, std::vector<int>& lev, std::vector<int>& lin) const;
+};
+
+inline grotrian_energy_index::grotrian_energy_index(const grotrian_layout& lay)
+{
+	auto by_key = [](const std::vector<double>& key, std::vector<int>& order, std::vector<double>& sorted)
+	{
+		order.resize(key.size());
+		for (size_t i = 0; i < order.size(); i++)
+			order[i] = i;
+		std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return key[a] < key[b]; });
+		sorted.resize(key.size());
+		for (size_t i = 0; i < order.size(); i++)
+			sorted[i] = key[order[i]];
+	};
+
+	by_key(lay.levels.energy, levels, level_e);
+
+	line_lo.resize(lay.lines.size());
+	line_hi.resize(lay.lines.size());
+	for (size_t i = 0; i < lay.lines.size(); i++)
+	{
+		double a = lay.levels.energy[lay.lines[i].low];
+		double b = lay.levels.energy[lay.lines[i].up];
+		line_lo[i] = std::min(a, b);
+		line_hi[i] = std::max(a, b);
+	}
+	by_key(line_lo, by_lo, lo_e);
+	by_key(line_hi, by_hi, hi_e);
+}
+
+inline void grotrian_energy_index::select(double emin, double emax, std::vector<int>& lev, std::vector<int>& lin) const
+{
+	auto first = std::lower_bound(level_e.begin(), level_e.end(), emin) - level_e.begin();
+	auto last = std::upper_bound(level_e.begin(), level_e.end(), emax) - level_e.begin();
+	lev.assign(levels.begin() + first, levels.begin() + last);
+	std::sort(lev.begin(), lev.end());
+
+	// lower end <= emax: a prefix of by_lo, upper end >= emin: a suffix of
+	// by_hi; the shorter one is tested for the other condition
+	size_t n_lo = std::upper_bound(lo_e.begin(), lo_e.end(), emax) - lo_e.begin();
+	size_t n_hi = hi_e.end() - std::lower_bound(hi_e.begin(), hi_e.end(), emin);
+	lin.clear();
+	if (n_lo <= n_hi)
+	{
+		for (size_t i = 0; i < n_lo; i++)
+			if (line_hi[by_lo[i]] >= emin)
+				lin.push_back(by_lo[i]);
+	}
+	else
+	{
+		for (size_t i = by_hi.size() - n_hi; i < by_hi.size(); i++)
+			if (line_lo[by_hi[i]] <= emax)
+				lin.push_back(by_hi[i]);
+	}
+	std::sort(lin.begin(), lin.end());
+}
+
+// segment clipped to emin <= y <= emax; false if nothing is left
+inline bool grotrian_clip(double& x1, double& y1, double& x2, double& y2, double emin, double emax)
+{
+	if (std::max(y1, y2) < emin || std::min(y1, y2) > emax)
+		return false;
+	if (y1 == y2)
+		return true;
+	auto at = [&](double y) { return x1 + (x2 - x1) * (y - y1) / (y2 - y1); };
+	double nx1 = x1, ny1 = y1, nx2 = x2, ny2 = y2;
+	if (y1 < emin) { nx1 = at(emin); ny1 = emin; }
+	if (y1 > emax) { nx1 = at(emax); ny1 = emax; }
+	if (y2 < emin) { nx2 = at(emin); ny2 = emin; }
+	if (y2 > emax) { nx2 = at(emax); ny2 = emax; }
+	x1 = nx1; y1 = ny1; x2 = nx2; y2 = ny2;
+	return true;
+}
+
+// 1, 2 or 5 times a power of ten, at least x
+inline double grotrian_step(double x)
+{
+	double p = pow(10.0, floor(log10(x)));
+	if (p >= x)
+		return p;
+	if (2 * p >= x)
+		return 2 * p;
+	if (5 * p >= x)
+		return 5 * p;
+	return 10 * p;
+}
+
+//------------------------------------------------------------------------
+// plots of one energy window: same columns and style as the whole
+// diagram, y axis from emin to emax; only the levels inside and the lines
+// crossing the window are written, lines are cut at its edges
+//------------------------------------------------------------------------
+inline void write_grotrian_window_plots(std::ostream& out, const grotrian_layout& lay, const grotrian_energy_index& idx,
+	const std::string& title, const grotrian_options& opt, double emin, double emax, const grotrian_panel& panel)
+{
+	const double ionlimit = lay.ionlimit;
+	const double unit = lay.unit;
+	std::vector<int> lev, lin;
+	idx.select(emin, emax, lev, lin);
+
+	out << std::fixed << std::setprecision(2);
+	out << "** window: " << emin << " - " << emax << std::endl;
+	out << "** levels in window: " << lev.size() << " of " << lay.levels.size() << std::endl;
+	out << "** lines in window: " << lin.size() << " of " << lay.lines.size() << std::endl << std::endl;
+
+	out << "PLOT: labels" << std::endl;
+	out << "\\OFS " << std::setprecision(1) << panel.ofs_x << " 2.0" << std::setprecision(2) << std::endl;
+	out << "\\INBOX" << std::endl;
+	out << "\\PEN 1" << std::endl;
+	out << "\\FONT=HELVET" << std::endl;
+	out << "\\LETTERSIZE=0.25" << std::endl;
+	out << "\\NOCOPYRIGHT" << std::endl;
+	out << "\\LUN 50.0 YMAX -2.9 0.9 0.30 Grotrian diagram of " << title << ", " << emin << " - " << emax << " cm&H-1&M" << std::endl;
+	out << "HEADER :\\CENTER\\" << std::endl;
+	out << "X-ACHSE:\\CENTER\\" << std::endl;
+	out << "Y-ACHSE:\\CENTER\\ energy / 1000 cm&H-1&M" << std::endl;
+	out << "    MASSTAB       MINIMUM       MAXIMUM    TEILUNGEN     BESCHRIFT.    DARUNTER" << std::endl;
+	out << "X: " << panel.width << "CM              0.0         100.0         10.0          10            0.0 NOLAB NOTICK-BOTH" << std::endl;
+	out << std::setprecision(3);
+	out << "Y: 25.70CM            " << emin / 1000 << "        " << emax / 1000 << "         ";
+	out << grotrian_step((emax - emin) / 1000 / 20) << "           " << grotrian_step((emax - emin) / 1000 / 5) << "            0.0" << std::endl;
+	out << std::setprecision(2);
+	out << "N=  ?  PLOTSYMBOL 9 SYMBOLSIZE 0.1 PEN 1 XYTABLE SELECT 1 2 COLOR=1" << std::endl;
+	out << "FINISH" << std::endl;
+	out << "END" << std::endl << std::endl;
+
+	out << "PLOT: Grotrian Diagram of " << opt.kind << " File: " << title << std::endl;
+	out << "\\OFS " << std::setprecision(1) << panel.ofs_x << " 2.0" << std::setprecision(2) << std::endl;
+	out << "\\INBOX" << std::endl;
+	out << "\\PEN 1" << std::endl;
+	out << "\\FONT=HELVET" << std::endl;
+	out << "\\LETTERSIZE=0.25" << std::endl;
+	out << "\\NOCOPYRIGHT" << std::endl;
+	out << "HEADER :\\CENTER\\" << std::endl;
+	out << "X-ACHSE:\\CENTER\\" << std::endl;
+	out << "Y-ACHSE:\\CENTER\\" << std::endl;
+	out << "    MASSTAB       MINIMUM       MAXIMUM    TEILUNGEN     BESCHRIFT.    DARUNTER" << std::endl;
+	out << "X: " << panel.width << "CM              0.0         100.0         10.0          10            0.0 NOTICK-BOTH" << std::endl;
+	out << "Y: 25.70CM         " << emin << "      " << emax << "      10000        100000            0.0 NOTICK-BOTH" << std::endl;
+	out << "N=  ?  PLOTSYMBOL 9 SYMBOLSIZE 0.1 PEN 1 XYTABLE SELECT 1 2 COLOR=1" << std::endl;
+	if (ionlimit >= emin && ionlimit <= emax)
+	{
+		out << "0 " << ionlimit << std::endl;
+		out << "100 " << ionlimit << std::endl;
+	}
+	out << "FINISH" << std::endl;
+	out << "** ionization limit: " << ionlimit << std::endl << std::endl;
+
+	if (lin.empty())
+	{
+		out << "** found no lines **" << std::endl;
+	}
+	else
+	{
+		out << "** connecting lines: **" << std::endl;
+		out << "\\DEFINECOLOR 9 0.6 0.6 0.6" << std::endl;
+		out << "\\PEN=1" << std::endl;
+		out << "\\COLOR=9" << std::endl;
+		size_t clipped = 0;
+		for (int i : lin)
+		{
+			const grotrian_line& t = lay.lines[i];
+			const grotrian_level_table& lv = lay.levels;
+			double x1 = unit * (lv.column[t.low] + 0.85), y1 = lv.energy[t.low];
+			double x2 = unit * (lv.column[t.up] + 0.85), y2 = lv.energy[t.up];
+			if (!grotrian_clip(x1, y1, x2, y2, emin, emax))
+				continue;
+			if (y1 != lv.energy[t.low] || y2 != lv.energy[t.up])
+				clipped++;
+			out << "\\LINUN " << x1 << " " << y1 << " " << x2 << " " << y2 << " 0.0 0.0" << std::endl;
+		}
+		out << "\\COLOR=1" << std::endl;
+		out << "** total # lines: " << lin.size() << " (" << clipped << " clipped) " << std::endl;
+		out << "** end connecting lines **" << std::endl << std::endl;
+	}
+
+	out << "** start levels **" << std::endl;
+	out << "\\PEN=" << opt.level_pen << std::endl;
+	out << "\\COLOR=1" << std::endl;
+	for (int i : lev)
+	{
+		double xlevelpos = unit * (lay.levels.column[i] + 0.5 + 0.5) + opt.offset * unit;
+		double e = lay.levels.energy[i];
+		out << "\\LINUN " << (xlevelpos - unit * 0.3) << " " << e << " " << (xlevelpos) << " " << e << " 0.0 0.0" << std::endl;
+	}
+	out << "** total # levels: " << lev.size() << " " << std::endl;
+	out << "** end levels **" << std::endl << std::endl;
+
+	out << "** start inside labels **" << std::endl;
+	out << "\\COLOR=" << opt.label_color << std::endl;
+	out << std::setprecision(3);
+	for (int i : lev)
+	{
+		double xlevelpos = unit * (lay.levels.column[i] + 0.5 + 0.5) + opt.offset * unit;
+		out << "\\LUN " << (xlevelpos + unit * 0.1) << " " << lay.levels.energy[i] << " -0.0 -0.05 " << opt.label_size << " " << lay.levels.conf_of(i) << std::endl;
+	}
+	out << "\\COLOR=1" << std::endl;
+	out << "** total # inside labels: " << lev.size() << " " << std::endl;
+	out << "** end inside labels **" << std::endl << std::endl;
+
+	// top labels, separators and S= as in the whole diagram, S= above the
+	// top labels since the ionization limit may be outside
+	out << "** start top labels **" << std::endl;
+	out << "\\PEN=5" << std::endl;
+	out << "\\COLOR=1" << std::endl << std::setprecision(2);
+	std::stringstream ss_seps;
+	ss_seps << std::fixed << std::setprecision(1);
+	size_t labels = 0;
+	for (const auto& grp : lay.groups)
+	{
+		int width = grp.lp.size();
+		int before = grp.first;
+		double xpos = unit * (0.5 + before + width + 0.5);
+		if (xpos < 100)
+			ss_seps << "\\LINUN " << xpos << " YMIN " << xpos << " YMAX 0.0 0.0 SIZE=0.1 SYMBOL=9" << std::endl;
+		ss_seps << "\\LUN " << (unit * before + (unit * width * 0.5) + unit * 0.5) << " YMAX -0.2 0.45 0.20 S=" << ((grp.mult - 1.0) * 0.5) << std::endl;
+		for (size_t j = 0; j < grp.lp.size(); j++, labels++)
+		{
+			double xlabelpos = unit * (before + j + 0.5 + 0.4);
+			out << "\\LUN " << xlabelpos << " YMAX 0.000 0.080 0.2 " << "&H" << grp.mult << "&M" << grotrian_get_L(grp.lp[j].first) << (grp.lp[j].second == 0 ? "" : "&Ho&M") << std::endl;
+		}
+	}
+	out << "\\PEN=1" << std::endl;
+	out << "** total # top labels: " << labels << " " << std::endl;
+	out << "** end top labels **" << std::endl << std::endl;
+
+	out << "** start separators ** " << std::endl;
+	out << ss_seps.str();
+	out << "** end separators ** " << std::endl << std::endl;
+
+	out << "END" << std::endl;
+}
+
+//------------------------------------------------------------------------
+// plots of the whole diagram, y axis up to the ionization limit (or the
+// top of the panel) plus 2%
+//------------------------------------------------------------------------
+inline void write_grotrian_plots(std::ostream& out, const grotrian_layout& lay, const std::string& title, const grotrian_options& opt, const grotrian_panel& panel)
+{
+	const double ionlimit = panel.top > 0.0 ? panel.top : lay.ionlimit;
+	const double unit = lay.unit;
+	const double yoffset = ionlimit * 0.02;
+
+	out << std::fixed << std::setprecision(2);
+	out << "** y min/max: " << lay.low() << "/" << lay.high() << std::endl;
+	out << "** y offset: " << yoffset << std::endl << std::endl;
+
+	out << "PLOT: labels" << std::endl;
+	out << "\\OFS " << std::setprecision(1) << panel.ofs_x << " 2.0" << std::setprecision(2) << std::endl;
+	out << "\\INBOX" << std::endl;
+	out << "\\PEN 1" << std::endl;
+	out << "\\FONT=HELVET" << std::endl;
+	out << "\\LETTERSIZE=0.25" << std::endl;
+	out << "\\NOCOPYRIGHT" << std::endl;
+	out << "\\LUN 50.0 " << (ionlimit + 2 * yoffset) / 1000 * 1.03 << " -2.9 0.0 0.30 Grotrian diagram of " << title << std::endl;
+	out << "HEADER :\\CENTER\\" << std::endl;
+	out << "X-ACHSE:\\CENTER\\" << std::endl;
+	out << "Y-ACHSE:\\CENTER\\ energy / 1000 cm&H-1&M" << std::endl;
+	out << "    MASSTAB       MINIMUM       MAXIMUM    TEILUNGEN     BESCHRIFT.    DARUNTER" << std::endl;
+	out << "X: " << panel.width << "CM              0.0         100.0         10.0          10            0.0 NOLAB NOTICK-BOTH" << std::endl;
+	out << "Y: 25.70CM            " << (-yoffset) / 1000 << "        " << (ionlimit + 2 * yoffset) / 1000 << "         ";
+	out << (ionlimit < 1.0e+6 ? 10 : (ionlimit < 8.0e+6 ? 50 : (ionlimit < 16.0e+6 ? 100 : 200))) << "           ";
+	out << (ionlimit < 1.0e+6 ? 100 : (ionlimit < 8.0e+6 ? 500 : (ionlimit < 16.0e+6 ? 1000 : 2000))) << "            0.0" << std::endl;
+	out << "N=  ?  PLOTSYMBOL 9 SYMBOLSIZE 0.1 PEN 1 XYTABLE SELECT 1 2 COLOR=1" << std::endl;
+	out << "FINISH" << std::endl;
+	out << "END" << std::endl << std::endl;
+
+	out << "PLOT: Grotrian Diagram of " << opt.kind << " File: " << title << std::endl;
+	out << "\\OFS " << std::setprecision(1) << panel.ofs_x << " 2.0" << std::setprecision(2) << std::endl;
+	out << "\\INBOX" << std::endl;
+	out << "\\PEN 1" << std::endl;
+	out << "\\FONT=HELVET" << std::endl;
+	out << "\\LETTERSIZE=0.25" << std::endl;
+	out << "\\NOCOPYRIGHT" << std::endl;
+	out << "HEADER :\\CENTER\\" << std::endl;
+	out << "X-ACHSE:\\CENTER\\" << std::endl;
+	out << "Y-ACHSE:\\CENTER\\" << std::endl;
+	out << "    MASSTAB       MINIMUM       MAXIMUM    TEILUNGEN     BESCHRIFT.    DARUNTER" << std::endl;
+	out << "X: " << panel.width << "CM              0.0         100.0         10.0          10            0.0 NOTICK-BOTH" << std::endl;
+	out << "Y: 25.70CM         " << (-yoffset) << "      " << (ionlimit + 2 * yoffset) << "      10000        100000            0.0 NOTICK-BOTH" << std::endl;
+	out << "N=  ?  PLOTSYMBOL 9 SYMBOLSIZE 0.1 PEN 1 XYTABLE SELECT 1 2 COLOR=1" << std::endl;
+	out << "0 " << lay.ionlimit << std::endl;
+	out << "100 " << lay.ionlimit << std::endl;
+	out << "FINISH" << std::endl;
+	out << "** ionization limit: " << lay.ionlimit << std::endl << std::endl;
+
+	std::stringstream ss_levels, ss_labels, ss_top, ss_seps;
+	ss_levels << std::fixed << std::setprecision(2);
+	ss_labels << std::fixed << std::setprecision(3);
+	ss_top << std::fixed << std::setprecision(2);
+	ss_seps << std::fixed << std::setprecision(1);
+
+	size_t k = 0;
+	for (const auto& grp : lay.groups)
+	{
+		// separator right of the group, label centered above it
+		int width = grp.lp.size();
+		int before = grp.first;
+		double xpos = unit * (0.5 + before + width + 0.5);
+		if (xpos < 100)
+			ss_seps << "\\LINUN " << xpos << " YMIN " << xpos << " YMAX 0.0 0.0 SIZE=0.1 SYMBOL=9" << std::endl;
+		ss_seps << "\\LUN " << (unit * before + (unit * width * 0.5) + unit * 0.5) << " " << lay.ionlimit + yoffset * 0.4 << " -0.2 0.0 0.20 S=" << ((grp.mult - 1.0) * 0.5) << std::endl;
+
+		// top labels
+		for (size_t j = 0; j < grp.lp.size(); j++)
+		{
+			double xlabelpos = unit * (before + j + 0.5 + 0.4);
+			ss_top << "\\LUN " << xlabelpos << " YMAX 0.000 0.080 0.2 " << "&H" << grp.mult << "&M" << grotrian_get_L(grp.lp[j].first) << (grp.lp[j].second == 0 ? "" : "&Ho&M") << std::endl;
+		}
+		// levels, 0.3 units wide, label to the right
+		for (; k < lay.levels.size() && lay.levels.mult[k] == grp.mult; k++)
+		{
+			double xlevelpos = unit * (lay.levels.column[k] + 0.5 + 0.5) + opt.offset * unit;
+			double e = lay.levels.energy[k];
+			ss_levels << "\\LINUN " << (xlevelpos - unit * 0.3) << " " << e << " " << (xlevelpos) << " " << e << " 0.0 0.0" << std::endl;
+			ss_labels << "\\LUN " << (xlevelpos + unit * 0.1) << " " << e << " -0.0 -0.05 " << opt.label_size << " " << lay.levels.conf_of(k) << std::endl;
+		}
+	}
+	out << std::setprecision(3);
+
+	if (lay.lines.empty())
+	{
+		out << "** found no lines **" << std::endl;
+	}
+	else
+	{
+		// 0.15 units left of the right end of the level lines; the end at
+		// a level is the same for all of its lines, formatted only once
+		std::vector<std::string> ends(lay.levels.size());
+		std::stringstream ss;
+		ss << std::fixed << std::setprecision(2);
+		for (size_t i = 0; i < lay.levels.size(); i++)
+		{
+			ss.str("");
+			ss << unit * (lay.levels.column[i] + 0.85) << " " << lay.levels.energy[i];
+			ends[i] = ss.str();
+		}
+		std::string sslines;
+		sslines.reserve(lay.lines.size() * 48);
+		for (const auto& t : lay.lines)
+		{
+			sslines += "\\LINUN ";
+			sslines += ends[t.low];
+			sslines += ' ';
+			sslines += ends[t.up];
+			sslines += " 0.0 0.0\n";
+		}
+		out << "** connecting lines: **" << std::endl;
+		out << "\\DEFINECOLOR 9 0.6 0.6 0.6" << std::endl;
+		out << "\\PEN=1" << std::endl;
+		out << "\\COLOR=9" << std::endl;
+		out << sslines;
+		out << "\\COLOR=1" << std::endl;
+		out << "** total # lines: " << lay.lines.size() << " " << std::endl;
+		out << "** end connecting lines **" << std::endl << std::endl;
+	}
+
+	out << "** start levels **" << std::endl;
+	out << "\\PEN=" << opt.level_pen << std::endl;
+	out << "\\COLOR=1" << std::endl;
+	out << ss_levels.str();
+	out << "** total # levels: " << lay.levels.size() << " " << std::endl;
+	out << "** end levels **" << std::endl << std::endl;
+
+	out << "** start inside labels **" << std::endl;
+	out << "\\COLOR=" << opt.label_color << std::endl;
+	out << ss_labels.str();
+	out << "\\COLOR=1" << std::endl;
+	out << "** total # inside labels: " << lay.levels.size() << " " << std::endl;
+	out << "** end inside labels **" << std::endl << std::endl;
+
+	size_t labels = 0;
+	for (const auto& grp : lay.groups)
+		labels += grp.lp.size();
+	out << "** start top labels **" << std::endl;
+	out << "\\PEN=5" << std::endl;
+	out << "\\COLOR=1" << std::endl;
+	out << ss_top.str();
+	out << "\\PEN=1" << std::endl;
+	out << "** total # top labels: " << labels << " " << std::endl;
+	out << "** end top labels **" << std::endl << std::endl;
+
+	out << "** start separators ** " << std::endl;
+	out << ss_seps.str();
+	out << "** end separators ** " << std::endl << std::endl;
+
+	out << "END" << std::endl;
+}
+
+//------------------------------------------------------------------------
+// WRPLOT input, style from the options; with zoom windows one MULTIPLOT
+// per window instead of the whole diagram
+//------------------------------------------------------------------------
+inline void write_grotrian(std::ostream& out, const grotrian_layout& lay, const std::string& title, const grotrian_options& opt)
+{
+	if (opt.zoom.empty())
+	{
+		out << std::endl << "PAPERFORMAT A3Q" << std::endl;
+		out << "MULTIPLOT START" << std::endl;
+		write_grotrian_plots(out, lay, title, opt, grotrian_panel());
+		out << "MULTIPLOT END" << std::endl << std::endl;
+		return;
+	}
+	grotrian_energy_index idx(lay);
+	for (const auto& w : opt.zoom)
+	{
+		out << std::endl << "PAPERFORMAT A3Q" << std::endl;
+		out << "MULTIPLOT START" << std::endl;
+		write_grotrian_window_plots(out, lay, idx, title, opt, w.first, w.second, grotrian_panel());
+		out << "MULTIPLOT END" << std::endl << std::endl;
+	}
+}
+
+//------------------------------------------------------------------------
+// several layouts at once (sweep variants, ions of a series), compile
+// with -pthread where it is used
+//------------------------------------------------------------------------
+// f(i) for all i < n on up to threads workers (the calling thread is one
+// of them), every i exactly once
+template<class F>
+inline void grotrian_parallel(size_t n, unsigned threads, F f)
+{
+	std::atomic<size_t> next(0);
+	auto work = [&]()
+	{
+		size_t i;
+		while ((i = next++) < n)
+			f(i);
+	};
+	std::vector<std::thread> pool;
+	for (unsigned w = 1; w < std::min<size_t>(std::max(1u, threads), n); w++)
+		pool.push_back(std::thread(work));
+	work();
+	for (auto& t : pool)
+		t.join();
+}
+
+#endif
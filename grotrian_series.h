@@ -0,0 +1,81 @@
+//========================================================================
+// Name        : grotrian_series.h
+// Author      : Michael Knoerzer
+// Version     : 1.0 (2026-10-18)
+// Copyright   : Copyright (c) 2026
+// Description : Grotrian diagrams of a series of ions (i.e. SI10-SI14)
+//             : in one MULTIPLOT: one panel per ion side by side, each
+//             : with its own energy scale or all on the highest one;
+//             : the ions are read and laid out on worker threads
+//             : compile with -pthread
+//             : C++11 !
+//========================================================================
+#ifndef GROTRIAN_SERIES_H
+#define GROTRIAN_SERIES_H
+
+#include <string>
+#include <vector>
+#include <ostream>
+#include <algorithm>
+#include "grotrian_layout.h"
+
+// panels of n ions on the 38 cm of the page, 1.5 cm between them for the
+// labels of the energy axis
+inline std::vector<grotrian_panel> grotrian_series_panels(const std::vector<grotrian_layout>& lays, bool shared)
+{
+	const double gap = 1.5;
+	const size_t n = lays.size();
+	double top = 0.0;
+	for (const auto& lay : lays)
+		top = std::max(top, lay.ionlimit);
+
+	std::vector<grotrian_panel> panels(n);
+	for (size_t i = 0; i < n; i++)
+	{
+		panels[i].width = (38.0 - gap * (n - 1)) / n;
+		panels[i].ofs_x = 2.0 + i * (panels[i].width + gap);
+		panels[i].top = shared ? top : 0.0;
+	}
+	return panels;
+}
+
+//------------------------------------------------------------------------
+// WRPLOT input of a series, one MULTIPLOT with a panel per ion; with zoom
+// windows one MULTIPLOT per window, every ion cut to the same window
+//------------------------------------------------------------------------
+inline void write_grotrian_series(std::ostream& out, const std::vector<grotrian_layout>& lays, const std::vector<std::string>& titles,
+	const grotrian_options& opt, bool shared)
+{
+	std::vector<grotrian_panel> panels = grotrian_series_panels(lays, shared);
+	if (opt.zoom.empty())
+	{
+		out << std::endl << "PAPERFORMAT A3Q" << std::endl;
+		out << "MULTIPLOT START" << std::endl;
+		for (size_t i = 0; i < lays.size(); i++)
+		{
+			out << "** ion " << (i + 1) << " of " << lays.size() << ": " << titles[i] << std::endl;
+			write_grotrian_plots(out, lays[i], titles[i], opt, panels[i]);
+			out << std::endl;
+		}
+		out << "MULTIPLOT END" << std::endl << std::endl;
+		return;
+	}
+
+	std::vector<grotrian_energy_index> idx;
+	for (const auto& lay : lays)
+		idx.push_back(grotrian_energy_index(lay));
+	for (const auto& w : opt.zoom)
+	{
+		out << std::endl << "PAPERFORMAT A3Q" << std::endl;
+		out << "MULTIPLOT START" << std::endl;
+		for (size_t i = 0; i < lays.size(); i++)
+		{
+			out << "** ion " << (i + 1) << " of " << lays.size() << ": " << titles[i] << std::endl;
+			write_grotrian_window_plots(out, lays[i], idx[i], titles[i], opt, w.first, w.second, panels[i]);
+			out << std::endl;
+		}
+		out << "MULTIPLOT END" << std::endl << std::endl;
+	}
+}
+
+#endif
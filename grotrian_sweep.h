@@ -0,0 +1,146 @@
+//========================================================================
+// Name        : grotrian_sweep.h
+// Author      : Michael Knoerzer
+// Version     : 1.0 (2026-10-18)
+// Copyright   : Copyright (c) 2026
+// Description : Parameter sweep for the Grotrian tools: the levels/lines
+//             : are read once, every filter set (e, n, l, c, off) gets
+//             : its own layout and output file, built on worker threads
+//             : which share the read-only tables
+//             : compile with -pthread
+//             : C++11 !
+//========================================================================
+#ifndef GROTRIAN_SWEEP_H
+#define GROTRIAN_SWEEP_H
+
+#include <string>
+#include <vector>
+#include <sstream>
+#include <fstream>
+#include <algorithm>
+#include "grotrian_layout.h"
+#include "compressed_stream.h"
+
+// one variant: output file and options
+struct grotrian_variant
+{
+	std::string file;
+	grotrian_options opt;
+};
+
+// e=, n=, l=, c=, off=, zoom= as on the command line of the tools; false
+// if the argument is none of them
+inline bool grotrian_option(const std::string& s, grotrian_options& opt)
+{
+	std::stringstream ss(s.substr(s.find('=') + 1));
+	if (s.substr(0, 2) == "e=")
+		ss >> opt.skip_e;
+	else if (s.substr(0, 2) == "n=")
+		ss >> opt.skip_n;
+	else if (s.substr(0, 2) == "l=")
+		ss >> opt.skip_l;
+	else if (s.substr(0, 2) == "c=")
+		opt.skip_conf.push_back(ss.str());
+	else if (s.substr(0, 4) == "off=")
+		ss >> opt.offset;
+	else if (s.substr(0, 5) == "zoom=")
+		return grotrian_zoom(ss.str(), opt);
+	else
+		return false;
+	return true;
+}
+
+//------------------------------------------------------------------------
+// sweep file: one variant per line, "<output file> <options>", i.e.
+//   si4_e200k.wrp e=200000
+//   si4_low.wrp   e=120000 n=5 c=3Po
+//   si4_zoom.wrp  zoom=0:20000 zoom=150000:180000
+// the options are added to the ones of the command line; empty lines and
+// lines starting with # are skipped
+//------------------------------------------------------------------------
+inline bool read_grotrian_sweep(const std::string& file, const grotrian_options& base, std::vector<grotrian_variant>& variants, std::string& error)
+{
+	std::ifstream in(file.c_str());
+	if (!in.is_open())
+	{
+		error = "could not open sweep file: " + file;
+		return false;
+	}
+	std::string line;
+	while (getline(in, line))
+	{
+		std::stringstream ss(line);
+		grotrian_variant v;
+		v.opt = base;
+		if (!(ss >> v.file) || v.file[0] == '#')
+			continue;
+		std::string arg;
+		while (ss >> arg)
+		{
+			if (!grotrian_option(arg, v.opt))
+			{
+				error = "unknown option in sweep file: " + arg;
+				return false;
+			}
+		}
+		variants.push_back(v);
+	}
+	return true;
+}
+
+// levels passing the options and the lines between two of them; lines
+// refer to the given levels
+inline grotrian_layout layout_grotrian_variant(const grotrian_level_table& levels, const std::vector<grotrian_line>& lines, double ionlimit, const grotrian_options& opt)
+{
+	std::vector<int> kept(levels.size(), -1);
+	std::vector<int> rows;
+	for (size_t i = 0; i < levels.size(); i++)
+	{
+		if (grotrian_skip(levels, i, opt))
+			continue;
+		kept[i] = rows.size();
+		rows.push_back(i);
+	}
+	grotrian_level_table sel = levels.select(rows);
+	std::vector<grotrian_line> sel_lines;
+	for (const auto& t : lines)
+	{
+		if (kept[t.low] < 0 || kept[t.up] < 0)
+			continue;
+		sel_lines.push_back({ kept[t.low], kept[t.up], t.wvl, t.gf });
+	}
+	return layout_grotrian(sel, sel_lines, ionlimit, opt);
+}
+
+//------------------------------------------------------------------------
+// all variants on up to threads workers, each one writes its own file;
+// returns the number of variants written, failed files are in failed
+//------------------------------------------------------------------------
+inline int run_grotrian_sweep(const grotrian_level_table& levels, const std::vector<grotrian_line>& lines, double ionlimit,
+	const std::vector<grotrian_variant>& variants, const std::string& title, unsigned threads, std::vector<std::string>& failed)
+{
+	// result per variant, the failed ones are listed in sweep file order
+	std::vector<char> ok(variants.size(), 0);
+	grotrian_parallel(variants.size(), threads, [&](size_t k)
+	{
+		const grotrian_variant& v = variants[k];
+		grotrian_layout lay = layout_grotrian_variant(levels, lines, ionlimit, v.opt);
+		cofstream out(v.file);
+		if (!out.is_open() || lay.levels.empty())
+			return;
+		write_grotrian(out, lay, title, v.opt);
+		out.close();
+		ok[k] = !out.fail();
+	});
+	int written = 0;
+	for (size_t k = 0; k < variants.size(); k++)
+	{
+		if (ok[k])
+			written++;
+		else
+			failed.push_back(variants[k].file);
+	}
+	return written;
+}
+
+#endif
@@ -0,0 +1,274 @@
+//========================================================================
+// Name        : kurucz_to_toss.cpp
+// Author      : Michael Knoerzer
+// Version     : 1.0 (2026-10-18)
+// Copyright   : Copyright (c) 2026
+// Description : Converts one species of a Kurucz line list (gfall,
+//             : gfxxxx, fixed columns) to a TOSS line list
+//             : compile with -O3 -pthread
+//             : C++11 !
+//========================================================================
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <unordered_set>
+#include <thread>
+#include <algorithm>
+#include <cstring>
+#include <math.h>
+#include "atomic_data.h"
+#include "diagnostics.h"
+#include "mapped_file.h"
+#include "compressed_stream.h"
+using namespace std;
+
+// columns of the Kurucz format
+// (F11.4,F7.3,F6.2,F12.3,F5.1,1X,A10,F12.3,F5.1,1X,A10,...)
+const int col_wvl = 0;		// nm
+const int col_loggf = 11;
+const int col_code = 18;	// species, i.e. 26.01 = Fe II
+const int col_E1 = 24;		// cm^-1, negative for predicted levels
+const int col_J1 = 36;
+const int col_label1 = 42;
+const int col_E2 = 52;
+const int col_J2 = 64;
+const int col_label2 = 70;
+const int min_length = 80;
+
+const double pow10_table[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18 };
+
+// fixed width decimal field (blanks, sign, digits, point), no branches
+// per character so the loop is unrolled into plain arithmetic;
+// false if there is no digit or any other character
+template<int W>
+inline bool parse_fixed(const char* p, double& value)
+{
+	int64_t v = 0;
+	int frac = 0, point = 0, neg = 0, digits = 0, bad = 0;
+	for (int i = 0; i < W; i++)
+	{
+		const char c = p[i];
+		const unsigned d = (unsigned char)c - '0';
+		const int digit = d < 10;
+		v = digit ? v * 10 + d : v;
+		digits += digit;
+		frac += digit & point;
+		point |= c == '.';
+		neg |= c == '-';
+		bad |= !(digit | (c == ' ') | (c == '.') | (c == '-') | (c == '+'));
+	}
+	value = (double)v / pow10_table[frac];
+	value = neg ? -value : value;
+	return digits > 0 && digits <= 18 && !bad;
+}
+
+// parity from the configuration in a label like "3d6 4s  a6D" or "d6s a6D":
+// sum of l over all electrons, a letter with digits and a capital letter
+// behind (a6D, z5F, d4P) is the term and not an orbital
+int label_parity(const char* s, int n)
+{
+	static const char orbitals[] = "spdfghi";
+	int sum = 0;
+	for (int i = 0; i < n; i++)
+	{
+		const char* o = (const char*)memchr(orbitals, s[i], 7);
+		if (!o || (i > 0 && isalpha((unsigned char)s[i - 1])))
+			continue;
+		int j = i + 1, occ = 0;
+		while (j < n && isdigit((unsigned char)s[j]))
+			occ = occ * 10 + (s[j++] - '0');
+		if (j < n && isupper((unsigned char)s[j]))
+			continue;
+		sum += (o - orbitals) * (occ > 0 ? occ : 1);
+	}
+	return sum & 1;
+}
+
+// result of one part of the file
+struct chunk_result
+{
+	string out;					// formatted TOSS lines
+	long lines = 0;
+	unordered_set<uint64_t> levels;
+	diagnostics_log bad;
+};
+
+// all records of the species in [p, end)
+void convert_chunk(const char* p, const char* end, const char* code, chunk_result& res)
+{
+	char buf[256];
+	while (p < end)
+	{
+		const char* nl = (const char*)memchr(p, '\n', end - p);
+		const char* le = nl ? nl : end;
+		const int len = le - p;
+		const char* line = p;
+		p = le + 1;
+
+		// species filter before anything is parsed
+		if (len < col_code + 6 || memcmp(line + col_code, code, 6) != 0)
+			continue;
+
+		if (len < min_length)
+		{
+			res.bad.report("line too short", string(line, len));
+			continue;
+		}
+		double wvl, loggf, E1, J1, E2, J2;
+		if (!(parse_fixed<11>(line + col_wvl, wvl) & parse_fixed<7>(line + col_loggf, loggf)
+			& parse_fixed<12>(line + col_E1, E1) & parse_fixed<5>(line + col_J1, J1)
+			& parse_fixed<12>(line + col_E2, E2) & parse_fixed<5>(line + col_J2, J2)))
+		{
+			res.bad.report("unreadable number", string(line, len));
+			continue;
+		}
+		if (wvl <= 0.0)
+		{
+			res.bad.report("wavelength <= 0", string(line, len));
+			continue;
+		}
+
+		atomic_level low, up;
+		low.energy = fabs(E1);
+		low.J = J1;
+		low.p = label_parity(line + col_label1, 10);
+		up.energy = fabs(E2);
+		up.J = J2;
+		up.p = label_parity(line + col_label2, 10);
+		if (low.energy > up.energy)
+			swap(low, up);
+
+		// nm -> Angstrom, gA from gf as in nist_to_toss
+		wvl *= 10.0;
+		const double gA = pow(10.0, loggf) / (gf_to_gA * wvl * wvl);
+		int n = format_toss_line(buf, sizeof(buf), low, up, wvl, loggf, gA);
+		res.out.append(buf, min(n, (int)sizeof(buf) - 1));
+		res.levels.insert(level_key(low.energy, low.J, low.p));
+		res.levels.insert(level_key(up.energy, up.J, up.p));
+		res.lines++;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc < 3)
+	{
+		cout << "\nUsage: kurucz_to_toss <Kurucz file> <species> <options>\n";
+		cout << "\nspecies: Kurucz code, i.e. 26.01 for Fe II\n";
+		cout << "\nOptions: out=<file>, threads=<number>, diag=<number>, rej=<file>\n";
+		cout << "out:     output file (default <Kurucz file>_<species>_out_toss),\n";
+		cout << "         compressed for .gz/.zst\n";
+		cout << "threads: number of threads (default: all cores)\n";
+		cout << "diag:    number of examples printed per type of bad record (default 5)\n";
+		cout << "rej:     write all bad records to a file" << endl;
+		return 0;
+	}
+
+	// default values
+	double species = atof(argv[2]);
+	string out_file = string(argv[1]) + "_" + argv[2] + "_out_toss";
+	unsigned nthreads = thread::hardware_concurrency();
+	diagnostics diag;
+
+	for (int i = 3; i < argc; i++)
+	{
+		string s(argv[i]);
+		if (s.substr(0, 4) == "out=")
+		{
+			out_file = s.substr(4);
+		}
+		else if (s.substr(0, 8) == "threads=")
+		{
+			stringstream ss(s.substr(8));
+			ss >> nthreads;
+		}
+		else if (s.substr(0, 5) == "diag=")
+		{
+			stringstream ss(s.substr(5));
+			ss >> diag.max_examples;
+		}
+		else if (s.substr(0, 4) == "rej=")
+		{
+			if (!diag.open_rejects(s.substr(4)))
+			{
+				cout << "** ERROR: couldn't open file: " << s.substr(4) << endl;
+				return -1;
+			}
+		}
+	}
+	if (nthreads < 1)
+		nthreads = 1;
+
+	// species field exactly as in the file (F6.2)
+	char code[16];
+	snprintf(code, sizeof(code), "%6.2f", species);
+	if (species <= 0.0 || strlen(code) != 6)
+	{
+		cout << "** ERROR: invalid species: " << argv[2] << endl;
+		return -1;
+	}
+
+	mapped_file in;
+	cout << "** attempting to open file: " << argv[1] << endl;
+	if (!in.open(argv[1]))
+	{
+		cout << "** ERROR: couldn't open file: " << argv[1] << endl;
+		return -1;
+	}
+
+	// split the file at line ends, several parts per thread for a
+	// better balance
+	vector<const char*> bounds(1, in.data);
+	const size_t parts = nthreads > 1 ? nthreads * 4 : 1;
+	for (size_t k = 1; k < parts; k++)
+	{
+		const char* p = max(bounds.back(), in.data + in.size * k / parts);
+		const char* nl = (const char*)memchr(p, '\n', in.data + in.size - p);
+		if (!nl)
+			break;
+		bounds.push_back(nl + 1);
+	}
+	bounds.push_back(in.data + in.size);
+
+	vector<chunk_result> results(bounds.size() - 1);
+	vector<thread> threads;
+	for (unsigned t = 0; t < nthreads; t++)
+	{
+		threads.push_back(thread([&, t]()
+		{
+			for (size_t k = t; k < results.size(); k += nthreads)
+				convert_chunk(bounds[k], bounds[k + 1], code, results[k]);
+		}));
+	}
+	for (auto& t : threads)
+		t.join();
+
+	// write in file order
+	cofstream out(out_file);
+	if (!out.is_open())
+	{
+		cout << "** ERROR: couldn't open file: " << out_file << endl;
+		return -1;
+	}
+	write_toss_header(out);
+	long lines = 0;
+	unordered_set<uint64_t> levels;
+	for (auto& r : results)
+	{
+		out.write(r.out.data(), r.out.size());
+		lines += r.lines;
+		levels.insert(r.levels.begin(), r.levels.end());
+		r.bad.replay(diag);
+	}
+	out.close();
+
+	cout << "** " << lines << " transitions of species " << code + strspn(code, " ") << " found, " << levels.size() << " levels" << endl;
+	cout << "** written to: " << out_file << endl;
+	diag.summary(cout);
+
+	return 0;
+}
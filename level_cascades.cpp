@@ -0,0 +1,159 @@
+//========================================================================
+// Name        : level_cascades.cpp
+// Author      : Michael Knoerzer
+// Version     : 1.0 (2026-10-18)
+// Copyright   : Copyright (c) 2026
+// Description : Radiative lifetimes, branching ratios, unconnected
+//             : levels and decay cascades from any level/line source
+//             : C++11 !
+//========================================================================
+
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <vector>
+#include <math.h>
+#include "atomic_data.h"
+#include "level_graph.h"
+using namespace std;
+
+void print_level(const atomic_data& data, uint32_t i)
+{
+	const atomic_level& l = data.levels[i];
+	cout << setw(12) << fixed << setprecision(2) << l.energy << " (" << (l.p ? "o" : "e") << ") "
+		<< setw(4) << setprecision(1) << l.J << " " << l.config << " " << l.term;
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc < 2)
+	{
+		cout << "\nUsage: level_cascades <source> <options>\n";
+		cout << "\nSources: nist:<file>, adamant:<level file>,<line file>, toss:<file>, tmad:<file>\n";
+		cout << "\nOptions: e=<number>, br=<number>, max=<number>, t=<true/false>\n";
+		cout << "e:   print decay cascades from the level closest to this energy\n";
+		cout << "br:  skip cascades with a total branching ratio below this (default 0.01)\n";
+		cout << "max: maximum number of cascades printed (default 100)\n";
+		cout << "t:   print lifetimes and branching ratios of all levels (default true)" << endl;
+		return 0;
+	}
+
+	// default values
+	double start_e = -1.0;
+	double threshold = 0.01;
+	size_t max_paths = 100;
+	bool table = true;
+
+	for (int i = 2; i < argc; i++)
+	{
+		string s(argv[i]);
+		if (s.substr(0, 2) == "e=")
+		{
+			stringstream ss(s.substr(2));
+			ss >> start_e;
+		}
+		else if (s.substr(0, 3) == "br=")
+		{
+			stringstream ss(s.substr(3));
+			ss >> threshold;
+		}
+		else if (s.substr(0, 4) == "max=")
+		{
+			stringstream ss(s.substr(4));
+			ss >> max_paths;
+		}
+		else if (s.substr(0, 2) == "t=")
+		{
+			stringstream ss(s.substr(2));
+			ss >> boolalpha >> table;
+		}
+	}
+
+	atomic_data data;
+	cout << "** attempting to read source: " << argv[1] << endl;
+	if (!read_source(argv[1], data))
+	{
+		cout << "** ERROR: couldn't read source: " << argv[1] << endl;
+		return -1;
+	}
+	if (data.levels.empty())
+	{
+		cout << "** found no levels **" << endl;
+		return -1;
+	}
+
+	level_graph g = build_level_graph(data);
+	cout << "** " << g.n << " levels, " << g.edges() << " radiative transitions" << endl;
+
+	// ground state = lowest level
+	uint32_t ground = 0;
+	for (uint32_t i = 1; i < g.n; i++)
+	{
+		if (data.levels[i].energy < data.levels[ground].energy)
+			ground = i;
+	}
+
+	// lifetimes and branching ratios
+	if (table)
+	{
+		vector<double> tau = lifetimes(g);
+		cout << endl << "** lifetimes / branching ratios:" << endl;
+		for (uint32_t i = 0; i < g.n; i++)
+		{
+			cout << "** ";
+			print_level(data, i);
+			cout << "  A=" << scientific << setprecision(3) << g.A_total[i] << " tau=" << tau[i] << " s" << endl;
+			for (uint32_t e = g.out_offset[i]; e < g.out_offset[i + 1]; e++)
+			{
+				cout << "***   -> ";
+				print_level(data, g.out_target[e]);
+				cout << "  BR=" << fixed << setprecision(4) << g.branching_ratio(e, i) << endl;
+			}
+		}
+	}
+
+	// isolated and unconnected levels
+	vector<uint32_t> iso = isolated_levels(g);
+	vector<uint32_t> unc = unconnected_levels(g, ground);
+	cout << endl << "** isolated levels (no transitions): " << iso.size() << endl;
+	for (uint32_t i : iso)
+	{
+		cout << "*** ";
+		print_level(data, i);
+		cout << endl;
+	}
+	cout << "** levels not connected to the ground state: " << unc.size() << endl;
+	for (uint32_t i : unc)
+	{
+		cout << "*** ";
+		print_level(data, i);
+		cout << endl;
+	}
+
+	// cascades
+	if (start_e >= 0.0)
+	{
+		uint32_t start = 0;
+		for (uint32_t i = 1; i < g.n; i++)
+		{
+			if (fabs(data.levels[i].energy - start_e) < fabs(data.levels[start].energy - start_e))
+				start = i;
+		}
+		vector<cascade> res = cascades(g, start, ground, threshold, max_paths);
+		cout << endl << "** cascades from ";
+		print_level(data, start);
+		cout << " with BR >= " << fixed << setprecision(4) << threshold << ": " << res.size() << endl;
+		double total = 0.0;
+		for (const auto& c : res)
+		{
+			total += c.probability;
+			cout << "*** " << fixed << setprecision(4) << c.probability << ":";
+			for (uint32_t i : c.levels)
+				cout << " " << setprecision(1) << data.levels[i].energy;
+			cout << endl;
+		}
+		cout << "** sum of listed cascades: " << fixed << setprecision(4) << total << endl;
+	}
+
+	return 0;
+}
@@ -0,0 +1,203 @@
+//========================================================================
+// Name        : level_graph.h
+// Author      : Michael Knoerzer
+// Version     : 1.0 (2026-10-18)
+// Copyright   : Copyright (c) 2026
+// Description : Level connectivity graph in compressed sparse row form
+//             : (levels = nodes, radiative decays = edges weighted by A)
+//             : with lifetimes, branching ratios and decay cascades
+//             : C++11 !
+//========================================================================
+#ifndef LEVEL_GRAPH_H
+#define LEVEL_GRAPH_H
+
+#include <vector>
+#include <cstdint>
+#include <limits>
+#include "atomic_data.h"
+
+struct level_graph
+{
+	uint32_t n = 0;
+	// decays: edges of level i are out_offset[i] .. out_offset[i+1]-1,
+	// out_target is the lower level, out_A the transition probability
+	std::vector<uint32_t> out_offset;
+	std::vector<uint32_t> out_target;
+	std::vector<float> out_A;
+	// population: the same edges seen from the lower level
+	std::vector<uint32_t> in_offset;
+	std::vector<uint32_t> in_source;
+	// sum of all A out of a level
+	std::vector<double> A_total;
+
+	uint32_t edges() const { return out_target.size(); }
+	uint32_t decays(uint32_t i) const { return out_offset[i + 1] - out_offset[i]; }
+	double branching_ratio(uint32_t e, uint32_t from) const { return out_A[e] / A_total[from]; }
+};
+
+// build the graph from any level/line table, A = gA / g_up
+inline level_graph build_level_graph(const atomic_data& data)
+{
+	level_graph g;
+	g.n = data.levels.size();
+	g.out_offset.assign(g.n + 1, 0);
+	g.in_offset.assign(g.n + 1, 0);
+	g.A_total.assign(g.n, 0.0);
+
+	// count edges per level
+	for (const auto& t : data.lines)
+	{
+		if (t.gA <= 0.0 || t.up == t.low)
+			continue;
+		g.out_offset[t.up + 1]++;
+		g.in_offset[t.low + 1]++;
+	}
+	for (uint32_t i = 0; i < g.n; i++)
+	{
+		g.out_offset[i + 1] += g.out_offset[i];
+		g.in_offset[i + 1] += g.in_offset[i];
+	}
+
+	// fill
+	uint32_t m = g.out_offset[g.n];
+	g.out_target.resize(m);
+	g.out_A.resize(m);
+	g.in_source.resize(m);
+	std::vector<uint32_t> out_pos(g.out_offset.begin(), g.out_offset.end() - 1);
+	std::vector<uint32_t> in_pos(g.in_offset.begin(), g.in_offset.end() - 1);
+	for (const auto& t : data.lines)
+	{
+		if (t.gA <= 0.0 || t.up == t.low)
+			continue;
+		double A = t.gA / (2 * data.levels[t.up].J + 1);
+		uint32_t e = out_pos[t.up]++;
+		g.out_target[e] = t.low;
+		g.out_A[e] = (float)A;
+		g.A_total[t.up] += A;
+		g.in_source[in_pos[t.low]++] = t.up;
+	}
+	return g;
+}
+
+// radiative lifetime in s, infinite for levels without decays
+inline std::vector<double> lifetimes(const level_graph& g)
+{
+	std::vector<double> tau(g.n);
+	for (uint32_t i = 0; i < g.n; i++)
+		tau[i] = g.A_total[i] > 0.0 ? 1.0 / g.A_total[i] : std::numeric_limits<double>::infinity();
+	return tau;
+}
+
+// levels without any transition
+inline std::vector<uint32_t> isolated_levels(const level_graph& g)
+{
+	std::vector<uint32_t> res;
+	for (uint32_t i = 0; i < g.n; i++)
+	{
+		if (g.out_offset[i + 1] == g.out_offset[i] && g.in_offset[i + 1] == g.in_offset[i])
+			res.push_back(i);
+	}
+	return res;
+}
+
+// levels that can not be reached from start, in any direction
+inline std::vector<uint32_t> unconnected_levels(const level_graph& g, uint32_t start)
+{
+	std::vector<char> seen(g.n, 0);
+	std::vector<uint32_t> stack;
+	if (start < g.n)
+	{
+		stack.push_back(start);
+		seen[start] = 1;
+	}
+	while (!stack.empty())
+	{
+		uint32_t i = stack.back();
+		stack.pop_back();
+		for (uint32_t e = g.out_offset[i]; e < g.out_offset[i + 1]; e++)
+		{
+			if (!seen[g.out_target[e]])
+			{
+				seen[g.out_target[e]] = 1;
+				stack.push_back(g.out_target[e]);
+			}
+		}
+		for (uint32_t e = g.in_offset[i]; e < g.in_offset[i + 1]; e++)
+		{
+			if (!seen[g.in_source[e]])
+			{
+				seen[g.in_source[e]] = 1;
+				stack.push_back(g.in_source[e]);
+			}
+		}
+	}
+	std::vector<uint32_t> res;
+	for (uint32_t i = 0; i < g.n; i++)
+	{
+		if (!seen[i])
+			res.push_back(i);
+	}
+	return res;
+}
+
+// one decay path, levels from start to ground, probability = product of
+// the branching ratios along the path
+struct cascade
+{
+	std::vector<uint32_t> levels;
+	double probability;
+};
+
+// all cascades from start down to ground with a probability >= threshold,
+// at most max_paths; depth first with an explicit stack, decays always go
+// down in energy so there are no cycles (depth is still limited by n)
+inline std::vector<cascade> cascades(const level_graph& g, uint32_t start, uint32_t ground, double threshold, size_t max_paths)
+{
+	struct frame
+	{
+		uint32_t level;
+		uint32_t edge;		// next edge to follow
+		double probability;
+	};
+
+	std::vector<cascade> res;
+	if (start >= g.n || ground >= g.n)
+		return res;
+	if (start == ground)
+	{
+		res.push_back({ std::vector<uint32_t>(1, start), 1.0 });
+		return res;
+	}
+
+	std::vector<frame> stack;
+	stack.push_back({ start, g.out_offset[start], 1.0 });
+	while (!stack.empty() && res.size() < max_paths)
+	{
+		frame& f = stack.back();
+		if (f.edge == g.out_offset[f.level + 1] || stack.size() > g.n)
+		{
+			stack.pop_back();
+			continue;
+		}
+		uint32_t e = f.edge++;
+		uint32_t next = g.out_target[e];
+		double p = f.probability * g.branching_ratio(e, f.level);
+		if (p < threshold)
+			continue;
+
+		if (next == ground)
+		{
+			cascade c;
+			c.probability = p;
+			for (const auto& s : stack)
+				c.levels.push_back(s.level);
+			c.levels.push_back(ground);
+			res.push_back(c);
+		}
+		else
+			stack.push_back({ next, g.out_offset[next], p });
+	}
+	return res;
+}
+
+#endif
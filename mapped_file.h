@@ -0,0 +1,102 @@
+//========================================================================
+// Name        : mapped_file.h
+// Author      : Michael Knoerzer
+// Version     : 1.0 (2026-10-18)
+// Copyright   : Copyright (c) 2026
+// Description : Read only view of a whole file: mmap on POSIX systems,
+//             : read into memory if mmap is not possible (pipes, ...),
+//             : gzip/zstd files are unpacked into memory
+//             : C++11 !
+//========================================================================
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstddef>
+#include <iterator>
+#include "compressed_stream.h"
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#define MAPPED_FILE_MMAP 1
+#endif
+
+struct mapped_file
+{
+	const char* data = nullptr;
+	size_t size = 0;
+
+	mapped_file() {}
+	mapped_file(const mapped_file&) = delete;
+	mapped_file& operator=(const mapped_file&) = delete;
+	~mapped_file() { close(); }
+
+	bool open(const std::string& file)
+	{
+		close();
+		if (file_compression(file) != COMPRESSION_NONE)
+		{
+			cifstream in(file);
+			if (!in.is_open())
+				return false;
+			buffer.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+			data = buffer.data();
+			size = buffer.size();
+			return true;
+		}
+#ifdef MAPPED_FILE_MMAP
+		int fd = ::open(file.c_str(), O_RDONLY);
+		if (fd < 0)
+			return false;
+		struct stat st;
+		if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0)
+		{
+			void* p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (p != MAP_FAILED)
+			{
+				madvise(p, st.st_size, MADV_SEQUENTIAL);
+				::close(fd);
+				data = (const char*)p;
+				size = st.st_size;
+				mapped = true;
+				return true;
+			}
+		}
+		::close(fd);
+#endif
+		// fallback: read everything
+		FILE* f = fopen(file.c_str(), "rb");
+		if (!f)
+			return false;
+		std::vector<char> block(1 << 20);
+		size_t n;
+		while ((n = fread(&block[0], 1, block.size(), f)) > 0)
+			buffer.insert(buffer.end(), block.begin(), block.begin() + n);
+		fclose(f);
+		data = buffer.data();
+		size = buffer.size();
+		return true;
+	}
+
+	void close()
+	{
+#ifdef MAPPED_FILE_MMAP
+		if (mapped)
+			munmap((void*)data, size);
+#endif
+		mapped = false;
+		buffer.clear();
+		data = nullptr;
+		size = 0;
+	}
+
+private:
+	bool mapped = false;
+	std::vector<char> buffer;
+};
+
+#endif
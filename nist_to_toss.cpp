@@ -14,18 +14,27 @@
 #include <vector>
 #include <algorithm>
 #include <iomanip>
+#include <memory>
 #include <math.h>
+#include "diagnostics.h"
+#include "csv_scan.h"
+#include "mapped_file.h"
+#include "compressed_stream.h"
+#include "pipeline.h"
+#include "build_cache.h"
+#include "parse_arena.h"
 using namespace std;
 
-// struct for level and transition
+// struct for level and transition, the texts are kept in the arena of
+// the run
 struct level
 {
-	string name;
-	string config;
-	string term;
+	text_view name;
+	text_view config;
+	text_view term;
 	double energy;
 	double J;
-	string parity;
+	text_view parity;
 };
 
 struct transition
@@ -37,252 +46,553 @@ struct transition
 	double gA;
 };
 
-int main(int argc, char* argv[])
+// first column whose header is key, key(unit) or (prefix) starts with key
+int csv_column(const vector<string>& header, const string& key, bool prefix = false)
 {
-	if(argc < 2)
+	for(size_t i = 0; i < header.size(); i++)
 	{
-		cout << "Usage: nist_to_toss <tmad-file>" << endl;
-		return 0;
+		const string& h = header[i];
+		if(h == key || h.substr(0,key.size()+1) == key + "(" || (prefix && h.substr(0,key.size()) == key))
+			return i;
 	}
+	return -1;
+}
 
-	// buffers for input, in/out stream, line buffer
-	vector<level> vec_levels;
-	vector<transition> vec_trans;
-	ifstream in;
-	ofstream out;
-	string line;
+// number from a NIST field like "1234.5", "[1234.5]", "(1234.5)", "1234.5?"
+// (copied to scratch for strtod)
+bool csv_number(text_view s, double& d, parse_arena& scratch)
+{
+	char* tmp = (char*)scratch.allocate(s.size() + 1, 1);
+	size_t n = 0;
+	for(char c : s)
+	{
+		if(c != '[' && c != ']' && c != '(' && c != ')' && c != '?')
+			tmp[n++] = c;
+	}
+	tmp[n] = 0;
+	char* end;
+	d = strtod(tmp, &end);
+	return end != tmp;
+}
 
-	// open file and read line by line
-	cout << "attempting to open file: " << argv[1] << endl;
-	in.open(argv[1]);
-	if(in.is_open())
+// J as "3/2" or "1.5"
+bool csv_J(text_view s, double& J, parse_arena& scratch)
+{
+	std::size_t found = s.find('/');
+	double num, den = 1.0;
+	if(found != std::string::npos)
+	{
+		if(!csv_number(s.sub(0,found), num, scratch) || !csv_number(s.sub(found+1), den, scratch) || den == 0.0)
+			return false;
+	}
+	else if(!csv_number(s, num, scratch))
+		return false;
+	J = num / den;
+	return true;
+}
+
+// NIST ASD lines export as CSV or tab separated text: columns are found by
+// their names in the header, wavelengths in nm are converted to Angstrom;
+// the texts of the levels are copied to arena
+bool read_csv(const string& file, char delim, parse_arena& arena, vector<level>& vec_levels, vector<transition>& vec_trans, diagnostics& diag)
+{
+	mapped_file in;
+	if(!in.open(file))
+		return false;
+	csv_scanner scan(in.data, in.size, delim);
+	vector<csv_field> fields;
+	vector<string> header;
+	if(!scan.next(fields))
+		return false;
+	for(const csv_field& f : fields)
+		header.push_back(csv_value(f));
+
+	int c_wvl = csv_column(header, "obs_wl", true);
+	if(c_wvl < 0)
+		c_wvl = csv_column(header, "ritz_wl", true);
+	int c_gA = csv_column(header, "gA");
+	int c_A = csv_column(header, "Aki");
+	int c_gk = csv_column(header, "g_k");
+	int c_loggf = csv_column(header, "log_gf");
+	int c_Ei = csv_column(header, "Ei");
+	int c_Ek = csv_column(header, "Ek");
+	int c_conf_i = csv_column(header, "conf_i");
+	int c_term_i = csv_column(header, "term_i");
+	int c_J_i = csv_column(header, "J_i");
+	int c_conf_k = csv_column(header, "conf_k");
+	int c_term_k = csv_column(header, "term_k");
+	int c_J_k = csv_column(header, "J_k");
+	if(c_wvl < 0 || (c_gA < 0 && c_A < 0) || c_loggf < 0 || c_Ei < 0 || c_Ek < 0 || c_J_i < 0 || c_J_k < 0)
+	{
+		cout << "ERROR: missing columns, need obs_wl/ritz_wl, gA/Aki, log_gf, Ei, Ek, J_i, J_k" << endl;
+		return false;
+	}
+	double wvl_scale = 1.0;
+	if(header[c_wvl].find("(nm)") != string::npos)
+		wvl_scale = 10.0;
+	else if(header[c_wvl].find("(um)") != string::npos)
+		wvl_scale = 1.0e4;
+	// one record per line, saves copying the tables while they grow
+	size_t records = count(in.data, in.data + in.size, '\n');
+
+	vec_trans.reserve(vec_trans.size() + records);
+	vec_levels.reserve(vec_levels.size() + 2 * records);
+
+	int last = max({ c_wvl, c_gA, c_A, c_gk, c_loggf, c_Ei, c_Ek, c_conf_i, c_term_i, c_J_i, c_conf_k, c_term_k, c_J_k });
+
+	// values point into the file, unquoted ones and numbers are scratch of
+	// the record
+	parse_arena scratch;
+	auto text = [&](int c) { return c < 0 ? text_view() : csv_value(fields[c], scratch); };
+	auto number = [&](int c, double& d) { return csv_number(text(c), d, scratch); };
+	auto J = [&](int c, double& d) { return csv_J(text(c), d, scratch); };
+	// whole record, only needed for messages
+	auto line = [&]() { return string(fields.front().p, fields.back().p + fields.back().n); };
+	while(scan.next(fields))
 	{
-		// read in transitions
-		while(getline(in,line))
+		scratch.reset();
+		if(fields.size() == 1 && csv_value(fields[0], scratch).empty())
+			continue;
+		if((int)fields.size() <= last)
+		{
+			diag.report("short record (csv)", line());
+			continue;
+		}
+
+		level l_low, l_up;
+		transition t;
+		double d, gA, E_low, E_up, J_low, J_up;
+		if(!number(c_wvl, d))
+		{
+			diag.report("bad wavelength (csv)", line());
+			continue;
+		}
+		t.wvl = (float)(d * wvl_scale);
+		if(c_gA >= 0)
+		{
+			if(!number(c_gA, gA))
+			{
+				diag.report("bad gA (csv)", line());
+				continue;
+			}
+		}
+		else
 		{
-			// loop through items
-			int bars = 0;
-			int energies = 0;
-			level l_low,l_up;
-			transition t;
-			string tmp;
-			stringstream ss(line);
-
-			while(!ss.eof())
+			// A_ki times g of the upper level
+			double gk;
+			if(!number(c_A, gA))
 			{
-				ss >> tmp;
+				diag.report("bad Aki (csv)", line());
+				continue;
+			}
+			if(c_gk >= 0 && number(c_gk, gk))
+				gA *= gk;
+			else if(J(c_J_k, J_up))
+				gA *= 2 * J_up + 1;
+		}
+		t.gA = (float)gA;
+		if(!number(c_loggf, d))
+		{
+			diag.report("bad log_gf (csv)", line());
+			continue;
+		}
+		t.log_gf = (float)d;
+		if(!number(c_Ei, E_low) || !number(c_Ek, E_up))
+		{
+			diag.report("bad energy (csv)", line());
+			continue;
+		}
+		if(!J(c_J_i, J_low) || !J(c_J_k, J_up))
+		{
+			diag.report("bad J (csv)", line());
+			continue;
+		}
+		l_low.energy = (float)E_low;
+		l_up.energy = (float)E_up;
+		l_low.J = (float)J_low;
+		l_up.J = (float)J_up;
+		l_low.config = arena.copy_without(text(c_conf_i), '?');
+		l_up.config = arena.copy_without(text(c_conf_k), '?');
+		l_low.term = arena.copy(text(c_term_i));
+		l_up.term = arena.copy(text(c_term_k));
+		l_low.parity = (l_low.term.find('*') != string::npos) ? "o" : "e";
+		l_up.parity = (l_up.term.find('*') != string::npos) ? "o" : "e";
+		l_low.name = arena.concat({ l_low.config, "_", l_low.term });
+		l_up.name = arena.concat({ l_up.config, "_", l_up.term });
+
+		// same as for the pipe table
+		if(l_low.energy > l_up.energy)
+		{
+			swap(l_low, l_up);
+			diag.report("Info: levels reversed, check gA/gf for consistency!", line());
+		}
+		vec_levels.push_back(l_low);
+		vec_levels.push_back(l_up);
+		t.low = std::move(l_low);
+		t.up = std::move(l_up);
+		vec_trans.push_back(std::move(t));
+	}
+	return true;
+}
+
+// one line of the pipe formatted table, a transition is added to
+// vec_trans (and its levels to vec_levels) if the line is complete; the
+// words are read in place, the texts of the levels copied to arena
+void parse_line(const string& line, parse_arena& arena, vector<level>& vec_levels, vector<transition>& vec_trans, diagnostics_log& diag)
+{
+	// loop through items, as "ss >> tmp" until eof: after trailing
+	// blanks the last word is seen once more
+	int bars = 0;
+	int energies = 0;
+	level l_low,l_up;
+	transition t;
+	text_view tmp;
+	const char* next = line.c_str();
+	bool eof = false;
+	float f, den;
+
+	while(!eof)
+	{
+		text_view w;
+		if(parse_word(next, w))
+			tmp = w;
+		eof = !*next;
+
+		// skip ---------
+		if(tmp.size() > 10 && "-----" == tmp.sub(1,5))
+			break;
 
-				// skip ---------
-				if(tmp.size() > 10 && "-----" == tmp.substr(1,5))
-					break;
+		if ("|" == tmp)
+		{
+			bars++;
+			continue;
+		}
+
+		std::size_t found;
+		// get data
+		switch(bars)
+		{
+			// wavelength
+			case 0:
+				if(parse_stof(tmp, f))
+					t.wvl = f;
+				else
+				{
+		    		// bad line, skip
+		    		diag.report("bad line (b=0)", line);
+		    		bars=99;
+				}
+		    	break;
 
-				if ("|" == tmp)
+		    // gA
+			case 5:
+				if(parse_stof(tmp, f))
+					t.gA = f;
+				else
 				{
-					bars++;
-					continue;
+		    		// bad line, skip
+		    		diag.report("bad line (b=5)", line);
+		    		bars=99;
 				}
+		    	break;
 
-				std::size_t found;
-				// get data
-				switch(bars)
+			// log(gf)
+			case 6:
+				if(parse_stof(tmp, f))
+					t.log_gf = f;
+				else
 				{
-					// wavelength
-					case 0:
-						try
-						{
-				    		t.wvl = std::stof(tmp);
-						}
-						catch(std::invalid_argument const &e)
-						{
-				    		// bad line, skip
-				    		cout << "bad line (b=0): " << line << endl;
-				    		bars=99;
-						}
-				    	break;
-
-				    // gA
-					case 5:
-						try
-						{
-				    		t.gA = std::stof(tmp);
-						}
-						catch(std::invalid_argument const &e)
-						{
-				    		// bad line, skip
-				    		cout << "bad line (b=5): " << line << endl;
-				    		bars=99;
-						}
-				    	break;
-
-					// log(gf)
-					case 6:
-						try
-						{
-							t.log_gf = std::stof(tmp);
-						}
-						catch(std::invalid_argument const &e)
-						{
-							// bad line, skip
-							cout << "bad line (b=6): " << line << endl;
-							bars=99;
-						}
-						break;
-
-					// energies
-					case 8:
-						// case 0: try to get first energy
-						// case 1: try to get 2nd energy
-						try
-						{
-							double d = std::stof(tmp);
-							//cout << "energy: " << d << endl;
-							if(0 == energies)
-								l_low.energy = d;
-							else if (1 == energies)
-								l_up.energy = d;
-							else
-							{
-								// should not happen
-								cout << "strange error (b=8): " << line << endl;
-								bars=99;
-							}
-							energies++;
-						}
-						catch(std::invalid_argument const &e)
-						{
-							// bad line, skip
-						}
-						break;
-
-					// 9-11: lower level
-					case 9:
-						tmp.erase(std::remove(tmp.begin(), tmp.end(), '?'), tmp.end());
-						l_low.config = tmp;
-						break;
-					case 10:
-						l_low.term = tmp;
-						found = tmp.find('*');
-						if (found!=std::string::npos)
-							l_low.parity = "o";
-						else
-							l_low.parity = "e";
-						break;
-					case 11:
-						try
-						{
-							found = tmp.find('/');
-							if (found!=std::string::npos)
-							{
-								// found a fraction, convert
-								l_low.J = std::stof(tmp.substr(0,found)) / std::stof(tmp.substr(found+1));
-							}
-							else
-								l_low.J = std::stof(tmp);
-
-							// make name
-							l_low.name = l_low.config + "_" + l_low.term;
-						}
-						catch(std::invalid_argument const &e)
-						{
-							// bad line, skip
-							cout << "bad J (b=11): " << line << endl;
-							bars=99;
-						}
-						break;
-
-					// 12-14: upper level
-					case 12:
-						tmp.erase(std::remove(tmp.begin(), tmp.end(), '?'), tmp.end());
-						l_up.config = tmp;
-						break;
-					case 13:
-						l_up.term = tmp;
-						found = tmp.find('*');
-						if (found!=std::string::npos)
-							l_up.parity = "o";
-						else
-							l_up.parity = "e";
-						break;
-					case 14:
-						try
-						{
-							std::size_t found = tmp.find('/');
-							if (found!=std::string::npos)
-							{
-								// found a fraction, convert
-								l_up.J = std::stof(tmp.substr(0,found)) / std::stof(tmp.substr(found+1));
-							}
-							else
-								l_up.J = std::stof(tmp);
-
-							// make name
-							l_up.name = l_up.config + "_" + l_up.term;
-
-							// finish
-							bars = 50;
-						}
-						catch(std::invalid_argument const &e)
-						{
-							// bad line, skip
-							cout << "bad J (b=11): " << line << endl;
-							bars=99;
-						}
-						break;
-
-					// otherwise skip
-					default:
-				    	break;
+					// bad line, skip
+					diag.report("bad line (b=6)", line);
+					bars=99;
 				}
+				break;
 
-				// finished
-				if(50 == bars)
+			// energies
+			case 8:
+				// case 0: try to get first energy
+				// case 1: try to get 2nd energy
+				if(parse_stof(tmp, f))
 				{
-					// reverse if necessary
-					if(l_low.energy > l_up.energy)
+					double d = f;
+					//cout << "energy: " << d << endl;
+					if(0 == energies)
+						l_low.energy = d;
+					else if (1 == energies)
+						l_up.energy = d;
+					else
 					{
-						// reverse it
-						level ltmp = l_low;
-						l_low = l_up;
-						l_up = ltmp;
-						cout << "Info: levels reversed, check gA/gf for consistency!" << endl;
+						// should not happen
+						diag.report("strange error (b=8)", line);
+						bars=99;
 					}
-					// store levels
-					vec_levels.push_back(l_low);
-					vec_levels.push_back(l_up);
-
-					// store transition
-					t.low = l_low;
-					t.up = l_up;
-					// check
-					//cout << "transition finished, " << t.wvl;
-					//cout << ", E low: " << t.low.energy << ", E up: " << t.up.energy << endl;
-					vec_trans.push_back(t);
-					break;
+					energies++;
 				}
+				// otherwise bad item, skip
+				break;
 
-				// on error goto next line
-				if(99 == bars)
-					break;
-			}// end: while(!ss.eof())
-		}// end: while(getline(in,line))
+			// 9-11: lower level, config and term are copied when the
+			// transition is complete
+			case 9:
+				l_low.config = tmp;
+				break;
+			case 10:
+				l_low.term = tmp;
+				found = tmp.find('*');
+				if (found!=std::string::npos)
+					l_low.parity = "o";
+				else
+					l_low.parity = "e";
+				break;
+			case 11:
+				found = tmp.find('/');
+				if (found!=std::string::npos && parse_stof(tmp.sub(0,found), f) && parse_stof(tmp.sub(found+1), den))
+				{
+					// found a fraction, convert
+					l_low.J = f / den;
+				}
+				else if (found==std::string::npos && parse_stof(tmp, f))
+					l_low.J = f;
+				else
+				{
+					// bad line, skip
+					diag.report("bad J (b=11)", line);
+					bars=99;
+				}
+				break;
 
-		// info
-		cout << vec_trans.size() << " transitions found !" << endl;
+			// 12-14: upper level
+			case 12:
+				l_up.config = tmp;
+				break;
+			case 13:
+				l_up.term = tmp;
+				found = tmp.find('*');
+				if (found!=std::string::npos)
+					l_up.parity = "o";
+				else
+					l_up.parity = "e";
+				break;
+			case 14:
+				found = tmp.find('/');
+				if (found!=std::string::npos && parse_stof(tmp.sub(0,found), f) && parse_stof(tmp.sub(found+1), den))
+				{
+					// found a fraction, convert
+					l_up.J = f / den;
+					// finish
+					bars = 50;
+				}
+				else if (found==std::string::npos && parse_stof(tmp, f))
+				{
+					l_up.J = f;
+					bars = 50;
+				}
+				else
+				{
+					// bad line, skip
+					diag.report("bad J (b=14)", line);
+					bars=99;
+				}
+				break;
+
+			// otherwise skip
+			default:
+		    	break;
+		}
+
+		// finished
+		if(50 == bars)
+		{
+			// texts of the levels to the arena, make names
+			for(level* l : { &l_low, &l_up })
+			{
+				l->config = arena.copy_without(l->config, '?');
+				l->term = arena.copy(l->term);
+				l->name = arena.concat({ l->config, "_", l->term });
+			}
+
+			// reverse if necessary
+			if(l_low.energy > l_up.energy)
+			{
+				// reverse it
+				level ltmp = l_low;
+				l_low = l_up;
+				l_up = ltmp;
+				diag.report("Info: levels reversed, check gA/gf for consistency!", line);
+			}
+			// store levels
+			vec_levels.push_back(l_low);
+			vec_levels.push_back(l_up);
+
+			// store transition
+			t.low = l_low;
+			t.up = l_up;
+			// check
+			//cout << "transition finished, " << t.wvl;
+			//cout << ", E low: " << t.low.energy << ", E up: " << t.up.energy << endl;
+			vec_trans.push_back(t);
+			break;
+		}
+
+		// on error goto next line
+		if(99 == bars)
+			break;
+	}// end: while(!eof)
+}
+
+// one transition in TOSS format
+void write_transition(ostream& out, const transition& t)
+{
+	out << setw(12) << fixed << setprecision(3) << t.wvl << " "
+			<< setw(10) << setprecision(1) << t.low.energy << " (" << t.low.parity << ") " << setw(4) << t.low.J << " "
+			<< setw(10) << setprecision(1) << t.up.energy << " (" << t.up.parity << ") " << setw(4) << t.up.J
+			<< "  " << setprecision(3) << setw(7) << t.log_gf << " " << scientific << setw(5) << setprecision(3) << t.gA
+			<< "    0.000" << endl;
+}
+
+// result of one block of lines
+struct parsed_batch
+{
+	parse_arena texts;	// of the levels
+	vector<level> levels;
+	vector<transition> trans;
+	diagnostics_log log;
+	string text;	// the transitions in TOSS format
+};
+
+int main(int argc, char* argv[])
+{
+	if(argc < 2)
+	{
+		cout << "Usage: nist_to_toss <nist-file> <options>" << endl;
+		cout << "nist-file: pipe formatted table or CSV/tab separated export (by header)" << endl;
+		cout << "nist-file: gzip/zstd compressed files are read directly" << endl;
+		cout << "Options: diag=<number>, rej=<file>, out=<file>, threads=<number>, cache=<dir>" << endl;
+		cout << "diag: number of examples printed per type of bad record (default 5)" << endl;
+		cout << "rej:  write all bad records to a file" << endl;
+		cout << "out:  output file (default <nist-file>_out_toss), compressed for .gz/.zst" << endl;
+		cout << "threads: number of parser threads (default: all cores)" << endl;
+		cout << "cache: build cache directory, an unchanged file with the same options is only copied back" << endl;
+		return 0;
+	}
+
+	// bad records are collected and summarized at the end
+	diagnostics diag;
+	string out_file = string(argv[1]) + "_out_toss";
+	string rej_file;
+	string cache_dir;
+	unsigned nthreads = thread::hardware_concurrency();
+	for(int i = 2; i < argc; i++)
+	{
+		string s(argv[i]);
+		if (s.substr(0,4) == "out=")
+		{
+			out_file = s.substr(4);
+		}
+		else if (s.substr(0,8) == "threads=")
+		{
+			stringstream ss(s.substr(8));
+			ss >> nthreads;
+		}
+		else if (s.substr(0,5) == "diag=")
+		{
+			stringstream ss(s.substr(5));
+			ss >> diag.max_examples;
+		}
+		else if (s.substr(0,4) == "rej=")
+		{
+			rej_file = s.substr(4);
+			if(!diag.open_rejects(rej_file))
+				cout << "ERROR: couldn't open file: " << rej_file << endl;
+		}
+		else if (s.substr(0,6) == "cache=")
+		{
+			cache_dir = s.substr(6);
+		}
+	}
+
+	// build cache: the same file with the same options is only copied back
+	build_cache cache;
+	string run_key;
+	unique_ptr<output_capture> capture;
+	if(!cache_dir.empty())
+	{
+		run_key = build_run_key("nist_to_toss " __DATE__ " " __TIME__, vector<string>(argv + 1, argv + argc), { argv[1] });
+		if(!cache.open(cache_dir))
+			cout << "ERROR: couldn't open build cache: " << cache_dir << endl;
+		else if(cache.restore(run_key, cout))
+		{
+			cout << "build cache: unchanged, output of run " << run_key << endl;
+			return 0;
+		}
+		else
+			capture.reset(new output_capture(cout));
+	}
+
+	// buffers for input, in/out stream, line buffer; texts of all levels
+	parse_arena texts;
+	vector<level> vec_levels;
+	vector<transition> vec_trans;
+	cifstream in;
+	cofstream out;
+	string line;
+
+	// open file and read line by line
+	cout << "attempting to open file: " << argv[1] << endl;
+	in.open(argv[1]);
+	if(in.is_open())
+	{
+		// CSV/TSV export: first line is a header with named columns
+		char delim = 0;
+		if(getline(in,line) && (line.find("obs_wl") != string::npos || line.find("ritz_wl") != string::npos))
+			delim = csv_delimiter(line);
+		in.close();
+		in.open(argv[1]);
+		if(delim && !read_csv(argv[1], delim, texts, vec_levels, vec_trans, diag))
+			cout << "ERROR: couldn't read CSV file: " << argv[1] << endl;
 
-		// open output file
-		out.open((string(argv[1])+"_out_toss").c_str());
+		// output file, written by its own thread while reading
+		out.open(out_file);
+		if(!out.is_open())
+			cout << "ERROR: couldn't open file: " << out_file << endl;
 
 		// special line for toss
 		out << endl << "  Wavelength         Lower Level         Upper Level   log gf        gA       CF" << endl << endl;
+		async_writer writer(out);
 
-		for(const transition &t : vec_trans)
+		// read in transitions: reader thread, parser threads, results in
+		// file order
+		if(!delim)
+		{
+			run_line_pipeline<parsed_batch>(in, nthreads,
+				[](const string& text, parsed_batch& r)
+				{
+					for_each_line(text, [&](const string& line) { parse_line(line, r.texts, r.levels, r.trans, r.log); });
+					ostringstream os;
+					for(const transition &t : r.trans)
+						write_transition(os, t);
+					r.text = os.str();
+				},
+				[&](parsed_batch& r)
+				{
+					texts.adopt(std::move(r.texts));
+					vec_levels.insert(vec_levels.end(), make_move_iterator(r.levels.begin()), make_move_iterator(r.levels.end()));
+					vec_trans.insert(vec_trans.end(), make_move_iterator(r.trans.begin()), make_move_iterator(r.trans.end()));
+					r.log.replay(diag);
+					writer.write(std::move(r.text));
+				});
+		}
+		else
 		{
-			out << setw(12) << fixed << setprecision(3) << t.wvl << " "
-					<< setw(10) << setprecision(1) << t.low.energy << " (" << t.low.parity << ") " << setw(4) << t.low.J << " "
-					<< setw(10) << setprecision(1) << t.up.energy << " (" << t.up.parity << ") " << setw(4) << t.up.J
-					<< "  " << setprecision(3) << setw(7) << t.log_gf << " " << scientific << setw(5) << setprecision(3) << t.gA
-					<< "    0.000" << endl;
+			ostringstream os;
+			for(const transition &t : vec_trans)
+				write_transition(os, t);
+			writer.write(os.str());
 		}
+		writer.close();
+
+		// info
+		cout << vec_trans.size() << " transitions found !" << endl;
 
 		// sort/unique levels
 		cout << endl << "levels: " << vec_levels.size() << endl;
@@ -297,6 +607,20 @@ int main(int argc, char* argv[])
 			cout << fixed << setw(9) << setprecision(2);
 			cout << l.energy << ": " << l.config << " " << l.term << " (" << l.parity << ") " << setprecision(1) << l.J << endl;
 		}
+
+		// bad records
+		cout << endl;
+		diag.summary(cout);
+
+		out.close();
+		if(capture)
+		{
+			vector<string> outputs = { out_file };
+			if(!rej_file.empty())
+				outputs.push_back(rej_file);
+			if(!cache.store(run_key, capture->text(), outputs))
+				cout << "ERROR: couldn't store in build cache: " << cache_dir << endl;
+		}
 	}
 	else
 	{
@@ -0,0 +1,381 @@
+//========================================================================
+// Name        : parse_arena.h
+// Author      : Michael Knoerzer
+// Version     : 1.0 (2026-10-18)
+// Copyright   : Copyright (c) 2026
+// Description : Allocation free parsing for the readers: a monotonic
+//             : arena (blocks of 64 kB, freed all at once) holds the
+//             : names, configurations and terms of a run, text_view
+//             : points into it or into the line being read; fields are
+//             : scanned in place instead of by substr and stringstream
+//             : C++11 !
+//========================================================================
+#ifndef PARSE_ARENA_H
+#define PARSE_ARENA_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <functional>
+#include <ostream>
+#include <initializer_list>
+#include <algorithm>
+#include <new>
+#include <stdexcept>
+#include <cstring>
+#include <cstdlib>
+#include <cstddef>
+#include <cctype>
+#include <cerrno>
+#include <climits>
+
+// text without storage of its own: part of a line or of an arena
+struct text_view
+{
+	const char* p = "";
+	size_t n = 0;
+
+	text_view() {}
+	text_view(const char* p, size_t n) : p(p), n(n) {}
+	text_view(const char* s) : p(s), n(strlen(s)) {}
+	text_view(const std::string& s) : p(s.data()), n(s.size()) {}
+
+	size_t size() const { return n; }
+	bool empty() const { return n == 0; }
+	const char* begin() const { return p; }
+	const char* end() const { return p + n; }
+	char operator[](size_t i) const { return p[i]; }
+	std::string str() const { return std::string(p, n); }
+
+	size_t find(char c) const
+	{
+		const void* q = n ? memchr(p, c, n) : nullptr;
+		return q ? (const char*)q - p : std::string::npos;
+	}
+
+	// as substr, but a position behind the end gives an empty text
+	text_view sub(size_t pos, size_t len = std::string::npos) const
+	{
+		if (pos > n)
+			pos = n;
+		return text_view(p + pos, std::min(len, n - pos));
+	}
+};
+
+inline bool operator==(const text_view& a, const text_view& b)
+{
+	return a.n == b.n && (a.n == 0 || memcmp(a.p, b.p, a.n) == 0);
+}
+
+inline bool operator!=(const text_view& a, const text_view& b)
+{
+	return !(a == b);
+}
+
+inline std::ostream& operator<<(std::ostream& out, const text_view& t)
+{
+	if (out.width() > 0)
+		return out << t.str();
+	return out.write(t.p, t.n);
+}
+
+// FNV-1a, for unordered_map keys
+struct text_view_hash
+{
+	size_t operator()(const text_view& t) const
+	{
+		unsigned long long h = 14695981039346656037ULL;
+		for (size_t i = 0; i < t.n; i++)
+		{
+			h ^= (unsigned char)t.p[i];
+			h *= 1099511628211ULL;
+		}
+		return (size_t)h;
+	}
+};
+
+//------------------------------------------------------------------------
+// monotonic arena: allocate() only moves a pointer, nothing is freed
+// before reset() or the destructor; what was allocated never moves, also
+// not if the arena itself is moved or adopted by another one
+//------------------------------------------------------------------------
+class parse_arena
+{
+public:
+	parse_arena(size_t block_size = 1 << 16) : block_size(block_size) {}
+	~parse_arena()
+	{
+		for (const auto& b : blocks)
+			free(b.p);
+	}
+
+	parse_arena(parse_arena&& o) : blocks(std::move(o.blocks)), cur(o.cur), left(o.left), block_size(o.block_size)
+	{
+		o.blocks.clear();
+		o.cur = nullptr;
+		o.left = 0;
+	}
+	parse_arena& operator=(parse_arena&& o)
+	{
+		if (this != &o)
+		{
+			this->~parse_arena();
+			new (this) parse_arena(std::move(o));
+		}
+		return *this;
+	}
+	parse_arena(const parse_arena&) = delete;
+	parse_arena& operator=(const parse_arena&) = delete;
+
+	void* allocate(size_t n, size_t align = alignof(std::max_align_t))
+	{
+		size_t pad = cur ? (align - (size_t)cur % align) % align : 0;
+		if (!cur || pad + n > left)
+		{
+			// a new block, a large request gets one of its own size
+			size_t size = std::max(block_size, n + align);
+			char* b = (char*)malloc(size);
+			if (!b)
+				throw std::bad_alloc();
+			blocks.push_back({ b, size });
+			cur = b;
+			left = size;
+			pad = (align - (size_t)cur % align) % align;
+		}
+		void* r = cur + pad;
+		cur += pad + n;
+		left -= pad + n;
+		return r;
+	}
+
+	text_view copy(const text_view& t)
+	{
+		char* d = (char*)allocate(t.n, 1);
+		if (t.n)
+			memcpy(d, t.p, t.n);
+		return text_view(d, t.n);
+	}
+
+	// copy without the characters c, i.e. '?' of uncertain NIST entries
+	text_view copy_without(const text_view& t, char c)
+	{
+		char* d = (char*)allocate(t.n, 1);
+		size_t k = 0;
+		for (char ch : t)
+		{
+			if (ch != c)
+				d[k++] = ch;
+		}
+		return text_view(d, k);
+	}
+
+	text_view concat(std::initializer_list<text_view> parts)
+	{
+		size_t n = 0;
+		for (const auto& t : parts)
+			n += t.n;
+		char* d = (char*)allocate(n, 1);
+		char* q = d;
+		for (const auto& t : parts)
+		{
+			if (t.n)
+				memcpy(q, t.p, t.n);
+			q += t.n;
+		}
+		return text_view(d, n);
+	}
+
+	// everything allocated is gone, the first block is kept for reuse
+	// (scratch of one line or record)
+	void reset()
+	{
+		for (size_t i = 1; i < blocks.size(); i++)
+			free(blocks[i].p);
+		if (blocks.size() > 1)
+			blocks.resize(1);
+		cur = blocks.empty() ? nullptr : blocks[0].p;
+		left = blocks.empty() ? 0 : blocks[0].size;
+	}
+
+	// the blocks of o are freed with this arena, o is empty; texts in o
+	// stay valid (i.e. results of a parser thread)
+	void adopt(parse_arena&& o)
+	{
+		// the current block (the last one) stays the one allocated from
+		if (blocks.empty())
+		{
+			cur = o.cur;
+			left = o.left;
+		}
+		blocks.insert(blocks.end() - std::min<size_t>(1, blocks.size()), o.blocks.begin(), o.blocks.end());
+		o.blocks.clear();
+		o.cur = nullptr;
+		o.left = 0;
+	}
+
+private:
+	struct block
+	{
+		char* p;
+		size_t size;
+	};
+	std::vector<block> blocks;
+	char* cur = nullptr;		// free part of blocks.back()
+	size_t left = 0;
+	size_t block_size;
+};
+
+// containers in an arena (i.e. maps of level names), deallocate does
+// nothing, the memory goes with the arena
+template<class T>
+struct arena_allocator
+{
+	typedef T value_type;
+	parse_arena* arena;
+
+	arena_allocator(parse_arena& a) : arena(&a) {}
+	template<class U>
+	arena_allocator(const arena_allocator<U>& o) : arena(o.arena) {}
+
+	T* allocate(size_t n) { return (T*)arena->allocate(n * sizeof(T), alignof(T)); }
+	void deallocate(T*, size_t) {}
+};
+
+template<class T, class U>
+inline bool operator==(const arena_allocator<T>& a, const arena_allocator<U>& b)
+{
+	return a.arena == b.arena;
+}
+
+template<class T, class U>
+inline bool operator!=(const arena_allocator<T>& a, const arena_allocator<U>& b)
+{
+	return a.arena != b.arena;
+}
+
+// map by name, keys and nodes in an arena:
+// text_map<int> names((text_map<int>::allocator_type(arena)))
+template<class T>
+using text_map = std::unordered_map<text_view, T, text_view_hash, std::equal_to<text_view>, arena_allocator<std::pair<const text_view, T>>>;
+
+//------------------------------------------------------------------------
+// fields of a line in place; where the result could differ from reading
+// with a stream the scanners return false and the caller reads the line
+// as before
+//------------------------------------------------------------------------
+
+// next field as plain decimal number (digits, sign, point, exponent),
+// read completely by strtod and in range; then it is the same value as
+// from a stream
+inline bool parse_number(const char*& p, double& x)
+{
+	while (isspace((unsigned char)*p))
+		p++;
+	const char* q = p;
+	while (*q && (isdigit((unsigned char)*q) || *q == '.' || *q == '-' || *q == '+' || *q == 'e' || *q == 'E'))
+		q++;
+	if (q == p || (*q && !isspace((unsigned char)*q)))
+		return false;
+	char* end;
+	int saved = errno;
+	errno = 0;
+	x = strtod(p, &end);
+	bool range = errno == ERANGE;
+	errno = saved;
+	if (end != q || range)
+		return false;
+	p = q;
+	return true;
+}
+
+// next field up to white space, false at the end
+inline bool parse_word(const char*& p, text_view& w)
+{
+	while (isspace((unsigned char)*p))
+		p++;
+	const char* q = p;
+	while (*q && !isspace((unsigned char)*q))
+		q++;
+	if (q == p)
+		return false;
+	w = text_view(p, q - p);
+	p = q;
+	return true;
+}
+
+inline bool parse_word(const char*& p)
+{
+	text_view w;
+	return parse_word(p, w);
+}
+
+// first word of a fixed column, empty if it is blank
+inline text_view parse_word(const text_view& t)
+{
+	size_t b = 0;
+	while (b < t.n && isspace((unsigned char)t.p[b]))
+		b++;
+	size_t e = b;
+	while (e < t.n && !isspace((unsigned char)t.p[e]))
+		e++;
+	return text_view(t.p + b, e - b);
+}
+
+// integer at the start of t as "t >> x" reads it: blanks, sign, digits;
+// x is 0 and false if there is none
+inline bool parse_int(const text_view& t, int& x)
+{
+	size_t i = 0;
+	while (i < t.n && isspace((unsigned char)t.p[i]))
+		i++;
+	bool neg = i < t.n && t.p[i] == '-';
+	if (i < t.n && (t.p[i] == '-' || t.p[i] == '+'))
+		i++;
+	long long v = 0;
+	size_t d = i;
+	for (; i < t.n && isdigit((unsigned char)t.p[i]); i++)
+		v = std::min(v * 10 + (t.p[i] - '0'), (long long)INT_MAX + 1);
+	if (i == d)
+	{
+		x = 0;
+		return false;
+	}
+	v = neg ? -v : v;
+	x = (int)std::max((long long)INT_MIN, std::min(v, (long long)INT_MAX));
+	return v >= INT_MIN && v <= INT_MAX;
+}
+
+// number at the start of t as std::stof reads it: false if there is none
+// (invalid_argument there), out of range throws as there
+inline bool parse_stof(const text_view& t, float& x)
+{
+	char buf[64];
+	if (t.n >= sizeof(buf))
+	{
+		try
+		{
+			x = std::stof(t.str());
+		}
+		catch (std::invalid_argument const&)
+		{
+			return false;
+		}
+		return true;
+	}
+	memcpy(buf, t.p, t.n);
+	buf[t.n] = 0;
+	char* end;
+	int saved = errno;
+	errno = 0;
+	float v = strtof(buf, &end);
+	bool range = errno == ERANGE;
+	errno = saved;
+	if (end == buf)
+		return false;
+	if (range)
+		throw std::out_of_range("stof");
+	x = v;
+	return true;
+}
+
+#endif
@@ -0,0 +1,200 @@
+//========================================================================
+// Name        : partition_function.cpp
+// Author      : Michael Knoerzer
+// Version     : 1.0 (2026-10-18)
+// Copyright   : Copyright (c) 2026
+// Description : Partition function U(T) = sum g*exp(-E/kT) from any
+//             : level source on a temperature grid
+//             : compile with -O3 -fno-trapping-math -pthread,
+//             : see vec_math.h
+//             : C++11 !
+//========================================================================
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <thread>
+#include <algorithm>
+#include <math.h>
+#include "atomic_data.h"
+#include "vec_math.h"
+using namespace std;
+
+// second radiation constant hc/k in cm K
+const double c2 = 1.438776877;
+
+// level table as columns, energies relative to the lowest level
+struct level_columns
+{
+	vector<double> E;
+	vector<double> g;
+};
+
+// U(T) for one temperature, exp kernel on blocks that stay in L1 cache
+double partition_function(const level_columns& lev, double T, vector<double>& w)
+{
+	const size_t block = w.size();
+	const size_t n = lev.E.size();
+	double U = 0.0;
+	for (size_t i0 = 0; i0 < n; i0 += block)
+	{
+		const size_t m = min(block, n - i0);
+		vexp_scaled(&lev.E[i0], -c2 / T, &w[0], m);
+		const double* g = &lev.g[i0];
+		double sum = 0.0;
+		for (size_t i = 0; i < m; i++)
+			sum += g[i] * w[i];
+		U += sum;
+	}
+	return U;
+}
+
+// parse <min>:<max>:<step>
+bool parse_range(const string& s, double& min, double& max, double& step)
+{
+	stringstream ss(s);
+	char c1, c2;
+	return (ss >> min >> c1 >> max >> c2 >> step) && c1 == ':' && c2 == ':' && step > 0.0;
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc < 2)
+	{
+		cout << "\nUsage: partition_function <source> <options>\n";
+		cout << "\nSources: tosslev:<file>, adamant:<level file>, tmad:<file>, nist:<file>, toss:<file>\n";
+		cout << "tosslev: the level names only hold the integer part of J, U(T) is only\n";
+		cout << "         valid if all J are integer (even number of electrons)\n";
+		cout << "\nOptions: T=<min>:<max>:<step>, T=<T1>,<T2>,..., logT=<min>:<max>:<step>,\n";
+		cout << "         e=<number>, threads=<number>, out=<file>\n";
+		cout << "T/logT: temperature grid in K (default logT=3:6:0.1)\n";
+		cout << "e:      only use levels with energy < e\n";
+		cout << "threads: number of threads (default: all cores)\n";
+		cout << "out:    write the table to a file instead of the screen" << endl;
+		return 0;
+	}
+
+	// default values
+	vector<double> temps;
+	double skip_e = 9.9e+30;
+	unsigned nthreads = thread::hardware_concurrency();
+	string out_file;
+
+	for (int i = 2; i < argc; i++)
+	{
+		string s(argv[i]);
+		double min, max, step;
+		if (s.substr(0, 2) == "T=" && parse_range(s.substr(2), min, max, step))
+		{
+			for (double t = min; t <= max * (1 + 1e-12); t += step)
+				temps.push_back(t);
+		}
+		else if (s.substr(0, 2) == "T=")
+		{
+			stringstream ss(s.substr(2));
+			string t;
+			while (getline(ss, t, ','))
+				temps.push_back(atof(t.c_str()));
+		}
+		else if (s.substr(0, 5) == "logT=" && parse_range(s.substr(5), min, max, step))
+		{
+			for (double t = min; t <= max + step * 1e-6; t += step)
+				temps.push_back(pow(10.0, t));
+		}
+		else if (s.substr(0, 2) == "e=")
+		{
+			stringstream ss(s.substr(2));
+			ss >> skip_e;
+		}
+		else if (s.substr(0, 8) == "threads=")
+		{
+			stringstream ss(s.substr(8));
+			ss >> nthreads;
+		}
+		else if (s.substr(0, 4) == "out=")
+		{
+			out_file = s.substr(4);
+		}
+	}
+	if (temps.empty())
+	{
+		for (double t = 3.0; t <= 6.0 + 1e-6; t += 0.1)
+			temps.push_back(pow(10.0, t));
+	}
+	temps.erase(remove_if(temps.begin(), temps.end(), [](double t) { return !(t > 0.0); }), temps.end());
+	if (nthreads < 1)
+		nthreads = 1;
+
+	// read levels
+	atomic_data data;
+	cout << "** attempting to read source: " << argv[1] << endl;
+	if (!read_source(argv[1], data))
+	{
+		cout << "** ERROR: couldn't read source: " << argv[1] << endl;
+		return -1;
+	}
+	if (data.levels.empty())
+	{
+		cout << "** found no levels **" << endl;
+		return -1;
+	}
+	if (data.J_truncated)
+	{
+		cout << "** WARNING: the source only gives the integer part of J, g = 2J+1 is wrong" << endl;
+		cout << "**          for half-integer J (odd number of electrons), so is U(T)" << endl;
+	}
+
+	// structure of arrays, relative to the lowest level
+	level_columns lev;
+	double e0 = 9.9e+30;
+	for (const auto& l : data.levels)
+		e0 = std::min(e0, l.energy);
+	for (const auto& l : data.levels)
+	{
+		if (l.energy >= skip_e)
+			continue;
+		lev.E.push_back(l.energy - e0);
+		lev.g.push_back(2 * l.J + 1);
+	}
+	cout << "** " << lev.E.size() << " levels, " << temps.size() << " temperatures, " << nthreads << " threads" << endl;
+
+	// temperatures are distributed over the threads in an interleaved way,
+	// every thread has its own buffer for the Boltzmann factors
+	vector<double> U(temps.size());
+	vector<thread> threads;
+	for (unsigned t = 0; t < nthreads; t++)
+	{
+		threads.push_back(thread([&, t]()
+		{
+			vector<double> w(1024);
+			for (size_t i = t; i < temps.size(); i += nthreads)
+				U[i] = partition_function(lev, temps[i], w);
+		}));
+	}
+	for (auto& t : threads)
+		t.join();
+
+	// output
+	ofstream out;
+	if (!out_file.empty())
+	{
+		out.open(out_file.c_str());
+		if (!out.is_open())
+		{
+			cout << "** ERROR: couldn't open file: " << out_file << endl;
+			return -1;
+		}
+	}
+	ostream& os = out.is_open() ? out : cout;
+	os << "#           T            U(T)      log U(T)" << endl;
+	for (size_t i = 0; i < temps.size(); i++)
+	{
+		os << setw(13) << fixed << setprecision(1) << temps[i] << " " << setw(15) << scientific << setprecision(6) << U[i]
+			<< " " << setw(13) << fixed << setprecision(6) << log10(U[i]) << endl;
+	}
+
+	return 0;
+}
@@ -0,0 +1,282 @@
+//========================================================================
+// Name        : pipeline.h
+// Author      : Michael Knoerzer
+// Version     : 1.0 (2026-10-18)
+// Copyright   : Copyright (c) 2026
+// Description : Reader thread -> parser threads -> collector -> writer
+//             : thread, connected by bounded lock-free single producer/
+//             : single consumer queues; results are collected in input
+//             : order, so the output is the same as with one thread;
+//             : a thread that waits longer than a few spins sleeps
+//             : compile with -pthread
+//             : C++11 !
+//========================================================================
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <istream>
+#include <ostream>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <algorithm>
+
+//------------------------------------------------------------------------
+// wait of one side of a queue: spin a little (the other side is usually
+// just about to move), then sleep until notify(); an idle parser or writer
+// thread does not keep a core busy
+//------------------------------------------------------------------------
+class pipeline_signal
+{
+public:
+	// returns when ready() is true
+	template<class Ready>
+	void wait(Ready ready)
+	{
+		for (int spins = 0; spins < 64; spins++)
+		{
+			if (ready())
+				return;
+		}
+		std::unique_lock<std::mutex> lock(m);
+		sleepers.fetch_add(1);
+		// pairs with the fence in notify(): either the waiter sees the
+		// change or notify() sees the sleeper
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		cv.wait(lock, ready);
+		sleepers.fetch_sub(1);
+	}
+
+	// after the queue changed, wakes the other side if it sleeps
+	void notify()
+	{
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (sleepers.load(std::memory_order_relaxed) > 0)
+		{
+			std::lock_guard<std::mutex> lock(m);
+			cv.notify_all();
+		}
+	}
+
+private:
+	std::mutex m;
+	std::condition_variable cv;
+	std::atomic<int> sleepers { 0 };
+};
+
+//------------------------------------------------------------------------
+// bounded queue for exactly one producer and one consumer thread
+//------------------------------------------------------------------------
+template<class T>
+class spsc_queue
+{
+public:
+	explicit spsc_queue(size_t capacity = 8)
+	{
+		size_t n = 2;
+		while (n < capacity)
+			n *= 2;
+		items.resize(n);
+		mask = n - 1;
+	}
+
+	// waits while the queue is full
+	void push(T&& v)
+	{
+		const size_t t = tail.load(std::memory_order_relaxed);
+		signal.wait([&]() { return t - head.load(std::memory_order_acquire) <= mask; });
+		items[t & mask] = std::move(v);
+		tail.store(t + 1, std::memory_order_release);
+		signal.notify();
+	}
+
+	// waits while the queue is empty
+	T pop()
+	{
+		const size_t h = head.load(std::memory_order_relaxed);
+		signal.wait([&]() { return tail.load(std::memory_order_acquire) != h; });
+		T v = std::move(items[h & mask]);
+		head.store(h + 1, std::memory_order_release);
+		signal.notify();
+		return v;
+	}
+
+private:
+	std::vector<T> items;
+	size_t mask;
+	// producer and consumer counters on separate cache lines
+	char pad0[64];
+	std::atomic<size_t> head { 0 };
+	char pad1[64];
+	std::atomic<size_t> tail { 0 };
+	char pad2[64];
+	// only one side waits at a time: the queue is either full or empty
+	pipeline_signal signal;
+};
+
+// element of the pipeline queues, end = no more data
+template<class T>
+struct pipeline_item
+{
+	T data;
+	bool end = false;
+};
+
+//------------------------------------------------------------------------
+// input in blocks of whole lines
+//------------------------------------------------------------------------
+
+// about size bytes up to the next line end, false at the end of the stream
+inline bool read_line_batch(std::istream& in, std::string& text, size_t size)
+{
+	text.resize(size);
+	in.read(&text[0], size);
+	text.resize(in.gcount());
+	if (text.empty())
+		return false;
+	if (text.back() != '\n')
+	{
+		std::string rest;
+		if (std::getline(in, rest))
+			text += rest;
+		text += '\n';
+	}
+	return true;
+}
+
+// f(line) for every line of a batch, same lines as getline would give
+template<class F>
+inline void for_each_line(const std::string& text, F f)
+{
+	std::string line;
+	size_t p = 0;
+	while (p < text.size())
+	{
+		size_t nl = text.find('\n', p);
+		if (nl == std::string::npos)
+			nl = text.size();
+		line.assign(text, p, nl - p);
+		f(line);
+		p = nl + 1;
+	}
+}
+
+//------------------------------------------------------------------------
+// reader thread + parser threads, consume() is called on this thread in
+// input order: batch k goes to worker k % workers, so taking the results
+// round robin restores the order without sorting
+//------------------------------------------------------------------------
+template<class Result, class Parse, class Consume>
+void run_line_pipeline(std::istream& in, unsigned workers, Parse parse, Consume consume, size_t batch_size = 1 << 20)
+{
+	workers = std::max(1u, workers);
+	std::vector<std::unique_ptr<spsc_queue<pipeline_item<std::string>>>> input;
+	std::vector<std::unique_ptr<spsc_queue<pipeline_item<Result>>>> output;
+	for (unsigned w = 0; w < workers; w++)
+	{
+		input.emplace_back(new spsc_queue<pipeline_item<std::string>>(4));
+		output.emplace_back(new spsc_queue<pipeline_item<Result>>(4));
+	}
+
+	std::thread reader([&]()
+	{
+		size_t k = 0;
+		pipeline_item<std::string> item;
+		while (read_line_batch(in, item.data, batch_size))
+		{
+			input[k++ % workers]->push(std::move(item));
+			item = pipeline_item<std::string>();
+		}
+		for (unsigned w = 0; w < workers; w++)
+		{
+			item.end = true;
+			input[(k + w) % workers]->push(std::move(item));
+		}
+	});
+
+	std::vector<std::thread> parsers;
+	for (unsigned w = 0; w < workers; w++)
+	{
+		parsers.push_back(std::thread([&, w]()
+		{
+			while (true)
+			{
+				pipeline_item<std::string> batch = input[w]->pop();
+				pipeline_item<Result> res;
+				if (batch.end)
+				{
+					res.end = true;
+					output[w]->push(std::move(res));
+					break;
+				}
+				parse(batch.data, res.data);
+				output[w]->push(std::move(res));
+			}
+		}));
+	}
+
+	for (size_t k = 0;; k++)
+	{
+		pipeline_item<Result> res = output[k % workers]->pop();
+		if (res.end)
+			break;
+		consume(res.data);
+	}
+
+	reader.join();
+	for (auto& t : parsers)
+		t.join();
+}
+
+//------------------------------------------------------------------------
+// writer thread: formatted text is written while the next is prepared
+//------------------------------------------------------------------------
+class async_writer
+{
+public:
+	explicit async_writer(std::ostream& _out, size_t capacity = 16): out(_out), queue(capacity)
+	{
+		worker = std::thread([this]()
+		{
+			while (true)
+			{
+				pipeline_item<std::string> item = queue.pop();
+				if (item.end)
+					break;
+				out.write(item.data.data(), item.data.size());
+			}
+			out.flush();
+		});
+	}
+
+	~async_writer() { close(); }
+
+	void write(std::string&& text)
+	{
+		pipeline_item<std::string> item;
+		item.data = std::move(text);
+		queue.push(std::move(item));
+	}
+
+	// waits until everything is written
+	void close()
+	{
+		if (!worker.joinable())
+			return;
+		pipeline_item<std::string> item;
+		item.end = true;
+		queue.push(std::move(item));
+		worker.join();
+	}
+
+private:
+	std::ostream& out;
+	spsc_queue<pipeline_item<std::string>> queue;
+	std::thread worker;
+};
+
+#endif
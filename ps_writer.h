@@ -0,0 +1,351 @@
+//========================================================================
+// Name        : ps_writer.h
+// Author      : Michael Knoerzer
+// Version     : 1.0 (2026-10-18)
+// Copyright   : Copyright (c) 2026
+// Description : Compact PostScript for the Grotrian and fplot figures
+//             : (same drawing as the raster preview): segments are
+//             : batched by pen and colour, contiguous ones are chained
+//             : into one path, collinear steps merged, relative moves in
+//             : 0.1 pt and a procedure for every repeated level bar
+//             : C++11 !
+//========================================================================
+#ifndef PS_WRITER_H
+#define PS_WRITER_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <deque>
+#include <sstream>
+#include <fstream>
+#include <iomanip>
+#include <algorithm>
+#include <math.h>
+#include "raster_preview.h"
+
+//------------------------------------------------------------------------
+// A3 landscape page in the coordinates of a raster_canvas (w x h units,
+// y downwards); line() and text() only collect, write() sorts and merges
+//------------------------------------------------------------------------
+class ps_writer
+{
+public:
+	ps_writer(int w = 1600, int h = 1130) : w(w), h(h)
+	{
+		scale = std::min(1190.55 / w, 841.89 / h);
+	}
+
+	int width() const { return w; }
+	int height() const { return h; }
+
+	void line(double x1, double y1, double x2, double y2, raster_color c, int width = 1)
+	{
+		segment s = { pt_x(x1), pt_y(y1), pt_x(x2), pt_y(y2) };
+		if (s.x1 == s.x2 && s.y1 == s.y2)
+			return;
+		batch_of(c, std::max(1, width)).segs.push_back(s);
+	}
+
+	// same placement as raster_canvas::text: top at y, align 0/1/2 for
+	// left/centred/right, size from the 7 pixel high bitmap font
+	void text(double x, double y, const std::string& s, raster_color c, int scale_ = 1, int align = 0)
+	{
+		label l = { pt_x(x), pt_y(y + 7 * scale_), s, align };
+		long size = (long)floor(7.0 * scale_ / 0.72 * scale * 10 + 0.5);
+		text_batch_of(c, size).labels.push_back(l);
+	}
+
+	void write(std::ostream& out) const;
+
+	bool write(const std::string& file) const
+	{
+		std::ofstream out(file.c_str());
+		write(out);
+		return out.good();
+	}
+
+private:
+	// coordinates in 0.1 pt, so relative moves add up exactly
+	struct segment
+	{
+		long x1, y1, x2, y2;
+	};
+	struct batch
+	{
+		raster_color c;
+		int width;
+		std::vector<segment> segs;
+	};
+	struct label
+	{
+		long x, y;
+		std::string s;
+		int align;
+	};
+	struct text_batch
+	{
+		raster_color c;
+		long size;
+		std::vector<label> labels;
+	};
+
+	long pt_x(double x) const { return (long)floor(x * scale * 10 + 0.5); }
+	long pt_y(double y) const { return (long)floor((h - y) * scale * 10 + 0.5); }
+
+	static long color_key(raster_color c) { return (c.r << 16) | (c.g << 8) | c.b; }
+
+	batch& batch_of(raster_color c, int width)
+	{
+		auto key = std::make_pair(color_key(c), (long)width);
+		auto it = batch_index.find(key);
+		if (it != batch_index.end())
+			return batches[it->second];
+		batch_index[key] = batches.size();
+		batches.push_back({ c, width, std::vector<segment>() });
+		return batches.back();
+	}
+
+	text_batch& text_batch_of(raster_color c, long size)
+	{
+		auto key = std::make_pair(color_key(c), size);
+		auto it = text_index.find(key);
+		if (it != text_index.end())
+			return texts[it->second];
+		text_index[key] = texts.size();
+		texts.push_back({ c, size, std::vector<label>() });
+		return texts.back();
+	}
+
+	int w, h;
+	double scale;
+	std::vector<batch> batches;			// in order of first use
+	std::map<std::pair<long, long>, size_t> batch_index;
+	std::vector<text_batch> texts;
+	std::map<std::pair<long, long>, size_t> text_index;
+};
+
+// 0.1 pt units as a number, "12.3", "-0.5", "7"
+inline void ps_number(std::ostream& out, long t)
+{
+	if (t < 0)
+	{
+		out << '-';
+		t = -t;
+	}
+	out << t / 10;
+	if (t % 10)
+		out << '.' << t % 10;
+}
+
+inline void ps_color(std::ostream& out, raster_color c)
+{
+	out << std::setprecision(3);
+	if (c.r == c.g && c.g == c.b)
+		out << c.r / 255.0 << " setgray\n";
+	else
+		out << c.r / 255.0 << " " << c.g / 255.0 << " " << c.b / 255.0 << " setrgbcolor\n";
+}
+
+inline std::string ps_string(const std::string& s)
+{
+	std::string r = "(";
+	for (char ch : s)
+	{
+		if (ch == '(' || ch == ')' || ch == '\\')
+			r += '\\';
+		r += ch;
+	}
+	return r + ")";
+}
+
+inline void ps_writer::write(std::ostream& out) const
+{
+	out << std::fixed;
+
+	// level bars: horizontal segments of a length used at least 3 times
+	// get a procedure "x y Hn"
+	std::map<long, int> bar_count;
+	for (const auto& b : batches)
+		for (const auto& s : b.segs)
+			if (s.y1 == s.y2)
+				bar_count[std::abs(s.x2 - s.x1)]++;
+	std::map<long, int> bars;
+	for (const auto& bc : bar_count)
+		if (bc.second >= 3)
+		{
+			int n = bars.size();
+			bars[bc.first] = n;
+		}
+
+	out << "%!PS-Adobe-3.0\n";
+	out << "%%BoundingBox: 0 0 842 1191\n";
+	out << "%%Pages: 1\n";
+	out << "%%EndComments\n";
+	out << "/M { moveto } bind def\n";
+	out << "/RD { rlineto } bind def\n";
+	out << "/RM { rmoveto } bind def\n";
+	out << "/F { /Helvetica findfont exch scalefont setfont } bind def\n";
+	out << "/SL { M show } bind def\n";
+	out << "/SC { M dup stringwidth pop -2 div 0 RM show } bind def\n";
+	out << "/SR { M dup stringwidth pop neg 0 RM show } bind def\n";
+	for (const auto& b : bars)
+	{
+		out << "/H" << b.second << " { M ";
+		ps_number(out, b.first);
+		out << " 0 RD } bind def\n";
+	}
+	out << "%%EndProlog\n";
+	out << "%%Page: 1 1\n";
+	out << "842 0 translate 90 rotate\n";
+	out << "1 setlinecap 1 setlinejoin\n";
+
+	for (const auto& b : batches)
+	{
+		out << std::setprecision(1) << 0.4 * b.width << " setlinewidth\n";
+		ps_color(out, b.c);
+		out << "newpath\n";
+		size_t elements = 0;
+		auto split = [&](size_t n)
+		{
+			// long paths are split before a new sub-path, old
+			// interpreters have a limit
+			if (elements + n > 1000 && elements > 0)
+			{
+				out << "stroke newpath\n";
+				elements = 0;
+			}
+			elements += n;
+		};
+
+		// bars first, the rest is chained
+		std::vector<int> rest;
+		for (size_t i = 0; i < b.segs.size(); i++)
+		{
+			const segment& s = b.segs[i];
+			auto it = s.y1 == s.y2 ? bars.find(std::abs(s.x2 - s.x1)) : bars.end();
+			if (it == bars.end())
+			{
+				rest.push_back(i);
+				continue;
+			}
+			split(2);
+			ps_number(out, std::min(s.x1, s.x2));
+			out << " ";
+			ps_number(out, s.y1);
+			out << " H" << it->second << "\n";
+		}
+
+		// segments at every end point
+		auto key = [](long x, long y) { return ((unsigned long long)x << 32) ^ (unsigned long long)(y & 0xFFFFFFFFL); };
+		std::unordered_map<unsigned long long, std::vector<int>> at;
+		for (int i : rest)
+		{
+			const segment& s = b.segs[i];
+			at[key(s.x1, s.y1)].push_back(i);
+			at[key(s.x2, s.y2)].push_back(i);
+		}
+		std::vector<char> used(b.segs.size(), 0);
+		auto next = [&](long x, long y, long& nx, long& ny)
+		{
+			auto it = at.find(key(x, y));
+			if (it == at.end())
+				return false;
+			for (int i : it->second)
+			{
+				if (used[i])
+					continue;
+				used[i] = 1;
+				const segment& s = b.segs[i];
+				bool fwd = s.x1 == x && s.y1 == y;
+				nx = fwd ? s.x2 : s.x1;
+				ny = fwd ? s.y2 : s.y1;
+				return true;
+			}
+			return false;
+		};
+
+		for (int i : rest)
+		{
+			if (used[i])
+				continue;
+			used[i] = 1;
+			const segment& s = b.segs[i];
+			std::deque<std::pair<long, long>> chain = { { s.x1, s.y1 }, { s.x2, s.y2 } };
+			long nx, ny;
+			while (next(chain.back().first, chain.back().second, nx, ny))
+				chain.push_back(std::make_pair(nx, ny));
+			while (next(chain.front().first, chain.front().second, nx, ny))
+				chain.push_front(std::make_pair(nx, ny));
+
+			split(chain.size());
+			ps_number(out, chain[0].first);
+			out << " ";
+			ps_number(out, chain[0].second);
+			out << " M\n";
+			long dx = 0, dy = 0;
+			for (size_t k = 1; k < chain.size(); k++)
+			{
+				long ex = chain[k].first - chain[k - 1].first;
+				long ey = chain[k].second - chain[k - 1].second;
+				// collinear and the same direction: one step
+				if ((dx || dy) && dx * ey == dy * ex && dx * ex + dy * ey > 0)
+				{
+					dx += ex;
+					dy += ey;
+					continue;
+				}
+				if (dx || dy)
+				{
+					ps_number(out, dx);
+					out << " ";
+					ps_number(out, dy);
+					out << " RD\n";
+				}
+				dx = ex;
+				dy = ey;
+			}
+			ps_number(out, dx);
+			out << " ";
+			ps_number(out, dy);
+			out << " RD\n";
+		}
+		out << "stroke\n";
+	}
+
+	for (const auto& t : texts)
+	{
+		ps_color(out, t.c);
+		ps_number(out, t.size);
+		out << " F\n";
+		for (const auto& l : t.labels)
+		{
+			out << ps_string(l.s) << " ";
+			ps_number(out, l.x);
+			out << " ";
+			ps_number(out, l.y);
+			out << (l.align == 1 ? " SC\n" : (l.align == 2 ? " SR\n" : " SL\n"));
+		}
+	}
+	out << "showpage\n";
+	out << "%%EOF\n";
+}
+
+// Grotrian panels / fplot idents as PostScript; false if the file could
+// not be written
+inline bool write_grotrian_ps(const std::string& file, const std::vector<raster_grotrian_panel>& panels, const grotrian_options& opt)
+{
+	ps_writer ps;
+	draw_grotrian(ps, panels, opt);
+	return ps.write(file);
+}
+
+inline bool write_fplot_ps(const std::string& file, const std::vector<fplot_ident>& idents, const std::string& title)
+{
+	ps_writer ps(1600, 900);
+	draw_fplot(ps, idents, title);
+	return ps.write(file);
+}
+
+#endif
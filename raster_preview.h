@@ -0,0 +1,599 @@
+//========================================================================
+// Name        : raster_preview.h
+// Author      : Michael Knoerzer
+// Version     : 1.0 (2026-10-18)
+// Copyright   : Copyright (c) 2026
+// Description : Quick look at a Grotrian layout or at fplot idents
+//             : without WRPLOT: PNG or PPM image drawn with anti-aliased
+//             : lines (Wu) and a built-in 5x7 bitmap font; the image is
+//             : cut into tiles which are drawn on worker threads
+//             : PNG: zlib with -DHAVE_ZLIB -lz, else uncompressed
+//             : compile with -pthread
+//             : C++11 !
+//========================================================================
+#ifndef RASTER_PREVIEW_H
+#define RASTER_PREVIEW_H
+
+#include <string>
+#include <vector>
+#include <sstream>
+#include <fstream>
+#include <iomanip>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <math.h>
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+#include "grotrian_layout.h"
+#include "fplot_idents.h"
+
+struct raster_color
+{
+	unsigned char r, g, b;
+};
+
+const raster_color raster_black = { 0, 0, 0 };
+const raster_color raster_white = { 255, 255, 255 };
+const raster_color raster_grey = { 153, 153, 153 };	// colour 9 of the diagrams
+
+// WRPLOT colour numbers as used by the tools
+inline raster_color raster_wrplot_color(int c)
+{
+	switch (c)
+	{
+	case 2: return { 204, 0, 0 };
+	case 3: return { 0, 0, 204 };
+	case 4: return { 0, 153, 0 };
+	case 9: return raster_grey;
+	default: return raster_black;
+	}
+}
+
+// 5x7 font for ASCII 32-126, one byte per column, bit 0 is the top row
+const unsigned char raster_font[95][5] = {
+	{ 0x00, 0x00, 0x00, 0x00, 0x00 }, { 0x00, 0x00, 0x5F, 0x00, 0x00 }, { 0x00, 0x07, 0x00, 0x07, 0x00 }, { 0x14, 0x7F, 0x14, 0x7F, 0x14 },
+	{ 0x24, 0x2A, 0x7F, 0x2A, 0x12 }, { 0x23, 0x13, 0x08, 0x64, 0x62 }, { 0x36, 0x49, 0x55, 0x22, 0x50 }, { 0x00, 0x05, 0x03, 0x00, 0x00 },
+	{ 0x00, 0x1C, 0x22, 0x41, 0x00 }, { 0x00, 0x41, 0x22, 0x1C, 0x00 }, { 0x08, 0x2A, 0x1C, 0x2A, 0x08 }, { 0x08, 0x08, 0x3E, 0x08, 0x08 },
+	{ 0x00, 0x50, 0x30, 0x00, 0x00 }, { 0x08, 0x08, 0x08, 0x08, 0x08 }, { 0x00, 0x60, 0x60, 0x00, 0x00 }, { 0x20, 0x10, 0x08, 0x04, 0x02 },
+	{ 0x3E, 0x51, 0x49, 0x45, 0x3E }, { 0x00, 0x42, 0x7F, 0x40, 0x00 }, { 0x42, 0x61, 0x51, 0x49, 0x46 }, { 0x21, 0x41, 0x45, 0x4B, 0x31 },
+	{ 0x18, 0x14, 0x12, 0x7F, 0x10 }, { 0x27, 0x45, 0x45, 0x45, 0x39 }, { 0x3C, 0x4A, 0x49, 0x49, 0x30 }, { 0x01, 0x71, 0x09, 0x05, 0x03 },
+	{ 0x36, 0x49, 0x49, 0x49, 0x36 }, { 0x06, 0x49, 0x49, 0x29, 0x1E }, { 0x00, 0x36, 0x36, 0x00, 0x00 }, { 0x00, 0x56, 0x36, 0x00, 0x00 },
+	{ 0x08, 0x14, 0x22, 0x41, 0x00 }, { 0x14, 0x14, 0x14, 0x14, 0x14 }, { 0x00, 0x41, 0x22, 0x14, 0x08 }, { 0x02, 0x01, 0x51, 0x09, 0x06 },
+	{ 0x32, 0x49, 0x79, 0x41, 0x3E }, { 0x7E, 0x11, 0x11, 0x11, 0x7E }, { 0x7F, 0x49, 0x49, 0x49, 0x36 }, { 0x3E, 0x41, 0x41, 0x41, 0x22 },
+	{ 0x7F, 0x41, 0x41, 0x22, 0x1C }, { 0x7F, 0x49, 0x49, 0x49, 0x41 }, { 0x7F, 0x09, 0x09, 0x09, 0x01 }, { 0x3E, 0x41, 0x49, 0x49, 0x7A },
+	{ 0x7F, 0x08, 0x08, 0x08, 0x7F }, { 0x00, 0x41, 0x7F, 0x41, 0x00 }, { 0x20, 0x40, 0x41, 0x3F, 0x01 }, { 0x7F, 0x08, 0x14, 0x22, 0x41 },
+	{ 0x7F, 0x40, 0x40, 0x40, 0x40 }, { 0x7F, 0x02, 0x0C, 0x02, 0x7F }, { 0x7F, 0x04, 0x08, 0x10, 0x7F }, { 0x3E, 0x41, 0x41, 0x41, 0x3E },
+	{ 0x7F, 0x09, 0x09, 0x09, 0x06 }, { 0x3E, 0x41, 0x51, 0x21, 0x5E }, { 0x7F, 0x09, 0x19, 0x29, 0x46 }, { 0x46, 0x49, 0x49, 0x49, 0x31 },
+	{ 0x01, 0x01, 0x7F, 0x01, 0x01 }, { 0x3F, 0x40, 0x40, 0x40, 0x3F }, { 0x1F, 0x20, 0x40, 0x20, 0x1F }, { 0x3F, 0x40, 0x38, 0x40, 0x3F },
+	{ 0x63, 0x14, 0x08, 0x14, 0x63 }, { 0x07, 0x08, 0x70, 0x08, 0x07 }, { 0x61, 0x51, 0x49, 0x45, 0x43 }, { 0x00, 0x7F, 0x41, 0x41, 0x00 },
+	{ 0x02, 0x04, 0x08, 0x10, 0x20 }, { 0x00, 0x41, 0x41, 0x7F, 0x00 }, { 0x04, 0x02, 0x01, 0x02, 0x04 }, { 0x40, 0x40, 0x40, 0x40, 0x40 },
+	{ 0x00, 0x01, 0x02, 0x04, 0x00 }, { 0x20, 0x54, 0x54, 0x54, 0x78 }, { 0x7F, 0x48, 0x44, 0x44, 0x38 }, { 0x38, 0x44, 0x44, 0x44, 0x20 },
+	{ 0x38, 0x44, 0x44, 0x48, 0x7F }, { 0x38, 0x54, 0x54, 0x54, 0x18 }, { 0x08, 0x7E, 0x09, 0x01, 0x02 }, { 0x0C, 0x52, 0x52, 0x52, 0x3E },
+	{ 0x7F, 0x08, 0x04, 0x04, 0x78 }, { 0x00, 0x44, 0x7D, 0x40, 0x00 }, { 0x20, 0x40, 0x44, 0x3D, 0x00 }, { 0x7F, 0x10, 0x28, 0x44, 0x00 },
+	{ 0x00, 0x41, 0x7F, 0x40, 0x00 }, { 0x7C, 0x04, 0x18, 0x04, 0x78 }, { 0x7C, 0x08, 0x04, 0x04, 0x78 }, { 0x38, 0x44, 0x44, 0x44, 0x38 },
+	{ 0x7C, 0x14, 0x14, 0x14, 0x08 }, { 0x08, 0x14, 0x14, 0x18, 0x7C }, { 0x7C, 0x08, 0x04, 0x04, 0x08 }, { 0x48, 0x54, 0x54, 0x54, 0x20 },
+	{ 0x04, 0x3F, 0x44, 0x40, 0x20 }, { 0x3C, 0x40, 0x40, 0x20, 0x7C }, { 0x1C, 0x20, 0x40, 0x20, 0x1C }, { 0x3C, 0x40, 0x30, 0x40, 0x3C },
+	{ 0x44, 0x28, 0x10, 0x28, 0x44 }, { 0x0C, 0x50, 0x50, 0x50, 0x3C }, { 0x44, 0x64, 0x54, 0x4C, 0x44 }, { 0x00, 0x08, 0x36, 0x41, 0x00 },
+	{ 0x00, 0x00, 0x7F, 0x00, 0x00 }, { 0x00, 0x41, 0x36, 0x08, 0x00 }, { 0x08, 0x04, 0x08, 0x10, 0x08 }
+};
+
+//------------------------------------------------------------------------
+// image of w x h pixels (RGB, white); line() and text() only collect the
+// primitives, render() sorts them into tiles and draws the tiles on
+// worker threads, every tile in the order the primitives were added
+//------------------------------------------------------------------------
+class raster_canvas
+{
+public:
+	raster_canvas(int w, int h) : w(w), h(h), rgb(3 * (size_t)w * h, 255) {}
+
+	int width() const { return w; }
+	int height() const { return h; }
+	const std::vector<unsigned char>& pixels() const { return rgb; }
+
+	// line between pixel centres, width in pixels
+	void line(double x1, double y1, double x2, double y2, raster_color c, int width = 1)
+	{
+		primitive p = { false, x1, y1, x2, y2, c, std::max(1, width), std::string(), 1 };
+		prims.push_back(p);
+	}
+
+	// text with its top at y; align: 0 left, 1 centred, 2 right of x
+	void text(double x, double y, const std::string& s, raster_color c, int scale = 1, int align = 0)
+	{
+		x -= align * 0.5 * text_width(s, scale);
+		primitive p = { true, floor(x), floor(y), floor(x) + text_width(s, scale), floor(y) + 7 * scale, c, 1, s, scale };
+		prims.push_back(p);
+	}
+
+	static int text_width(const std::string& s, int scale)
+	{
+		return s.empty() ? 0 : (6 * (int)s.size() - 1) * scale;
+	}
+
+	void render(unsigned threads, int tile = 128);
+
+	bool write_ppm(const std::string& file) const;
+	bool write_png(const std::string& file) const;
+
+	// PNG for *.png, else PPM
+	bool write(const std::string& file) const
+	{
+		if (file.size() > 4 && file.compare(file.size() - 4, 4, ".png") == 0)
+			return write_png(file);
+		return write_ppm(file);
+	}
+
+private:
+	struct primitive
+	{
+		bool is_text;
+		double x1, y1, x2, y2;		// line ends, or the box of the text
+		raster_color c;
+		int width;
+		std::string s;
+		int scale;
+	};
+
+	// clip rectangle: one tile
+	struct clip
+	{
+		int x0, y0, x1, y1;
+	};
+
+	void blend(int x, int y, raster_color c, double a)
+	{
+		if (a <= 0.0)
+			return;
+		a = std::min(a, 1.0);
+		unsigned char* p = &rgb[3 * ((size_t)y * w + x)];
+		p[0] = (unsigned char)(p[0] + (c.r - p[0]) * a + 0.5);
+		p[1] = (unsigned char)(p[1] + (c.g - p[1]) * a + 0.5);
+		p[2] = (unsigned char)(p[2] + (c.b - p[2]) * a + 0.5);
+	}
+
+	void draw_line(double x0, double y0, double x1, double y1, raster_color c, const clip& t);
+	void draw_text(const primitive& p, const clip& t);
+
+	int w, h;
+	std::vector<unsigned char> rgb;
+	std::vector<primitive> prims;
+};
+
+// Xiaolin Wu's line, only the pixels inside the tile: the main axis is
+// cut to the tile before stepping
+inline void raster_canvas::draw_line(double x0, double y0, double x1, double y1, raster_color c, const clip& t)
+{
+	const bool steep = fabs(y1 - y0) > fabs(x1 - x0);
+	if (steep)
+	{
+		std::swap(x0, y0);
+		std::swap(x1, y1);
+	}
+	if (x0 > x1)
+	{
+		std::swap(x0, x1);
+		std::swap(y0, y1);
+	}
+	const double grad = x1 == x0 ? 1.0 : (y1 - y0) / (x1 - x0);
+	auto fpart = [](double v) { return v - floor(v); };
+	auto plot = [&](int x, int y, double a)
+	{
+		int px = steep ? y : x;
+		int py = steep ? x : y;
+		if (px >= t.x0 && px < t.x1 && py >= t.y0 && py < t.y1)
+			blend(px, py, c, a);
+	};
+
+	// end points, weighted by the part of the pixel covered
+	double xend = floor(x0 + 0.5);
+	double yend = y0 + grad * (xend - x0);
+	double xgap = 1.0 - fpart(x0 + 0.5);
+	const int xp1 = (int)xend;
+	plot(xp1, (int)floor(yend), (1.0 - fpart(yend)) * xgap);
+	plot(xp1, (int)floor(yend) + 1, fpart(yend) * xgap);
+	double intery = yend + grad;
+
+	xend = floor(x1 + 0.5);
+	yend = y1 + grad * (xend - x1);
+	xgap = fpart(x1 + 0.5);
+	const int xp2 = (int)xend;
+	if (xp2 != xp1)
+	{
+		plot(xp2, (int)floor(yend), (1.0 - fpart(yend)) * xgap);
+		plot(xp2, (int)floor(yend) + 1, fpart(yend) * xgap);
+	}
+
+	int first = xp1 + 1;
+	int last = xp2 - 1;
+	const int lo = steep ? t.y0 : t.x0;
+	const int hi = steep ? t.y1 : t.x1;
+	if (first < lo)
+	{
+		intery += grad * (lo - first);
+		first = lo;
+	}
+	last = std::min(last, hi - 1);
+	for (int x = first; x <= last; x++)
+	{
+		plot(x, (int)floor(intery), 1.0 - fpart(intery));
+		plot(x, (int)floor(intery) + 1, fpart(intery));
+		intery += grad;
+	}
+}
+
+inline void raster_canvas::draw_text(const primitive& p, const clip& t)
+{
+	for (size_t i = 0; i < p.s.size(); i++)
+	{
+		unsigned char ch = p.s[i];
+		const unsigned char* glyph = raster_font[(ch < 32 || ch > 126) ? '?' - 32 : ch - 32];
+		int gx = (int)p.x1 + (int)i * 6 * p.scale;
+		for (int col = 0; col < 5; col++)
+		{
+			for (int row = 0; row < 7; row++)
+			{
+				if (!(glyph[col] & (1 << row)))
+					continue;
+				for (int y = (int)p.y1 + row * p.scale; y < (int)p.y1 + (row + 1) * p.scale; y++)
+					for (int x = gx + col * p.scale; x < gx + (col + 1) * p.scale; x++)
+						if (x >= t.x0 && x < t.x1 && y >= t.y0 && y < t.y1)
+							blend(x, y, p.c, 1.0);
+			}
+		}
+	}
+}
+
+inline void raster_canvas::render(unsigned threads, int tile)
+{
+	const int nx = (w + tile - 1) / tile;
+	const int ny = (h + tile - 1) / tile;
+	if (nx <= 0 || ny <= 0)
+		return;
+
+	// primitives of every tile, from their bounding boxes
+	std::vector<std::vector<int>> bins(nx * ny);
+	for (size_t i = 0; i < prims.size(); i++)
+	{
+		const primitive& p = prims[i];
+		double pad = p.width + 1;
+		int tx0 = std::max(0, (int)floor((std::min(p.x1, p.x2) - pad) / tile));
+		int tx1 = std::min(nx - 1, (int)floor((std::max(p.x1, p.x2) + pad) / tile));
+		int ty0 = std::max(0, (int)floor((std::min(p.y1, p.y2) - pad) / tile));
+		int ty1 = std::min(ny - 1, (int)floor((std::max(p.y1, p.y2) + pad) / tile));
+		for (int ty = ty0; ty <= ty1; ty++)
+			for (int tx = tx0; tx <= tx1; tx++)
+				bins[ty * nx + tx].push_back(i);
+	}
+
+	std::atomic<int> next(0);
+	auto work = [&]()
+	{
+		int k;
+		while ((k = next++) < nx * ny)
+		{
+			clip t = { (k % nx) * tile, (k / nx) * tile, std::min(w, (k % nx + 1) * tile), std::min(h, (k / nx + 1) * tile) };
+			for (int i : bins[k])
+			{
+				const primitive& p = prims[i];
+				if (p.is_text)
+				{
+					draw_text(p, t);
+					continue;
+				}
+				// wider lines: parallel lines one pixel apart
+				double dx = p.x2 - p.x1, dy = p.y2 - p.y1;
+				double len = sqrt(dx * dx + dy * dy);
+				double nxv = len > 0 ? -dy / len : 0.0, nyv = len > 0 ? dx / len : 1.0;
+				for (int j = 0; j < p.width; j++)
+				{
+					double off = j - (p.width - 1) * 0.5;
+					draw_line(p.x1 + off * nxv, p.y1 + off * nyv, p.x2 + off * nxv, p.y2 + off * nyv, p.c, t);
+				}
+			}
+		}
+	};
+	std::vector<std::thread> pool;
+	for (unsigned i = 1; i < std::max(1u, threads) && (int)i < nx * ny; i++)
+		pool.push_back(std::thread(work));
+	work();
+	for (auto& th : pool)
+		th.join();
+	prims.clear();
+}
+
+inline bool raster_canvas::write_ppm(const std::string& file) const
+{
+	std::ofstream out(file.c_str(), std::ios::binary);
+	out << "P6\n" << w << " " << h << "\n255\n";
+	out.write((const char*)&rgb[0], rgb.size());
+	return out.good();
+}
+
+// CRC-32 of the PNG chunks
+inline unsigned long raster_crc(const unsigned char* p, size_t n, unsigned long crc = 0)
+{
+	static unsigned long table[256];
+	static bool init = false;
+	if (!init)
+	{
+		for (unsigned long i = 0; i < 256; i++)
+		{
+			unsigned long c = i;
+			for (int k = 0; k < 8; k++)
+				c = (c & 1) ? 0xEDB88320UL ^ (c >> 1) : c >> 1;
+			table[i] = c;
+		}
+		init = true;
+	}
+	crc ^= 0xFFFFFFFFUL;
+	for (size_t i = 0; i < n; i++)
+		crc = table[(crc ^ p[i]) & 0xFF] ^ (crc >> 8);
+	return crc ^ 0xFFFFFFFFUL;
+}
+
+inline bool raster_canvas::write_png(const std::string& file) const
+{
+	// rows with filter byte 0
+	std::vector<unsigned char> raw;
+	raw.reserve((3 * (size_t)w + 1) * h);
+	for (int y = 0; y < h; y++)
+	{
+		raw.push_back(0);
+		raw.insert(raw.end(), rgb.begin() + 3 * (size_t)y * w, rgb.begin() + 3 * (size_t)(y + 1) * w);
+	}
+
+	std::vector<unsigned char> z;
+#ifdef HAVE_ZLIB
+	uLongf zlen = compressBound(raw.size());
+	z.resize(zlen);
+	if (compress2(&z[0], &zlen, &raw[0], raw.size(), Z_BEST_SPEED) != Z_OK)
+		return false;
+	z.resize(zlen);
+#else
+	// zlib stream of stored (uncompressed) deflate blocks
+	z.push_back(0x78);
+	z.push_back(0x01);
+	for (size_t pos = 0; pos < raw.size() || pos == 0; )
+	{
+		size_t len = std::min<size_t>(65535, raw.size() - pos);
+		z.push_back(pos + len == raw.size() ? 1 : 0);
+		z.push_back(len & 0xFF);
+		z.push_back(len >> 8);
+		z.push_back(~len & 0xFF);
+		z.push_back((~len >> 8) & 0xFF);
+		z.insert(z.end(), raw.begin() + pos, raw.begin() + pos + len);
+		pos += len;
+		if (len == 0)
+			break;
+	}
+	unsigned long a = 1, b = 0;
+	for (unsigned char c : raw)
+	{
+		a = (a + c) % 65521;
+		b = (b + a) % 65521;
+	}
+	unsigned long adler = (b << 16) | a;
+	for (int k = 3; k >= 0; k--)
+		z.push_back((adler >> (8 * k)) & 0xFF);
+#endif
+
+	std::ofstream out(file.c_str(), std::ios::binary);
+	auto u32 = [](std::vector<unsigned char>& v, unsigned long x)
+	{
+		for (int k = 3; k >= 0; k--)
+			v.push_back((x >> (8 * k)) & 0xFF);
+	};
+	auto chunk = [&](const char* type, const std::vector<unsigned char>& data)
+	{
+		std::vector<unsigned char> c;
+		u32(c, data.size());
+		c.insert(c.end(), type, type + 4);
+		c.insert(c.end(), data.begin(), data.end());
+		u32(c, raster_crc(&c[4], c.size() - 4));
+		out.write((const char*)&c[0], c.size());
+	};
+	const unsigned char sig[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+	out.write((const char*)sig, 8);
+	std::vector<unsigned char> ihdr;
+	u32(ihdr, w);
+	u32(ihdr, h);
+	ihdr.push_back(8);		// bit depth
+	ihdr.push_back(2);		// RGB
+	ihdr.push_back(0);
+	ihdr.push_back(0);
+	ihdr.push_back(0);
+	chunk("IHDR", ihdr);
+	chunk("IDAT", z);
+	chunk("IEND", std::vector<unsigned char>());
+	return out.good();
+}
+
+//------------------------------------------------------------------------
+// Grotrian diagrams: one panel per layout (or per zoom window), side by
+// side, same columns as the WRPLOT output; drawn on any canvas with
+// width(), height(), line() and text() like raster_canvas (y downwards)
+//------------------------------------------------------------------------
+struct raster_grotrian_panel
+{
+	const grotrian_layout* lay;
+	std::string title;
+	double emin;
+	double emax;
+};
+
+// panels as written by write_grotrian/write_grotrian_series: the whole
+// diagram (on the highest ionization limit if shared) or the zoom windows
+inline std::vector<raster_grotrian_panel> raster_grotrian_panels(const std::vector<const grotrian_layout*>& lays, const std::vector<std::string>& titles,
+	const grotrian_options& opt, bool shared)
+{
+	double top = 0.0;
+	for (const auto* lay : lays)
+		top = std::max(top, lay->ionlimit);
+	std::vector<raster_grotrian_panel> panels;
+	for (size_t i = 0; i < lays.size(); i++)
+	{
+		if (!opt.zoom.empty())
+		{
+			for (const auto& z : opt.zoom)
+				panels.push_back({ lays[i], titles[i], z.first, z.second });
+			continue;
+		}
+		double ion = shared ? top : lays[i]->ionlimit;
+		panels.push_back({ lays[i], titles[i], -ion * 0.02, ion * 1.04 });
+	}
+	return panels;
+}
+
+template<class Canvas>
+inline void draw_grotrian(Canvas& cv, const std::vector<raster_grotrian_panel>& panels, const grotrian_options& opt)
+{
+	const double left = 60, right = 20, top = 80, bottom = 30, gap = 60;
+	const int n = panels.size();
+	const double pw = (cv.width() - left - right - gap * (n - 1)) / std::max(1, n);
+	std::stringstream ss;
+	ss << std::fixed;
+
+	for (int i = 0; i < n; i++)
+	{
+		const grotrian_layout& lay = *panels[i].lay;
+		const double emin = panels[i].emin, emax = panels[i].emax;
+		const double x0 = left + i * (pw + gap), x1 = x0 + pw;
+		const double y0 = top, y1 = cv.height() - bottom;
+		const double unit = lay.unit;
+		auto X = [&](double u) { return x0 + (x1 - x0) * u / 100.0; };
+		auto Y = [&](double e) { return y1 - (y1 - y0) * (e - emin) / (emax - emin); };
+
+		cv.line(x0, y0, x1, y0, raster_black);
+		cv.line(x1, y0, x1, y1, raster_black);
+		cv.line(x1, y1, x0, y1, raster_black);
+		cv.line(x0, y1, x0, y0, raster_black);
+		cv.text((x0 + x1) / 2, 8, "Grotrian diagram of " + panels[i].title, raster_black, 2, 1);
+
+		// energy axis in 1000 cm^-1
+		double step = grotrian_step((emax - emin) / 8);
+		for (double e = ceil(emin / step) * step; e <= emax; e += step)
+		{
+			cv.line(x0 - 5, Y(e), x0, Y(e), raster_black);
+			ss.str("");
+			ss << std::setprecision(step >= 1000 ? 0 : 2) << e / 1000 + 0.0;
+			cv.text(x0 - 8, Y(e) - 3, ss.str(), raster_black, 1, 2);
+		}
+		if (lay.ionlimit >= emin && lay.ionlimit <= emax)
+			cv.line(X(0), Y(lay.ionlimit), X(100), Y(lay.ionlimit), raster_black);
+
+		grotrian_energy_index idx(lay);
+		std::vector<int> lev, lin;
+		idx.select(emin, emax, lev, lin);
+		for (int k : lin)
+		{
+			const grotrian_level_table& lv = lay.levels;
+			int lo = lay.lines[k].low, up = lay.lines[k].up;
+			double xa = unit * (lv.column[lo] + 0.85), ya = lv.energy[lo];
+			double xb = unit * (lv.column[up] + 0.85), yb = lv.energy[up];
+			if (grotrian_clip(xa, ya, xb, yb, emin, emax))
+				cv.line(X(xa), Y(ya), X(xb), Y(yb), raster_grey);
+		}
+		for (int k : lev)
+		{
+			double xlevelpos = unit * (lay.levels.column[k] + 0.5 + 0.5) + opt.offset * unit;
+			double e = lay.levels.energy[k];
+			cv.line(X(xlevelpos - unit * 0.3), Y(e), X(xlevelpos), Y(e), raster_black, opt.level_pen);
+			cv.text(X(xlevelpos + unit * 0.1), Y(e) - 3, lay.levels.conf_of(k), raster_wrplot_color(opt.label_color));
+		}
+
+		// separators, S= and the (l, parity) of the columns above the box
+		ss << std::setprecision(1);
+		for (const auto& grp : lay.groups)
+		{
+			int width = grp.lp.size();
+			double xpos = unit * (0.5 + grp.first + width + 0.5);
+			if (xpos < 100)
+				cv.line(X(xpos), y0, X(xpos), y1, raster_grey);
+			ss.str("");
+			ss << "S=" << (grp.mult - 1.0) * 0.5;
+			cv.text(X(unit * grp.first + unit * width * 0.5 + unit * 0.5), y0 - 30, ss.str(), raster_black, 1, 1);
+			for (size_t j = 0; j < grp.lp.size(); j++)
+			{
+				std::string label = std::to_string(grp.mult) + grotrian_get_L(grp.lp[j].first) + (grp.lp[j].second == 0 ? "" : "o");
+				cv.text(X(unit * (grp.first + j + 0.5 + 0.4)), y0 - 14, label, raster_black, 1, 1);
+			}
+		}
+	}
+}
+
+// renders the panels and writes the image; false if it could not be
+// written
+inline bool write_grotrian_preview(const std::string& file, const std::vector<raster_grotrian_panel>& panels, const grotrian_options& opt,
+	unsigned threads, int w = 1600, int h = 1130)
+{
+	raster_canvas cv(w, h);
+	draw_grotrian(cv, panels, opt);
+	cv.render(threads);
+	return cv.write(file);
+}
+
+//------------------------------------------------------------------------
+// fplot: one stick per ident, f over wavelength
+//------------------------------------------------------------------------
+template<class Canvas>
+inline void draw_fplot(Canvas& cv, const std::vector<fplot_ident>& idents, const std::string& title)
+{
+	const double x0 = 80, x1 = cv.width() - 20, y0 = 50, y1 = cv.height() - 40;
+	cv.text((x0 + x1) / 2, 8, title, raster_black, 2, 1);
+	cv.line(x0, y0, x1, y0, raster_black);
+	cv.line(x1, y0, x1, y1, raster_black);
+	cv.line(x1, y1, x0, y1, raster_black);
+	cv.line(x0, y1, x0, y0, raster_black);
+	if (idents.empty())
+		return;
+
+	double wmin = 9.9e+30, wmax = -9.9e+30, fmax = 0.0;
+	for (const auto& id : idents)
+	{
+		wmin = std::min(wmin, id.wvl);
+		wmax = std::max(wmax, id.wvl);
+		fmax = std::max(fmax, id.f);
+	}
+	double pad = std::max(1.0, (wmax - wmin) * 0.01);
+	wmin -= pad;
+	wmax += pad;
+	fmax = fmax > 0.0 ? fmax * 1.05 : 1.0;
+	auto X = [&](double w) { return x0 + (x1 - x0) * (w - wmin) / (wmax - wmin); };
+	auto Y = [&](double f) { return y1 - (y1 - y0) * f / fmax; };
+
+	std::stringstream ss;
+	double step = grotrian_step((wmax - wmin) / 10);
+	ss << std::fixed << std::setprecision(step >= 1 ? 0 : 2);
+	for (double w = ceil(wmin / step) * step; w <= wmax; w += step)
+	{
+		cv.line(X(w), y1, X(w), y1 + 5, raster_black);
+		ss.str("");
+		ss << w;
+		cv.text(X(w), y1 + 9, ss.str(), raster_black, 1, 1);
+	}
+	step = grotrian_step(fmax / 8);
+	ss << std::setprecision(std::max(0, (int)ceil(-log10(step))));
+	for (double f = 0.0; f <= fmax; f += step)
+	{
+		cv.line(x0 - 5, Y(f), x0, Y(f), raster_black);
+		ss.str("");
+		ss << f;
+		cv.text(x0 - 8, Y(f) - 3, ss.str(), raster_black, 1, 2);
+	}
+	for (const auto& id : idents)
+		cv.line(X(id.wvl), Y(0.0), X(id.wvl), Y(id.f), raster_black);
+}
+
+inline bool write_fplot_preview(const std::string& file, const std::vector<fplot_ident>& idents, const std::string& title,
+	unsigned threads, int w = 1600, int h = 900)
+{
+	raster_canvas cv(w, h);
+	draw_fplot(cv, idents, title);
+	cv.render(threads);
+	return cv.write(file);
+}
+
+#endif
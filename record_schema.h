@@ -0,0 +1,197 @@
+//========================================================================
+// Name        : record_schema.h
+// Author      : Michael Knoerzer
+// Version     : 1.0 (2026-10-18)
+// Copyright   : Copyright (c) 2026
+// Description : Fixed-width records of the TOSS level files and TMAD
+//             : model atoms as compile-time schemas: a column is a type
+//             : with first character, width and format, the readers take
+//             : it straight from the line and the writers format whole
+//             : records from the same definition
+//             : C++11 !
+//========================================================================
+#ifndef RECORD_SCHEMA_H
+#define RECORD_SCHEMA_H
+
+#include <string>
+#include <cstdio>
+#include <cstddef>
+#include <algorithm>
+#include "parse_arena.h"
+
+// text: blank padded and cut to the width; numbers: right aligned, at
+// least width characters (as setw)
+enum record_format { rec_text, rec_int, rec_fixed, rec_sci };
+
+template<record_format F>
+struct record_put;
+
+template<>
+struct record_put<rec_text>
+{
+	static void put(std::string& out, size_t width, int, bool last, const text_view& v)
+	{
+		size_t n = width ? std::min(v.size(), width) : v.size();
+		out.append(v.p, n);
+		// the last column of a record is not padded
+		if (!last && n < width)
+			out.append(width - n, ' ');
+	}
+};
+
+template<>
+struct record_put<rec_int>
+{
+	static void put(std::string& out, size_t width, int, bool, long long v)
+	{
+		char buf[32];
+		int n = snprintf(buf, sizeof(buf), "%*lld", (int)width, v);
+		out.append(buf, std::min(std::max(n, 0), (int)sizeof(buf) - 1));
+	}
+};
+
+template<>
+struct record_put<rec_fixed>
+{
+	static void put(std::string& out, size_t width, int prec, bool, double v)
+	{
+		char buf[512];
+		int n = snprintf(buf, sizeof(buf), "%*.*f", (int)width, prec, v);
+		out.append(buf, std::min(std::max(n, 0), (int)sizeof(buf) - 1));
+	}
+};
+
+template<>
+struct record_put<rec_sci>
+{
+	static void put(std::string& out, size_t width, int prec, bool, double v)
+	{
+		char buf[64];
+		int n = snprintf(buf, sizeof(buf), "%*.*e", (int)width, prec, v);
+		out.append(buf, std::min(std::max(n, 0), (int)sizeof(buf) - 1));
+	}
+};
+
+//------------------------------------------------------------------------
+// one column: characters Pos .. Pos+Width-1, Width 0 is the rest of the
+// line (reading) or as wide as needed (writing)
+//------------------------------------------------------------------------
+template<size_t Pos, size_t Width, record_format Format = rec_text, int Prec = 0>
+struct record_column
+{
+	static constexpr size_t pos = Pos;
+	static constexpr size_t width = Width;
+	static constexpr size_t end = Width ? Pos + Width : std::string::npos;
+
+	// the column of a line; short lines give a short or empty text
+	static text_view get(const text_view& line)
+	{
+		return line.sub(Pos, Width ? Width : std::string::npos);
+	}
+
+	// the line from this column on (free format numbers), for a string
+	// it ends with a 0 character
+	static text_view rest(const text_view& line)
+	{
+		return line.sub(Pos);
+	}
+
+	// the value at its column, out is padded to it; last: no blanks after
+	// a text
+	template<class T>
+	static void put(std::string& out, const T& v, bool last = false)
+	{
+		if (out.size() < Pos)
+			out.append(Pos - out.size(), ' ');
+		record_put<Format>::put(out, Width, Prec, last, v);
+	}
+};
+
+template<size_t Pos, size_t Width, record_format Format, int Prec>
+constexpr size_t record_column<Pos, Width, Format, Prec>::pos;
+template<size_t Pos, size_t Width, record_format Format, int Prec>
+constexpr size_t record_column<Pos, Width, Format, Prec>::width;
+template<size_t Pos, size_t Width, record_format Format, int Prec>
+constexpr size_t record_column<Pos, Width, Format, Prec>::end;
+
+//------------------------------------------------------------------------
+// a record to write: its columns in order, checked at compile time not to
+// overlap; format() takes one value per column
+//------------------------------------------------------------------------
+template<class... C>
+struct record_schema;
+
+template<>
+struct record_schema<>
+{
+	static constexpr size_t pos = std::string::npos;
+	static void put(std::string&) {}
+};
+
+template<class C, class... R>
+struct record_schema<C, R...>
+{
+	static_assert(C::end <= record_schema<R...>::pos, "columns of a record overlap or are out of order");
+	static constexpr size_t pos = C::pos;
+
+	template<class V, class... Vs>
+	static void put(std::string& out, const V& v, const Vs&... vs)
+	{
+		static_assert(sizeof...(Vs) == sizeof...(R), "one value per column");
+		C::put(out, v, sizeof...(R) == 0);
+		record_schema<R...>::put(out, vs...);
+	}
+
+	template<class... Vs>
+	static std::string format(const Vs&... vs)
+	{
+		std::string out;
+		put(out, vs...);
+		return out;
+	}
+};
+
+//------------------------------------------------------------------------
+// TOSS level file: energy (free format), then the A10 name
+// "SIA3S 01S", "SIA3P 13PO": code, last subshell, J (integer part),
+// term, parity (O if odd)
+// the columns are counted from the first character of the name
+//------------------------------------------------------------------------
+struct toss_level_record
+{
+	typedef record_column<0, 3> code;
+	typedef record_column<3, 3> conf;
+	typedef record_column<6, 1> j;
+	typedef record_column<7, 2> term;
+	typedef record_column<9, 1> parity;
+	typedef record_schema<code, conf, j, term, parity> name;
+};
+
+//------------------------------------------------------------------------
+// TMAD model atom, levels (L, LTE) and bound-bound lines (RBB); the
+// numbers are read in free format from their first column on
+// "SIA3S3P3PO          4.041105e+15    9.0"
+// "SIA3S2 1S SIA3S3P3PO    3    3 9.4527e-01"
+//------------------------------------------------------------------------
+struct tmad_level_record
+{
+	typedef record_column<0, 10> name;
+	typedef record_column<0, 7> code_conf;		// element code, then configuration
+	typedef record_column<7, 3> term;			// term, parity O if odd
+	typedef record_column<20, 14, rec_sci, 6> frequency;	// Hz below the ionization limit
+	typedef record_column<35, 6, rec_fixed, 1> weight;		// statistical weight g
+	typedef record_schema<code_conf, term> name_columns;
+	typedef record_schema<name, frequency, weight> line;
+};
+
+struct tmad_rbb_record
+{
+	typedef record_column<0, 10> low;
+	typedef record_column<10, 10> up;
+	typedef record_column<20, 5, rec_int> form;		// 3 3: oscillator strength f_ik follows
+	typedef record_column<25, 5, rec_int> form2;
+	typedef record_column<31, 0, rec_sci, 4> f;
+	typedef record_schema<low, up, form, form2, f> line;
+};
+
+#endif
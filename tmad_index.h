@@ -0,0 +1,312 @@
+//========================================================================
+// Name        : tmad_index.h
+// Author      : Michael Knoerzer
+// Version     : 1.0 (2026-10-18)
+// Copyright   : Copyright (c) 2026
+// Description : Section index for TMAD files (ATOM, L, LTE, RBB, RBF,
+//             : ...) with byte offsets, stored in a sidecar file
+//             : <file>.idx so later runs can seek to the sections needed;
+//             : the headers at the stored offsets are checked before use
+//             : C++11 !
+//========================================================================
+#ifndef TMAD_INDEX_H
+#define TMAD_INDEX_H
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <istream>
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
+#include <sys/stat.h>
+
+// one section: header line up to and including the terminating "0"
+struct tmad_section
+{
+	std::string name;
+	long long offset;	// start of the header line
+	long long end;		// first byte after the section
+	long lines;			// number of lines including header and terminator
+};
+
+struct tmad_index
+{
+	long long size = -1;
+	long long mtime = -1;
+	std::vector<tmad_section> sections;	// in file order
+
+	// all sections with one of the given names, in file order
+	std::vector<tmad_section> select(const std::vector<std::string>& names) const
+	{
+		std::vector<tmad_section> res;
+		for (const auto& s : sections)
+		{
+			if (std::find(names.begin(), names.end(), s.name) != names.end())
+				res.push_back(s);
+		}
+		return res;
+	}
+};
+
+// size and modification time (ns) of a file, false if it does not exist
+inline bool tmad_file_stamp(const std::string& file, long long& size, long long& mtime)
+{
+	struct stat st;
+	if (stat(file.c_str(), &st) != 0)
+		return false;
+	size = st.st_size;
+#ifdef __linux__
+	mtime = st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec;
+#else
+	mtime = st.st_mtime * 1000000000LL;
+#endif
+	return true;
+}
+
+// section headers are lines of capital letters only (ATOM, L, LTE, RBB, ...)
+inline bool tmad_is_header(const std::string& s)
+{
+	if (s.empty() || s.size() > 8)
+		return false;
+	for (char c : s)
+	{
+		if (c < 'A' || c > 'Z')
+			return false;
+	}
+	return true;
+}
+
+// a line (without the newline) is the header of the section
+inline bool tmad_header_is(std::string line, const tmad_section& s)
+{
+	while (!line.empty() && (line.back() == '\r' || line.back() == ' '))
+		line.pop_back();
+	return line == s.name;
+}
+
+// the index fits the file in memory: every section starts at the
+// beginning of a line with its header and ends within the file; a file
+// changed within the resolution of the time stamp does not
+inline bool tmad_index_fits(const std::string& buf, const tmad_index& idx)
+{
+	for (const auto& s : idx.sections)
+	{
+		if (s.offset < 0 || s.offset >= (long long)buf.size() || s.end > (long long)buf.size() || (s.offset > 0 && buf[s.offset - 1] != '\n'))
+			return false;
+		size_t nl = buf.find('\n', s.offset);
+		if (!tmad_header_is(buf.substr(s.offset, nl == std::string::npos ? std::string::npos : nl - s.offset), s))
+			return false;
+	}
+	return true;
+}
+
+// the same for a section of a file read by seeking; the position of in
+// is changed
+inline bool tmad_header_at(std::istream& in, const tmad_section& s)
+{
+	in.clear();
+	if (s.offset > 0)
+	{
+		in.seekg(s.offset - 1);
+		if (in.get() != '\n')
+			return false;
+	}
+	else
+		in.seekg(0);
+	std::string line;
+	return std::getline(in, line) && tmad_header_is(line, s);
+}
+
+//------------------------------------------------------------------------
+// first pass: scan the data block wise, only the start of every line is
+// looked at, no line is copied or parsed; read(buf, n) delivers the next
+// block and returns its size, 0 at the end
+//------------------------------------------------------------------------
+template<class Read>
+inline void scan_tmad_index(Read read, tmad_index& idx)
+{
+	idx.sections.clear();
+	const size_t head_max = 12;
+	std::vector<char> buf(1 << 20);
+	std::string head;			// first characters of the current line
+	long long pos = 0;			// file offset of buf[0]
+	long long line_start = 0;
+	long long line_len = 0;
+	int open = -1;				// index of the open section
+
+	auto close = [&](long long end)
+	{
+		idx.sections[open].end = end;
+		open = -1;
+	};
+
+	auto process = [&](long long start, long long len)
+	{
+		std::string s = head;
+		while (!s.empty() && (s.back() == '\r' || s.back() == ' '))
+			s.pop_back();
+		bool full = len <= (long long)head_max;
+		bool comment = !s.empty() && s[0] == '.';
+		bool header = full && tmad_is_header(s);
+		long long next = start + len + 1;
+
+		if (open >= 0)
+		{
+			// ATOM has exactly one line of data and no terminator
+			bool atom = idx.sections[open].name == "ATOM";
+			if (header && !atom)
+			{
+				// a new section without terminator of the last one
+				close(start);
+			}
+			else
+			{
+				idx.sections[open].lines++;
+				if (!comment && (atom || (full && s == "0")))
+					close(next);
+				return;
+			}
+		}
+		if (header)
+		{
+			idx.sections.push_back({ s, start, -1, 1 });
+			open = idx.sections.size() - 1;
+		}
+	};
+
+	size_t n;
+	while ((n = read(&buf[0], buf.size())) > 0)
+	{
+		const char* p = &buf[0];
+		const char* end = p + n;
+		while (p < end)
+		{
+			const char* nl = (const char*)memchr(p, '\n', end - p);
+			const char* seg_end = nl ? nl : end;
+			if (head.size() < head_max)
+				head.append(p, std::min((size_t)(seg_end - p), head_max - head.size()));
+			line_len += seg_end - p;
+			if (!nl)
+				break;
+			process(line_start, line_len);
+			line_start = pos + (nl - &buf[0]) + 1;
+			line_len = 0;
+			head.clear();
+			p = nl + 1;
+		}
+		pos += n;
+	}
+	if (line_len > 0)
+		process(line_start, line_len);
+	if (open >= 0)
+		close(pos);
+}
+
+inline bool build_tmad_index(const std::string& file, tmad_index& idx)
+{
+	FILE* f = fopen(file.c_str(), "rb");
+	if (!f)
+		return false;
+	tmad_file_stamp(file, idx.size, idx.mtime);
+	scan_tmad_index([&](char* buf, size_t n) { return fread(buf, 1, n, f); }, idx);
+	fclose(f);
+	return true;
+}
+
+inline std::string tmad_index_file(const std::string& file)
+{
+	return file + ".idx";
+}
+
+// sidecar file, only valid if size and modification time (ns) still
+// match; version 1 had the time in seconds and is built again
+inline bool read_tmad_index(const std::string& file, tmad_index& idx)
+{
+	std::ifstream in(tmad_index_file(file).c_str());
+	if (!in.is_open())
+		return false;
+	std::string magic;
+	int version;
+	long long size, mtime, cur_size, cur_mtime;
+	if (!(in >> magic >> version >> size >> mtime) || magic != "TMAD-INDEX" || version != 2)
+		return false;
+	if (!tmad_file_stamp(file, cur_size, cur_mtime) || size != cur_size || mtime != cur_mtime)
+		return false;
+	idx.size = size;
+	idx.mtime = mtime;
+	idx.sections.clear();
+	tmad_section s;
+	while (in >> s.name >> s.offset >> s.end >> s.lines)
+		idx.sections.push_back(s);
+	return true;
+}
+
+inline bool write_tmad_index(const std::string& file, const tmad_index& idx)
+{
+	std::ofstream out(tmad_index_file(file).c_str());
+	if (!out.is_open())
+		return false;
+	out << "TMAD-INDEX 2 " << idx.size << " " << idx.mtime << "\n";
+	for (const auto& s : idx.sections)
+		out << s.name << " " << s.offset << " " << s.end << " " << s.lines << "\n";
+	return out.good();
+}
+
+// index from the sidecar file, or scan the file and write the sidecar
+inline bool get_tmad_index(const std::string& file, tmad_index& idx)
+{
+	if (read_tmad_index(file, idx))
+		return true;
+	if (!build_tmad_index(file, idx))
+		return false;
+	// not fatal, i.e. read only directory
+	write_tmad_index(file, idx);
+	return true;
+}
+
+//------------------------------------------------------------------------
+// getline over selected sections only, seeks from one to the next; if a
+// section does not start with its header the index is stale and the
+// whole file is read instead
+//------------------------------------------------------------------------
+struct tmad_section_reader
+{
+	std::istream& in;
+	std::vector<tmad_section> sections;
+	size_t current = 0;
+	long remaining = 0;
+	bool stale = false;
+
+	tmad_section_reader(std::istream& _in, const std::vector<tmad_section>& _sections): in(_in), sections(_sections)
+	{
+		for (const auto& s : sections)
+		{
+			if (!s.name.empty() && !tmad_header_at(in, s))
+			{
+				stale = true;
+				break;
+			}
+		}
+		if (stale)
+			sections.assign(1, { "", 0, -1, -1 });
+	}
+
+	bool getline(std::string& line)
+	{
+		while (remaining == 0)
+		{
+			if (current >= sections.size())
+				return false;
+			in.clear();
+			in.seekg(sections[current].offset);
+			remaining = sections[current].lines;
+			current++;
+		}
+		remaining--;
+		return (bool)std::getline(in, line);
+	}
+};
+
+#endif
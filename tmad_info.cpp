@@ -0,0 +1,115 @@
+//========================================================================
+// Name        : tmad_info.cpp
+// Author      : Michael Knoerzer
+// Version     : 1.0 (2026-10-18)
+// Copyright   : Copyright (c) 2026
+// Description : Overview of a TMAD model atom: sections, levels,
+//             : transitions with unknown levels, dump of single sections
+//             : compile with -pthread
+//             : C++11 !
+//========================================================================
+
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+#include "tmad_reader.h"
+using namespace std;
+
+int main(int argc, char* argv[])
+{
+	if (argc < 2)
+	{
+		cout << "\nUsage: tmad_info <TMAD file> <options>\n";
+		cout << "\nOptions: show=<section>, threads=<number>\n";
+		cout << "show:    print all records of a section (L, RBB, RBF, CBB, ...)\n";
+		cout << "threads: number of threads (default: all cores)" << endl;
+		return 0;
+	}
+
+	// default values
+	string show;
+	unsigned nthreads = 0;
+
+	for (int i = 2; i < argc; i++)
+	{
+		string s(argv[i]);
+		if (s.substr(0, 5) == "show=")
+		{
+			show = s.substr(5);
+		}
+		else if (s.substr(0, 8) == "threads=")
+		{
+			stringstream ss(s.substr(8));
+			ss >> nthreads;
+		}
+	}
+
+	tmad_atom atom;
+	auto t0 = chrono::steady_clock::now();
+	if (!read_tmad_atom(argv[1], atom, nthreads))
+	{
+		cout << "** ERROR: couldn't read file: " << argv[1] << endl;
+		return -1;
+	}
+	double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+
+	if (show.empty())
+	{
+		size_t lte = 0;
+		for (auto l : atom.levels.lte)
+			lte += l;
+		cout << "** atom: " << atom.element << " " << atom.charge << endl;
+		cout << "** levels: " << atom.levels.size() << " (LTE: " << lte << ")" << endl;
+		for (const auto& s : atom.sections)
+		{
+			// references to levels not defined in this atom
+			size_t unknown_low = 0, unknown_up = 0;
+			for (size_t i = 0; i < s.size(); i++)
+			{
+				unknown_low += s.low[i] < 0;
+				unknown_up += s.up[i] < 0;
+			}
+			cout << "** " << left << setw(8) << s.section << right << setw(10) << s.size() << " records, "
+				<< setw(10) << s.params.size() << " numbers, unknown levels: " << unknown_low << "/" << unknown_up << endl;
+		}
+		cout << "** read in " << fixed << setprecision(1) << ms << " ms" << endl;
+		return 0;
+	}
+
+	if (show == "L" || show == "LTE")
+	{
+		const tmad_level_table& l = atom.levels;
+		for (size_t i = 0; i < l.size(); i++)
+		{
+			cout << setw(6) << i << "  " << l.name(i) << " " << scientific << setprecision(6) << setw(14) << l.frequency[i]
+				<< " " << fixed << setprecision(1) << setw(6) << l.g[i] << (l.lte[i] ? "  LTE" : "") << endl;
+		}
+		return 0;
+	}
+
+	bool found = false;
+	for (const auto& s : atom.sections)
+	{
+		if (s.section != show)
+			continue;
+		found = true;
+		for (size_t i = 0; i < s.size(); i++)
+		{
+			cout << setw(6) << s.low[i] << setw(6) << s.up[i] << "  " << s.name_low(i) << s.name_up(i);
+			const double* p = s.param(i);
+			for (uint32_t k = 0; k < s.nparams(i); k++)
+				cout << " " << scientific << setprecision(4) << p[k];
+			cout << endl;
+		}
+	}
+	if (!found)
+	{
+		cout << "** section not found: " << show << endl;
+		return -1;
+	}
+
+	return 0;
+}
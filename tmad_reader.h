@@ -0,0 +1,396 @@
+//========================================================================
+// Name        : tmad_reader.h
+// Author      : Michael Knoerzer
+// Version     : 1.0 (2026-10-18)
+// Copyright   : Copyright (c) 2026
+// Description : Reads all sections of a TMAD model atom (levels, RBB,
+//             : RBF + cross-sections, collisions, ...) into compact
+//             : column storage, sections are parsed in parallel
+//             : gzip/zstd files are unpacked into memory first
+//             : C++11 !
+//========================================================================
+#ifndef TMAD_READER_H
+#define TMAD_READER_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+#include <iterator>
+#include "tmad_index.h"
+#include "compressed_stream.h"
+#include "record_schema.h"
+
+// width of a level name (record_schema.h)
+const size_t tmad_name_width = tmad_level_record::name::width;
+
+// levels of the L and LTE sections
+struct tmad_level_table
+{
+	std::vector<char> names;			// 10 characters per level
+	std::vector<double> frequency;		// ionization frequency in Hz
+	std::vector<double> g;				// statistical weight
+	std::vector<uint8_t> lte;			// 1 if from the LTE section
+	std::vector<uint32_t> param_offset;	// further numbers of level i: param_offset[i] .. param_offset[i+1]-1
+	std::vector<double> params;
+
+	tmad_level_table(): param_offset(1, 0) {}
+	size_t size() const { return g.size(); }
+	std::string name(size_t i) const { return std::string(&names[tmad_name_width * i], tmad_name_width); }
+};
+
+// records of any other section (RBB, RBF, CBB, CBF, ...): two level names
+// in the first 20 columns and numbers behind, continuation lines (i.e.
+// tabulated cross-sections) are added to the numbers of the last record
+struct tmad_record_table
+{
+	std::string section;
+	std::vector<char> names;			// 2 x 10 characters per record
+	std::vector<int32_t> low;			// level index of the 1st name, -1 if not in this atom
+	std::vector<int32_t> up;			// level index of the 2nd name
+	std::vector<uint32_t> param_offset;	// numbers of record i: param_offset[i] .. param_offset[i+1]-1
+	std::vector<double> params;
+
+	tmad_record_table(): param_offset(1, 0) {}
+	size_t size() const { return low.size(); }
+	std::string name_low(size_t i) const { return std::string(&names[2 * tmad_name_width * i], tmad_name_width); }
+	std::string name_up(size_t i) const { return std::string(&names[2 * tmad_name_width * i + tmad_name_width], tmad_name_width); }
+	uint32_t nparams(size_t i) const { return param_offset[i + 1] - param_offset[i]; }
+	const double* param(size_t i) const { return params.data() + param_offset[i]; }
+};
+
+struct tmad_atom
+{
+	std::string element;
+	int charge = 0;
+	tmad_level_table levels;
+	std::vector<tmad_record_table> sections;	// in file order
+
+	// first section with that name, nullptr if there is none
+	const tmad_record_table* find(const std::string& name) const
+	{
+		for (const auto& s : sections)
+		{
+			if (s.section == name)
+				return &s;
+		}
+		return nullptr;
+	}
+};
+
+//------------------------------------------------------------------------
+// helpers for parsing from the file buffer
+//------------------------------------------------------------------------
+
+// all numbers in [p, end), Fortran exponents (1.0D-05) are accepted
+inline void tmad_parse_numbers(const char* p, const char* end, std::vector<double>& out)
+{
+	char tmp[64];
+	while (p < end)
+	{
+		while (p < end && (*p == ' ' || *p == '\t' || *p == '\r'))
+			p++;
+		if (p >= end)
+			break;
+		const char* tok = p;
+		while (p < end && *p != ' ' && *p != '\t' && *p != '\r')
+			p++;
+		size_t len = std::min((size_t)(p - tok), sizeof(tmp) - 1);
+		memcpy(tmp, tok, len);
+		tmp[len] = 0;
+		for (size_t i = 0; i < len; i++)
+		{
+			if (tmp[i] == 'D' || tmp[i] == 'd')
+				tmp[i] = 'E';
+		}
+		char* stop;
+		double d = strtod(tmp, &stop);
+		// skip words like formula names
+		if (stop != tmp)
+			out.push_back(d);
+	}
+}
+
+// level name from column c, blank padded
+inline void tmad_copy_name(const char* line, size_t len, size_t c, std::vector<char>& out)
+{
+	for (size_t i = c; i < c + tmad_name_width; i++)
+		out.push_back((i < len && line[i] != '\r') ? line[i] : ' ');
+}
+
+// a record starts with a level name, everything else continues the last one
+inline bool tmad_is_record(const char* line, size_t len)
+{
+	return len > 0 && ((line[0] >= 'A' && line[0] <= 'Z') || (line[0] >= 'a' && line[0] <= 'z'));
+}
+
+// piece of a section that is parsed by one thread
+struct tmad_chunk
+{
+	size_t section;		// index into the list of sections
+	size_t begin, end;	// byte range in the buffer
+};
+
+// split [begin, end) into chunks of about chunk_size bytes, chunks start
+// at records so continuation lines stay with their record
+inline void tmad_make_chunks(const std::string& buf, size_t section, size_t begin, size_t end, size_t chunk_size, std::vector<tmad_chunk>& chunks)
+{
+	while (begin < end)
+	{
+		size_t stop = std::min(end, begin + chunk_size);
+		while (stop < end)
+		{
+			// next line start
+			const void* nl = memchr(buf.data() + stop, '\n', end - stop);
+			if (!nl)
+			{
+				stop = end;
+				break;
+			}
+			stop = (const char*)nl - buf.data() + 1;
+			if (stop < end && tmad_is_record(buf.data() + stop, end - stop))
+				break;
+		}
+		chunks.push_back({ section, begin, stop });
+		begin = stop;
+	}
+}
+
+// call f(line, len) for every line in [begin, end) but comments and the "0"
+template<class F>
+inline void tmad_for_lines(const std::string& buf, size_t begin, size_t end, F f)
+{
+	const char* p = buf.data() + begin;
+	const char* e = buf.data() + end;
+	while (p < e)
+	{
+		const char* nl = (const char*)memchr(p, '\n', e - p);
+		const char* le = nl ? nl : e;
+		size_t len = le - p;
+		if (len > 0 && p[len - 1] == '\r')
+			len--;
+		if (!(len > 0 && p[0] == '.') && !(len == 1 && p[0] == '0'))
+			f(p, len);
+		p = le + 1;
+	}
+}
+
+// run job(i) for i = 0 .. n-1 on a number of threads
+template<class F>
+inline void tmad_parallel(size_t n, unsigned threads, F job)
+{
+	std::atomic<size_t> next(0);
+	auto worker = [&]()
+	{
+		size_t i;
+		while ((i = next++) < n)
+			job(i);
+	};
+	std::vector<std::thread> pool;
+	for (unsigned t = 1; t < threads && t < n; t++)
+		pool.push_back(std::thread(worker));
+	worker();
+	for (auto& t : pool)
+		t.join();
+}
+
+//------------------------------------------------------------------------
+// read the complete model atom
+//------------------------------------------------------------------------
+inline bool read_tmad_atom(const std::string& file, tmad_atom& atom, unsigned threads = 0, size_t chunk_size = 4 << 20)
+{
+	if (threads == 0)
+		threads = std::max(1u, std::thread::hardware_concurrency());
+
+	// whole file in memory and section boundaries, compressed files are
+	// unpacked first and indexed in memory
+	std::string buf;
+	tmad_index idx;
+	bool indexed = false;
+	if (file_compression(file) != COMPRESSION_NONE)
+	{
+		cifstream in(file);
+		if (!in.is_open())
+			return false;
+		buf.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+	}
+	else
+	{
+		indexed = true;
+		if (!get_tmad_index(file, idx))
+			return false;
+		FILE* f = fopen(file.c_str(), "rb");
+		if (!f)
+			return false;
+		fseek(f, 0, SEEK_END);
+		long size = ftell(f);
+		fseek(f, 0, SEEK_SET);
+		buf.resize(size > 0 ? size : 0);
+		size_t got = size > 0 ? fread(&buf[0], 1, size, f) : 0;
+		fclose(f);
+		if ((long)got != size)
+			return false;
+	}
+	// compressed files, or a stale index (file changed within the
+	// resolution of the time stamp): sections from the data in memory
+	if (!indexed || !tmad_index_fits(buf, idx))
+	{
+		size_t pos = 0;
+		scan_tmad_index([&](char* b, size_t n)
+		{
+			n = std::min(n, buf.size() - pos);
+			memcpy(b, buf.data() + pos, n);
+			pos += n;
+			return n;
+		}, idx);
+		if (indexed)
+			write_tmad_index(file, idx);
+	}
+
+	// data of a section starts after the header line
+	auto data_begin = [&](const tmad_section& s) -> size_t
+	{
+		const void* nl = memchr(buf.data() + s.offset, '\n', s.end - s.offset);
+		return nl ? (const char*)nl - buf.data() + 1 : s.end;
+	};
+
+	// ATOM
+	for (const auto& s : idx.sections)
+	{
+		if (s.name != "ATOM")
+			continue;
+		tmad_for_lines(buf, data_begin(s), s.end, [&](const char* line, size_t len)
+		{
+			std::string l(line, len);
+			char el[16] = { 0 };
+			if (sscanf(l.c_str(), "%15s %d", el, &atom.charge) >= 1)
+				atom.element = el;
+		});
+		break;
+	}
+
+	// levels: L and LTE sections, all chunks in parallel, joined in file order
+	std::vector<tmad_section> level_sections = idx.select({ "L", "LTE" });
+	std::vector<tmad_chunk> chunks;
+	for (size_t i = 0; i < level_sections.size(); i++)
+		tmad_make_chunks(buf, i, data_begin(level_sections[i]), level_sections[i].end, chunk_size, chunks);
+
+	std::vector<tmad_level_table> level_parts(chunks.size());
+	tmad_parallel(chunks.size(), threads, [&](size_t c)
+	{
+		tmad_level_table& t = level_parts[c];
+		uint8_t lte = level_sections[chunks[c].section].name == "LTE";
+		std::vector<double> num;
+		tmad_for_lines(buf, chunks[c].begin, chunks[c].end, [&](const char* line, size_t len)
+		{
+			num.clear();
+			if (len > tmad_level_record::frequency::pos)
+				tmad_parse_numbers(line + tmad_level_record::frequency::pos, line + len, num);
+			if (!tmad_is_record(line, len))
+			{
+				// continuation of the last level
+				if (t.size() > 0)
+				{
+					t.params.insert(t.params.end(), num.begin(), num.end());
+					t.param_offset.back() = t.params.size();
+				}
+				return;
+			}
+			tmad_copy_name(line, len, tmad_level_record::name::pos, t.names);
+			t.frequency.push_back(num.size() > 0 ? num[0] : 0.0);
+			t.g.push_back(num.size() > 1 ? num[1] : 0.0);
+			t.lte.push_back(lte);
+			if (num.size() > 2)
+				t.params.insert(t.params.end(), num.begin() + 2, num.end());
+			t.param_offset.push_back(t.params.size());
+		});
+	});
+	tmad_level_table& lev = atom.levels;
+	lev = tmad_level_table();
+	for (const auto& t : level_parts)
+	{
+		lev.names.insert(lev.names.end(), t.names.begin(), t.names.end());
+		lev.frequency.insert(lev.frequency.end(), t.frequency.begin(), t.frequency.end());
+		lev.g.insert(lev.g.end(), t.g.begin(), t.g.end());
+		lev.lte.insert(lev.lte.end(), t.lte.begin(), t.lte.end());
+		uint32_t base = lev.params.size();
+		for (size_t i = 1; i < t.param_offset.size(); i++)
+			lev.param_offset.push_back(base + t.param_offset[i]);
+		lev.params.insert(lev.params.end(), t.params.begin(), t.params.end());
+	}
+
+	// level names -> index, read only from here on
+	std::unordered_map<std::string, int32_t> names;
+	names.reserve(lev.size() * 2);
+	for (size_t i = 0; i < lev.size(); i++)
+		names.emplace(lev.name(i), (int32_t)i);
+
+	// all other sections
+	std::vector<tmad_section> rec_sections;
+	for (const auto& s : idx.sections)
+	{
+		if (s.name != "ATOM" && s.name != "L" && s.name != "LTE")
+			rec_sections.push_back(s);
+	}
+	chunks.clear();
+	for (size_t i = 0; i < rec_sections.size(); i++)
+		tmad_make_chunks(buf, i, data_begin(rec_sections[i]), rec_sections[i].end, chunk_size, chunks);
+
+	std::vector<tmad_record_table> rec_parts(chunks.size());
+	tmad_parallel(chunks.size(), threads, [&](size_t c)
+	{
+		tmad_record_table& t = rec_parts[c];
+		std::vector<double> num;
+		tmad_for_lines(buf, chunks[c].begin, chunks[c].end, [&](const char* line, size_t len)
+		{
+			num.clear();
+			bool record = tmad_is_record(line, len);
+			tmad_parse_numbers(line + (record ? std::min(len, tmad_rbb_record::form::pos) : 0), line + len, num);
+			if (!record)
+			{
+				if (t.size() > 0)
+				{
+					t.params.insert(t.params.end(), num.begin(), num.end());
+					t.param_offset.back() = t.params.size();
+				}
+				return;
+			}
+			size_t n0 = t.names.size();
+			tmad_copy_name(line, len, tmad_rbb_record::low::pos, t.names);
+			tmad_copy_name(line, len, tmad_rbb_record::up::pos, t.names);
+			auto lo = names.find(std::string(&t.names[n0], tmad_name_width));
+			auto hi = names.find(std::string(&t.names[n0 + tmad_name_width], tmad_name_width));
+			t.low.push_back(lo != names.end() ? lo->second : -1);
+			t.up.push_back(hi != names.end() ? hi->second : -1);
+			t.params.insert(t.params.end(), num.begin(), num.end());
+			t.param_offset.push_back(t.params.size());
+		});
+	});
+
+	// join chunks of the same section
+	atom.sections.clear();
+	atom.sections.resize(rec_sections.size());
+	for (size_t i = 0; i < rec_sections.size(); i++)
+		atom.sections[i].section = rec_sections[i].name;
+	for (size_t c = 0; c < chunks.size(); c++)
+	{
+		tmad_record_table& s = atom.sections[chunks[c].section];
+		const tmad_record_table& t = rec_parts[c];
+		s.names.insert(s.names.end(), t.names.begin(), t.names.end());
+		s.low.insert(s.low.end(), t.low.begin(), t.low.end());
+		s.up.insert(s.up.end(), t.up.begin(), t.up.end());
+		uint32_t base = s.params.size();
+		for (size_t i = 1; i < t.param_offset.size(); i++)
+			s.param_offset.push_back(base + t.param_offset[i]);
+		s.params.insert(s.params.end(), t.params.begin(), t.params.end());
+	}
+	return true;
+}
+
+#endif
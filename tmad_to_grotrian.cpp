@@ -14,207 +14,102 @@
 #include <vector>
 #include <algorithm>
 #include <iomanip>
-#include <numeric>
+#include <unordered_map>
+#include <thread>
+#include <memory>
 #include <math.h>
+#include "diagnostics.h"
+#include "tmad_index.h"
+#include "compressed_stream.h"
+#include "grotrian_layout.h"
+#include "grotrian_sweep.h"
+#include "grotrian_series.h"
+#include "raster_preview.h"
+#include "ps_writer.h"
+#include "build_cache.h"
+#include "parse_arena.h"
+#include "record_schema.h"
 using namespace std;
 
-// struct for levels
-struct level
-{
-	int mult;
-	int n;		// config
-	int p;		// config/term, should be the same
-	int l;		// term
-	double energy;
-	double J;
-
-	string name;
-	string conf;
-	string L;
-	string term;
-	string parity;
-
-	// compare to any A10-string (name)
-	bool operator==(const string& n)
-	{
-	   return (name == n);
-	}
-};
-// different sorting
-struct
-{
-	bool operator()(const level& i, const level& j)
-	{
-		if(i.l == j.l)
-			return i.energy < j.energy;
-		return i.l < j.l;
-	}
-}sort_by_L;
-struct
-{
-	bool operator()(const level& i, const level& j)
-	{
-		return i.energy < j.energy;
-	}
-}sort_by_E;
-
-// struct to keep track of top labels
-struct mul_lp
-{
-	int mult;
-	int l;
-	int p; // parity
-
-	// sorty by l, parity
-	bool operator()(const mul_lp& i, const mul_lp& j)
-	{
-		if(i.l == j.l)
-			return i.p < j.p;
-		return i.l < j.l;
-	}
-}sort_by_lp;
-// compare 2 items of same multiplicity
-bool operator==(const mul_lp& lhs, const mul_lp& rhs )
-{
-   return (lhs.l == rhs.l) && (lhs.p == rhs.p);
-}
-
-// collection of levels for one type of multiplicity
-struct levels_mult
-{
-	int mult;
-	vector<mul_lp> multis;
-	vector<level> levels;
-
-	bool operator==(const int& m)
-	{
-	   return (mult == m);
-	}
-	bool operator()(const levels_mult& i, const levels_mult& j)
-	{
-		return i.mult < j.mult;
-	}
-}sort_by_mult;
-
-auto sum_labels = [](int lhs, const levels_mult& rhs)
-{
-	return lhs + rhs.multis.size();
-};
-
-
-// struct for lines
-struct transition
-{
-	level low,up;
-	double wvl;
-	double gf;
-	double gA;
-	string name;
-
-	// sort by wavelength
-	bool operator()(const transition& i, const transition& j)
-	{
-		if(i.wvl == j.wvl)
-			return i.gf < j.gf;
-		return i.wvl < j.wvl;
-	}
-}sort_by_wvl;
-struct
-{
-	bool operator()(const transition& i, const transition& j)
-	{
-		if(i.gf == j.gf)
-			return i.wvl < j.wvl;
-		return i.gf < j.gf;
-	}
-}sort_by_gf;
-
-// functions to convert angular momentum letters to numbers
-// and vice versa
-int det_L(char c);
-string get_L(int l);
-
 // enumerate different states
 enum state {SEARCH_ATOM, READ_ATOM, SEARCH_CONTENT, READ_LEVELS, READ_RBB};
 
-int main(int argc, char* argv[])
+// one TMAD file of a series and what was read; the messages go to log
+// and diag, so ions can be read on threads
+struct tmad_ion
 {
-	if(argc < 2)
-	{
-		cout << endl << "Usage: tmad_to_grotrian <TMAD file> <options>" << endl;
-		cout << endl << "Options: e=<number>, n=<number>, l=<number>, c=<Term><parity>" << endl;
-		cout << "Exclude levels/configurations from the diagram which have" << endl;
-		cout << "energy >= e, principal quantum number >= n, angular momentum qn >= l" << endl;
-		cout << "or which have a certain configuration i.e. 3Po or 4Se" << endl;
-		return 0;
-	}
-
-	// default values
-	double skip_e = 9.9e+30;
-	int skip_n = 26;
-	int skip_l = 23;
-	vector<string> skip_conf;
-	double ionlimit;
-
-	// get all options, start with arg #3
-	for(int i = 3; i<argc; i++)
-	{
-		string s(argv[i]);
-		if (s.substr(0,2) == "e=")
-		{
-			stringstream ss(s.substr(2));
-			ss >> skip_e;
-		}
-		else if (s.substr(0,2) == "n=")
-		{
-			stringstream ss(s.substr(2));
-			ss >> skip_n;
-		}
-		else if (s.substr(0,2) == "l=")
-		{
-			stringstream ss(s.substr(2));
-			ss >> skip_l;
-		}
-		else if (s.substr(0,2) == "c=")
-		{
-			skip_conf.push_back(s.substr(2));
-		}
-	}
+	std::string file;
+	double ionlimit = 0.0;
+	grotrian_level_table levels;
+	std::vector<grotrian_line> lines;
+	diagnostics_log diag;
+	std::string log;
+	grotrian_layout lay;
+};
 
+// reads the levels and lines of one TMAD file, the ionization limit is
+// the energy of the ground state; false if there are no levels
+bool read_tmad_ion(tmad_ion& ion, bool use_index, const grotrian_options& read_opt, std::ostream& log)
+{
 	// buffers for input, in/out stream, line buffer
-	vector<level> vec_levels;
-	vector<transition> vec_lines;
-	ifstream in;
+	grotrian_level_table& vec_levels = ion.levels;
+	vector<grotrian_line>& vec_lines = ion.lines;
+	diagnostics_log& diag = ion.diag;
+	double& ionlimit = ion.ionlimit;
+	cifstream in;
 	string line;
-	// different multiplicities
-	vector<levels_mult> all_multiplets;
+	stringstream ss;
+	// level names -> index in vec_levels, the first one counts; names and
+	// map nodes are kept in the arena of this read
+	parse_arena arena;
+	text_map<int> names((text_map<int>::allocator_type(arena)));
+	vector<double> vec_J;
+	bool ground_read = false;
 
 	state s = SEARCH_ATOM;
 	string atom;
-	int alen;
+	int alen = 3;
 	int charge;
-	int total;
-	double unit;
 	const double c = 2.99792458e10;	// cms/s 3*10^10
 
 	// open file and read line by line
-	cout << "** attempting to open file: " << argv[1] << endl;
-	in.open(argv[1]);
+	log << "** attempting to open file: " << ion.file << endl;
+	in.open(ion.file.c_str());
 	if(in.is_open())
 	{
+		// only read the sections we need, skip i.e. photoionization
+		// cross-sections; without index (or compressed) the whole file
+		// is one section
+		tmad_index idx;
+		vector<tmad_section> sections;
+		if(use_index && !in.compressed() && get_tmad_index(ion.file, idx))
+			sections = idx.select({"ATOM", "L", "LTE", "RBB"});
+		else
+			sections.push_back({"", 0, -1, -1});
+		tmad_section_reader reader(in, sections);
+		if(reader.stale)
+		{
+			log << "** index " << tmad_index_file(ion.file) << " does not fit the file, reading all of it" << endl;
+			if(build_tmad_index(ion.file, idx))
+				write_tmad_index(ion.file, idx);
+		}
+
 		// read in transitions
-		while(getline(in,line))
+		while(reader.getline(line))
 		{
 			// skip comments
-			if(line.substr(0,1) == ".")
+			if(!line.empty() && line[0] == '.')
 				continue;
 
-			stringstream ss(line);
-			transition tr;
-			level le;
+			// columns are read in place (record_schema.h), a stream is
+			// only used if the numbers are not plain
+			grotrian_line tr;
+			grotrian_level le;
+			text_view name, conf, term;
+			string error;
+			const char* rest;
 			double g;
 			double eHz;
-			bool skip = false;
 
 			// read in file according to status s
 			switch(s)
@@ -225,6 +120,8 @@ int main(int argc, char* argv[])
 				break;
 
 			case READ_ATOM:
+				ss.str(line);
+				ss.clear();
 				ss >> atom;
 				ss >> charge;
 				if(atom.size() == 2)
@@ -259,530 +156,422 @@ int main(int argc, char* argv[])
 					s = SEARCH_CONTENT;
 					continue;
 				}
-				le.name = line.substr(0,10);
+				name = tmad_level_record::name::get(line);
 				// first 7 characters are atom + config
 				// 8-10 is the term
-				ss.str(line.substr(alen,7-alen));
-				ss.clear();
-				ss >> le.conf;
+				conf = parse_word(tmad_level_record::code_conf::get(line).sub(alen));
+				le.conf.assign(conf.p, conf.n);
 				std::transform(le.conf.begin(), le.conf.end(), le.conf.begin(), ::tolower);
 
 				// get n from conf
-				ss.str(le.conf.substr(0,2));
-				ss.clear();
-				ss >> le.n;
+				parse_int(text_view(le.conf).sub(0,2), le.n);
 
-				ss.str(line.substr(7,3));
-				ss.clear();
-				ss >> le.term;
+				term = parse_word(tmad_level_record::term::get(line));
 				// get parity and correct term if necessary
-				if(le.term.size() == 2)
+				if(term.size() == 2)
 				{
 					// even, term size is fine already
 					le.p = 0;
-					le.parity = "e";
 				}
-				else if(le.term.size() == 3)
+				else if(term.size() == 3)
 				{
 					// must be odd, remove parity from term string
 					le.p = 1;
-					le.parity = "o";
-					le.term = le.term.substr(0,2);
+					term = term.sub(0,2);
 				}
 				else
 				{
 					// error
-					cout << "** error with level parity:" << endl << "** " << line << endl;
-					continue;
-				}
-				// convert multiplicity to int, convert L to int
-				ss.str(le.term.substr(0,1));
-				ss.clear();
-				ss >> le.mult;
-				if(le.mult < 1 || le.mult > 9)
-				{
-					cout << "** Error with multiplicity:" << endl << line << endl;
+					diag.report("error with level parity", line);
 					continue;
 				}
-				le.L = le.term.substr(1,1);
-				le.l = det_L(le.L.c_str()[0]);
-				if(le.l < 0)
+				// multiplicity and L
+				if(!grotrian_term(term.str(), le, error))
 				{
-					cout << "** Error with total angular momentum L:" << endl << line << endl;
+					diag.report(error, line);
 					continue;
 				}
 
 				// get the remainder of the line
-				ss.str(line.substr(20));
-				ss.clear();
-				ss >> eHz;
+				rest = tmad_level_record::frequency::rest(line).p;
+				if(!(parse_number(rest, eHz) && parse_number(rest, g)))
+				{
+					ss.str(tmad_level_record::frequency::rest(line).str());
+					ss.clear();
+					ss >> eHz;
+					ss >> g;
+				}
 				// check if we have determined the ionization limit yet
-				// ground state level should be the first so determine it from there
-				ss >> g;
-				le.J = (g-1)/2;
-				if(vec_levels.size() == 0)
+				// ground state level should be the first so determine it from
+				// there, also if the filters below skip it
+				if(!ground_read)
 				{
 					ionlimit = eHz / c;
+					ground_read = true;
 				}
 				// convert energy back to cm^-1
 				le.energy = ionlimit - (eHz / c);
 
-				// check if we should skip this e,p, or l
-				if(le.energy >= skip_e || le.n >= skip_n || le.l >= skip_l)
+				// check if we should skip this e, n, l or term
+				if(grotrian_skip(le, read_opt))
 					continue;
 
-				// check if should skip this term
-				ss.str(le.term);
-				ss.clear();
-				ss << le.parity;
-				for(const auto &x:skip_conf)
-				{
-					if(x == ss.str())
-					{
-						skip = true;
-						break;
-					}
-				}
-				if(skip)
-				{
-					continue;
-				}
-
 				// all good -> add to vector
+				le.index = vec_levels.size();
+				if(names.find(name) == names.end())
+					names.emplace(arena.copy(name), le.index);
 				vec_levels.push_back(le);
+				vec_J.push_back((g-1)/2);
 				break;
 
 			case READ_RBB:
+			{
 				if(line == "0")
 				{
 					s = SEARCH_CONTENT;
 					break;
 				}
 				// check if we find both levels
-				auto it = find(vec_levels.begin(),vec_levels.end(),line.substr(0,10));
-				if(it == vec_levels.end())
+				auto it = names.find(tmad_rbb_record::low::get(line));
+				if(it == names.end())
 					continue;
-				else
-					tr.low = *it;
-				it = find(vec_levels.begin(),vec_levels.end(),line.substr(10,10));
-				if(it == vec_levels.end())
+				tr.low = it->second;
+				it = names.find(tmad_rbb_record::up::get(line));
+				if(it == names.end())
 					continue;
-				else
-					tr.up = *it;
-
-				tr.name = line;
-				tr.wvl = pow(10.0,8.0) / (tr.up.energy - tr.low.energy);
-				ss.str(line.substr(20));
-				ss.clear();
+				tr.up = it->second;
 
+				tr.wvl = pow(10.0,8.0) / (vec_levels.energy[tr.up] - vec_levels.energy[tr.low]);
 				// should be like " 3 3 f_ik"
-				ss >> tr.gf;
-				ss >> tr.gf;
-				ss >> tr.gf;
+				double form, form2;
+				rest = tmad_rbb_record::form::rest(line).p;
+				if(!(parse_number(rest, form) && parse_number(rest, form2) && parse_number(rest, tr.gf)))
+				{
+					ss.str(tmad_rbb_record::form::rest(line).str());
+					ss.clear();
+					ss >> tr.gf;
+					ss >> tr.gf;
+					ss >> tr.gf;
+				}
 				// gf = g_low * f_ik
-				tr.gf = (tr.low.J * 2 + 1) * tr.gf;
-				tr.gA = tr.gf / 1.49919E-16 / tr.wvl / tr.wvl;
+				tr.gf = (vec_J[tr.low] * 2 + 1) * tr.gf;
 
 				vec_lines.push_back(tr);
 				break;
 			}
+			}
 			// end switch
 		}
 		// end getline
 
+		in.close();
+
 		// check if we have found any levels
 		if(vec_levels.size() < 1)
 		{
-			cout << "** found no levels **" << endl;
-			return 0;
+			log << "** found no levels **" << endl;
+			return false;
 		}
+	}
+	else
+	{
+		log << "Could not open file: " << ion.file << endl;
+		return false;
+	}
+	return true;
+}
 
-		// determine different terms and sort
-		sort(vec_levels.begin(),vec_levels.end(),sort_by_E);
-		for(const auto &i:vec_levels)
+// key of the layout of one TMAD file: its content and the options the
+// layout depends on
+std::string tmad_layout_key(const tmad_ion& ion, const grotrian_options& style)
+{
+	build_hash h;
+	h.add("tmad_to_grotrian layout " __DATE__ " " __TIME__);
+	h.add_file(ion.file);
+	h.add(grotrian_layout_signature(style));
+	return h.hex();
+}
+
+// reads and lays out one TMAD file, or takes layout and messages from the
+// build cache if file and options are unchanged; false if there are no
+// levels
+bool layout_tmad_ion(tmad_ion& ion, bool use_index, const grotrian_options& style, const build_cache& cache)
+{
+	string key;
+	if(cache.is_open())
+	{
+		key = tmad_layout_key(ion, style);
+		string data;
+		if(cache.get(key, data))
 		{
-			// check if we had this multiplicity before
-			auto it = find (all_multiplets.begin(), all_multiplets.end(), i.mult);
-			if (it == all_multiplets.end())
+			stringstream ss(data);
+			if(read_cache_log(ss, ion.log, ion.diag) && read_grotrian_layout(ss, ion.lay))
 			{
-				// does not exist yet
-				vector<level> v;
-				v.push_back(i);
-				vector<mul_lp> m;
-				all_multiplets.push_back({i.mult,m,v});
-			}
-			else
-			{
-				// add to correct collection
-				it->levels.push_back(i);
+				ion.ionlimit = ion.lay.ionlimit;
+				return true;
 			}
+			ion.diag.events.clear();
 		}
-		sort(all_multiplets.begin(), all_multiplets.end(), sort_by_mult);
-
-		// # of total columns
-		// one for each mlp combination
-		// one for each separator between groups (== all_multis size - 1)
-		// + 1 extra for space at left/right border --> all_multis.size + size of all mlp_vectors
-		total = all_multiplets.size();
-		for(auto &i:all_multiplets)
+	}
+
+	stringstream log;
+	bool ok = read_tmad_ion(ion, use_index, style, log);
+	if(ok)
+		ion.lay = layout_grotrian(ion.levels, ion.lines, ion.ionlimit, style);
+	ion.log = log.str();
+	if(ok && cache.is_open())
+	{
+		stringstream ss;
+		write_cache_log(ss, ion.log, ion.diag);
+		write_grotrian_layout(ss, ion.lay);
+		cache.put(key, ss.str());
+	}
+	return ok;
+}
+
+// several TMAD files, each one read and laid out on its own worker,
+// written as panels of one MULTIPLOT in the order given
+int write_tmad_series(const std::vector<std::string>& files, const grotrian_options& style, bool shared, bool use_index, unsigned nthreads,
+	const std::string& png_file, const std::string& ps_file, const build_cache& cache, diagnostics& diag)
+{
+	vector<tmad_ion> ions(files.size());
+	vector<char> ok(files.size(), 0);
+	grotrian_parallel(ions.size(), nthreads, [&](size_t i)
+	{
+		ions[i].file = files[i];
+		ok[i] = layout_tmad_ion(ions[i], use_index, style, cache);
+	});
+
+	// messages in the order of the files
+	vector<grotrian_layout> lays;
+	for(size_t i = 0; i < ions.size(); i++)
+	{
+		cout << ions[i].log;
+		ions[i].diag.replay(diag);
+		if(!ok[i])
+			return 0;
+		lays.push_back(ions[i].lay);
+	}
+	write_grotrian_series(cout, lays, files, style, shared);
+	vector<const grotrian_layout*> ptrs;
+	for(const auto &lay:lays)
+		ptrs.push_back(&lay);
+	if(!png_file.empty() && !write_grotrian_preview(png_file, raster_grotrian_panels(ptrs, files, style, shared), style, nthreads))
+		cout << "** ERROR: couldn't write preview: " << png_file << endl;
+	if(!ps_file.empty() && !write_grotrian_ps(ps_file, raster_grotrian_panels(ptrs, files, style, shared), style))
+		cout << "** ERROR: couldn't write PostScript: " << ps_file << endl;
+	diag.summary(cout);
+	return 0;
+}
+
+int main(int argc, char* argv[])
+{
+	if(argc < 2)
+	{
+		cout << endl << "Usage: tmad_to_grotrian <TMAD file> <options>" << endl;
+		cout << endl << "Options: e=<number>, n=<number>, l=<number>, c=<Term><parity>, diag=<number>, rej=<file>, idx=<true/false>" << endl;
+		cout << "Exclude levels/configurations from the diagram which have" << endl;
+		cout << "energy >= e, principal quantum number >= n, angular momentum qn >= l" << endl;
+		cout << "or which have a certain configuration i.e. 3Po or 4Se" << endl;
+		cout << "diag is the number of bad levels printed per error, rej writes all of them to a file" << endl;
+		cout << "idx=false reads the whole file instead of using the section index <file>.idx" << endl;
+		cout << "gzip/zstd compressed files are read directly (without index)" << endl;
+		cout << "sweep=<file> writes one diagram per line \"<output file> <options>\" of the file," << endl;
+		cout << "the input is read only once, threads=<number> diagrams are built at the same time" << endl;
+		cout << "zoom=<Emin>:<Emax> draws only this energy window (cm^-1) as a panel of its own," << endl;
+		cout << "several zoom options give one panel per window" << endl;
+		cout << "ion=<TMAD file> adds a further ion (several allowed), all ions are drawn side by side" << endl;
+		cout << "in one MULTIPLOT, shared=true puts them on one energy scale" << endl;
+		cout << "png=<file> also writes a raster preview of the diagram (PNG, or PPM for other names)," << endl;
+		cout << "ps=<file> the same drawing as compact PostScript" << endl;
+		cout << "cache=<dir> build cache: a run with unchanged input files and options copies its output" << endl;
+		cout << "from the directory, layouts are reused if only zoom, png or ps changed" << endl;
+		return 0;
+	}
+
+	// default values
+	grotrian_options opt;
+	double ionlimit = 0.0;
+	diagnostics diag;
+	bool use_index = true;
+	string sweep_file;
+	string png_file;
+	string ps_file;
+	string rej_file;
+	string cache_dir;
+	vector<string> series;
+	bool shared = false;
+	unsigned nthreads = thread::hardware_concurrency();
+
+	// get all options, start with arg #2
+	for(int i = 2; i<argc; i++)
+	{
+		string s(argv[i]);
+		if (s.substr(0,2) == "e=")
 		{
-			// add for top labels
-			sort(i.levels.begin(),i.levels.end(),sort_by_L);
-			for(const auto &j:i.levels)
-			{
-				mul_lp mlp;
-				mlp.mult = j.mult;
-				mlp.l = j.l;
-				mlp.p = j.p;
-				// check if we had this mult/L/P before
-				auto it = find(i.multis.begin(),i.multis.end(),mlp);
-				if(it == i.multis.end())
-					i.multis.push_back(mlp);
-			}
-			sort(i.multis.begin(),i.multis.end(),sort_by_lp);
-			total += i.multis.size();
+			stringstream ss(s.substr(2));
+			ss >> opt.skip_e;
 		}
-
-		// get x-positions / width of one column
-		unit = 100.0 / total;
-
-		// energy low/high
-		double low,high;
-		low = vec_levels.front().energy;
-		high = vec_levels.back().energy;
-		double yoffset = (ionlimit * 0.02);
-
-
-		// make plot
-		cout << fixed << setprecision(2);
-		cout << endl << "PAPERFORMAT A3Q" << endl;
-		cout << "MULTIPLOT START" << endl;
-		cout << "** y min/max: " << low << "/" << high << endl;
-		cout << "** y offset: " <<  yoffset << endl << endl;
-
-		cout << "PLOT: labels" << endl;
-		cout << "\\OFS 2.0 2.0" << endl;
-		cout << "\\INBOX" << endl;
-		cout << "\\PEN 1" << endl;
-		cout << "\\FONT=HELVET" << endl;
-		cout << "\\LETTERSIZE=0.25" << endl;
-		cout << "\\NOCOPYRIGHT" << endl;
-		cout << "\\LUN 50.0 " << (ionlimit+2*yoffset)/1000*1.03 << " -2.9 0.0 0.30 Grotrian diagram of " << argv[1] << endl;
-		cout << "HEADER :\\CENTER\\" << endl;
-		cout << "X-ACHSE:\\CENTER\\" << endl;
-		cout << "Y-ACHSE:\\CENTER\\ energy / 1000 cm&H-1&M" << endl;
-		cout << "    MASSTAB       MINIMUM       MAXIMUM    TEILUNGEN     BESCHRIFT.    DARUNTER" << endl;
-		cout << "X: 38.00CM              0.0         100.0         10.0          10            0.0 NOLAB NOTICK-BOTH" << endl;
-		cout << "Y: 25.70CM            " << (-yoffset)/1000 << "        " << (ionlimit+2*yoffset)/1000 << "         ";
-		cout << (ionlimit < 1.0e+6 ? 10 : (ionlimit < 8.0e+6 ? 50 : (ionlimit < 16.0e+6 ? 100 : 200))) << "           ";
-		cout << (ionlimit < 1.0e+6 ? 100 : (ionlimit < 8.0e+6 ? 500 : (ionlimit < 16.0e+6 ? 1000 : 2000))) << "            0.0" << endl;
-		cout << "N=  ?  PLOTSYMBOL 9 SYMBOLSIZE 0.1 PEN 1 XYTABLE SELECT 1 2 COLOR=1" << endl;
-		cout << "FINISH" << endl;
-		cout << "END" << endl << endl;
-
-		cout << "PLOT: Grotrian Diagram of TMAD File: " << argv[1] << endl;
-		cout << "\\OFS 2.0 2.0" << endl;
-		cout << "\\INBOX" << endl;
-		cout << "\\PEN 1" << endl;
-		cout << "\\FONT=HELVET" << endl;
-		cout << "\\LETTERSIZE=0.25" << endl;
-		cout << "\\NOCOPYRIGHT" << endl;
-		cout << "HEADER :\\CENTER\\" << endl;
-		cout << "X-ACHSE:\\CENTER\\" << endl;
-		cout << "Y-ACHSE:\\CENTER\\" << endl;
-		cout << "    MASSTAB       MINIMUM       MAXIMUM    TEILUNGEN     BESCHRIFT.    DARUNTER" << endl;
-		cout << "X: 38.00CM              0.0         100.0         10.0          10            0.0 NOTICK-BOTH" << endl;
-		cout << "Y: 25.70CM         " << (-yoffset) << "      " << (ionlimit+2*yoffset) << "      10000        100000            0.0 NOTICK-BOTH" << endl;
-		cout << "N=  ?  PLOTSYMBOL 9 SYMBOLSIZE 0.1 PEN 1 XYTABLE SELECT 1 2 COLOR=1" << endl;
-		cout << "0 " << ionlimit << endl;
-		cout << "100 " << ionlimit << endl;
-		cout << "FINISH" << endl;
-		cout << "** ionization limit: " << ionlimit << endl << endl;
-
-		stringstream ss_levels,ss_labels,ss_top,ss_seps;
-		ss_levels << fixed << setprecision(2);
-		ss_labels << fixed << setprecision(2);
-		ss_top << fixed << setprecision(2);
-		ss_seps << fixed << setprecision(1);
-
-		int before = 0;
-		for(const auto &i:all_multiplets)
+		else if (s.substr(0,2) == "n=")
 		{
-			// separators
-			// 0.5 units space left side + #units before + #units current
-			int width = i.multis.size();
-			double xpos = unit*(0.5 + before + width + 0.5);
-			if(xpos < 100)
-				ss_seps << "\\LINUN " << xpos << " YMIN " << xpos << " YMAX 0.0 0.0 SIZE=0.1 SYMBOL=9" << endl;
-			// label, centered in that area
-			ss_seps << "\\LUN " << (unit*before + (unit*width*0.5) + unit*0.5) << " " << ionlimit + yoffset*0.4 << " -0.2 0.0 0.20 S=" << ((i.mult - 1.0)*0.5) << endl;
-
-			// top labels
-			cout << fixed << setprecision(3);
-			ss_labels << fixed << setprecision(3);
-			int top_offset = 0;
-			for(const auto &j:i.multis)
-			{
-				// todo: percentage instead of 0.4?
-				double xlabelpos = unit*(before + top_offset + 0.5 + 0.4);
-				ss_top << "\\LUN " << xlabelpos << " YMAX 0.000 0.080 0.2 " << "&H" << j.mult << "&M" << get_L(j.l) << (j.p == 0 ? "" : "&Ho&M") << endl;
-				top_offset++;
-			}
-			// levels
-			for(const auto &j:i.levels)
-			{
-				// find position
-				mul_lp lp;
-				lp.l = j.l;
-				lp.p = j.p;
-				auto it = find(i.multis.begin(),i.multis.end(),lp);
-				int pos = it - i.multis.begin() + before;
-				double xlevelpos = unit*(pos+0.5+0.5);
-				// actual level - offset to the left
-				ss_levels << "\\LINUN " << (xlevelpos-unit*0.3) << " " << j.energy << " " << (xlevelpos) << " " << j.energy << " 0.0 0.0" << endl;
-				// label next to level
-				ss_labels << "\\LUN " << (xlevelpos+unit*0.1) << " " << j.energy << " -0.0 -0.05 0.10 " << j.conf << endl;
-			}
-			// increase offset
-			before+= width + 1;
+			stringstream ss(s.substr(2));
+			ss >> opt.skip_n;
 		}
-
-		// check if we have found any lines
-		if(vec_lines.size() < 1)
+		else if (s.substr(0,2) == "l=")
 		{
-			cout << "** found no lines **" << endl;
+			stringstream ss(s.substr(2));
+			ss >> opt.skip_l;
 		}
-		else
+		else if (s.substr(0,2) == "c=")
 		{
-			stringstream sslines;
-			sslines << fixed << setprecision(2);
-			for(const auto &i:vec_lines)
-			{
-				// connecting line between levels
-				// find position
-				auto getxpos = [&](level lev)
-				{
-					mul_lp lp;
-					lp.l = lev.l;
-					lp.p = lev.p;
-					int ibefore = 0;
-					int res = 0;
-					for(const auto &j:all_multiplets)
-					{
-						if(lev.mult == j.mult)
-						{
-							auto it = find(j.multis.begin(),j.multis.end(),lp);
-							res = (it - j.multis.begin() + ibefore);
-							break;
-						}
-						else
-						{
-							// increase by size of that area + separator
-							ibefore += j.multis.size() + 1;
-						}
-					}
-					return res;
-				};
-
-				// width of a level = 0.3 units, position = xpos + 0.5 + 0.5
-				// --> 0.15 to the left from the right end of level line
-				double lowpos = unit*(getxpos(i.low)+0.85);
-				double highpos = unit*(getxpos(i.up)+0.85);
-				sslines << "\\LINUN " << (lowpos) << " " << i.low.energy <<  " " << (highpos) << " " << (i.up.energy) << " 0.0 0.0" << endl;
-			}
-			cout << "** connecting lines: **" << endl;
-			cout << "\\DEFINECOLOR 9 0.6 0.6 0.6" << endl;
-			cout << "\\PEN=1" << endl;
-			cout << "\\COLOR=9" << endl;
-			cout << sslines.str();
-			cout << "\\COLOR=1" << endl;
-			cout << "** total # lines: " << vec_lines.size() << " " << endl;
-			cout << "** end connecting lines **" << endl << endl;
+			opt.skip_conf.push_back(s.substr(2));
+		}
+		else if (s.substr(0,5) == "zoom=")
+		{
+			if(!grotrian_zoom(s.substr(5), opt))
+				cout << "** could not read zoom window: " << s.substr(5) << endl;
+		}
+		else if (s.substr(0,5) == "diag=")
+		{
+			stringstream ss(s.substr(5));
+			ss >> diag.max_examples;
+		}
+		else if (s.substr(0,4) == "rej=")
+		{
+			rej_file = s.substr(4);
+			if(!diag.open_rejects(rej_file))
+				cout << "** could not open file: " << rej_file << endl;
+		}
+		else if (s.substr(0,4) == "idx=")
+		{
+			stringstream ss(s.substr(4));
+			ss >> boolalpha >> use_index;
+		}
+		else if (s.substr(0,6) == "sweep=")
+		{
+			sweep_file = s.substr(6);
+		}
+		else if (s.substr(0,4) == "png=")
+		{
+			png_file = s.substr(4);
+		}
+		else if (s.substr(0,3) == "ps=")
+		{
+			ps_file = s.substr(3);
+		}
+		else if (s.substr(0,4) == "ion=")
+		{
+			series.push_back(s.substr(4));
+		}
+		else if (s.substr(0,6) == "cache=")
+		{
+			cache_dir = s.substr(6);
+		}
+		else if (s.substr(0,7) == "shared=")
+		{
+			stringstream ss(s.substr(7));
+			ss >> boolalpha >> shared;
+		}
+		else if (s.substr(0,8) == "threads=")
+		{
+			stringstream ss(s.substr(8));
+			ss >> nthreads;
 		}
-
-		cout << "** start levels **" << endl;
-		cout << "\\PEN=1" << endl;
-		cout << "\\COLOR=1" << endl;
-		cout << ss_levels.str();
-		cout << "** total # levels: " << vec_levels.size() << " " << endl;
-		cout << "** end levels **" << endl << endl;
-
-		cout << "** start inside labels **" << endl;
-		cout << "\\COLOR=3" << endl;
-		cout << ss_labels.str();
-		cout << "\\COLOR=1" << endl;
-		cout << "** total # inside labels: " << vec_levels.size() << " " << endl;
-		cout << "** end inside labels **" << endl << endl;
-
-		cout << "** start top labels **" << endl;
-		cout << "\\PEN=5" << endl;
-		cout << "\\COLOR=1" << endl;
-		cout << ss_top.str();
-		cout << "\\PEN=1" << endl;
-		cout << "** total # top labels: " << std::accumulate(all_multiplets.begin(), all_multiplets.end(),0,sum_labels) << " " << endl;
-		cout << "** end top labels **" << endl << endl;
-
-		cout << "** start separators ** " << endl;
-		cout << ss_seps.str();
-		cout << "** end separators ** " << endl << endl;
-
-		cout << "END" << endl << "MULTIPLOT END" << endl << endl;
-		in.close();
 	}
-	else
+	// a sweep filters later, for every variant
+	const grotrian_options read_opt = sweep_file.empty() ? opt : grotrian_options();
+	if(!sweep_file.empty() && !series.empty())
 	{
-		cout << "Could not open file: " << argv[1] << endl;
-		return 0;
+		cout << "** sweep= and ion= cannot be used together" << endl;
+		return -1;
 	}
 
-	// end
-	return 0;
-}
+	// columns, positions and the WRPLOT input; lines stay in file order
+	grotrian_options style = opt;
+	style.sort_lines = false;
+	style.kind = "TMAD";
+	style.level_pen = 1;
+	style.label_color = 3;
+	style.label_size = "0.10";
+
+	// build cache: a run with the same input files and options is only
+	// copied back, its printed output and files are stored otherwise
+	build_cache cache;
+	string run_key;
+	unique_ptr<output_capture> capture;
+	vector<string> outputs;
+	if(!cache_dir.empty())
+	{
+		vector<string> inputs = { argv[1], sweep_file };
+		inputs.insert(inputs.end(), series.begin(), series.end());
+		run_key = build_run_key("tmad_to_grotrian " __DATE__ " " __TIME__, vector<string>(argv + 1, argv + argc), inputs);
+		if(!cache.open(cache_dir))
+			cout << "** could not open build cache: " << cache_dir << endl;
+		else if(cache.restore(run_key, cout))
+		{
+			cout << "** build cache: unchanged, output of run " << run_key << endl;
+			return 0;
+		}
+		else
+			capture.reset(new output_capture(cout));
+		for(const auto &f:{ png_file, ps_file, rej_file })
+		{
+			if(!f.empty())
+				outputs.push_back(f);
+		}
+	}
+	auto stored = [&](int rc)
+	{
+		if(rc == 0 && capture && !cache.store(run_key, capture->text(), outputs))
+			cout << "** could not store in build cache: " << cache_dir << endl;
+		return rc;
+	};
 
-int det_L(char c)
-{
-	int l = -1;
-	switch(c)
+	if(!series.empty())
 	{
-	case 's':
-	case 'S':
-		l = 0;
-		break;
-	case 'p':
-	case 'P':
-		l = 1;
-		break;
-	case 'd':
-	case 'D':
-		l = 2;
-		break;
-	case 'f':
-	case 'F':
-		l = 3;
-		break;
-	case 'g':
-	case 'G':
-		l = 4;
-		break;
-	case 'h':
-	case 'H':
-		l = 5;
-		break;
-	case 'i':
-	case 'I':
-		l = 6;
-		break;
-	case 'k':
-	case 'K':
-		l = 7;
-		break;
-	case 'l':
-	case 'L':
-		l = 8;
-		break;
-	case 'm':
-	case 'M':
-		l = 9;
-		break;
-	case 'n':
-	case 'N':
-		l = 10;
-		break;
-	case 'o':
-	case 'O':
-		l = 11;
-		break;
-	case 'q':
-	case 'Q':
-		l = 12;
-		break;
-	case 'r':
-	case 'R':
-		l = 13;
-		break;
-	case 't':
-	case 'T':
-		l = 14;
-		break;
-	case 'u':
-	case 'U':
-		l = 15;
-		break;
-	case 'v':
-	case 'V':
-		l = 16;
-		break;
-	case 'w':
-	case 'W':
-		l = 17;
-		break;
-	case 'x':
-	case 'X':
-		l = 18;
-		break;
-	case 'y':
-	case 'Y':
-		l = 19;
-		break;
-	case 'z':
-	case 'Z':
-		l = 20;
-		break;
-	default:
-		break;
+		series.insert(series.begin(), argv[1]);
+		return stored(write_tmad_series(series, style, shared, use_index, nthreads, png_file, ps_file, cache, diag));
 	}
-	return l;
-}
 
-string get_L(int l)
-{
-	switch(l)
+	// a sweep needs the levels and lines, a single diagram only the layout
+	tmad_ion first;
+	first.file = argv[1];
+	bool ok = sweep_file.empty() ? layout_tmad_ion(first, use_index, style, cache) : read_tmad_ion(first, use_index, read_opt, cout);
+	cout << first.log;
+	first.diag.replay(diag);
+	if(!ok)
+		return 0;
+	grotrian_level_table& vec_levels = first.levels;
+	vector<grotrian_line>& vec_lines = first.lines;
+	ionlimit = first.ionlimit;
+
+	if(!sweep_file.empty())
 	{
-	case 0:
-		return "S";
-	case 1:
-		return "P";
-	case 2:
-		return "D";
-	case 3:
-		return "F";
-	case 4:
-		return "G";
-	case 5:
-		return "H";
-	case 6:
-		return "I";
-	case 7:
-		return "K";
-	case 8:
-		return "L";
-	case 9:
-		return "M";
-	case 10:
-		return "N";
-	case 11:
-		return "O";
-	case 12:
-		return "Q";
-	case 13:
-		return "R";
-	case 14:
-		return "T";
-	case 15:
-		return "U";
-	case 16:
-		return "V";
-	case 17:
-		return "W";
-	case 18:
-		return "X";
-	case 19:
-		return "Y";
-	case 20:
-		return "Z";
-
-	default:
-		cout << "** problem converting l: " << l << endl;
-		return "?";
+		vector<grotrian_variant> variants;
+		vector<string> failed;
+		string error;
+		if(!read_grotrian_sweep(sweep_file, style, variants, error))
+		{
+			cout << "** " << error << endl;
+			return -1;
+		}
+		int n = run_grotrian_sweep(vec_levels, vec_lines, ionlimit, variants, argv[1], nthreads, failed);
+		cout << "** sweep: " << n << " of " << variants.size() << " diagrams written" << endl;
+		for(const auto &f:failed)
+			cout << "** ERROR: no levels or couldn't write: " << f << endl;
+		diag.summary(cout);
+		for(const auto &v:variants)
+			outputs.push_back(v.file);
+		return stored(failed.empty() ? 0 : -1);
 	}
-}
\ No newline at end of file
+	const grotrian_layout& lay = first.lay;
+	write_grotrian(cout, lay, argv[1], style);
+	if(!png_file.empty() && !write_grotrian_preview(png_file, raster_grotrian_panels({ &lay }, { argv[1] }, style, false), style, nthreads))
+		cout << "** ERROR: couldn't write preview: " << png_file << endl;
+	if(!ps_file.empty() && !write_grotrian_ps(ps_file, raster_grotrian_panels({ &lay }, { argv[1] }, style, false), style))
+		cout << "** ERROR: couldn't write PostScript: " << ps_file << endl;
+	diag.summary(cout);
+
+	// end
+	return stored(0);
+}
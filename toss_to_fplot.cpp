@@ -13,25 +13,47 @@
 #include <iomanip>
 #include <string>
 #include <cmath>
-#include <tuple>
 #include <vector>
 #include <algorithm>
+#include "diagnostics.h"
+#include "compressed_stream.h"
+#include "pipeline.h"
+#include "fplot_idents.h"
+#include "raster_preview.h"
+#include "ps_writer.h"
+#include "parse_arena.h"
 using namespace std;
 
+// result of one block of lines
+struct parsed_batch
+{
+	std::vector<fplot_ident> values;
+	diagnostics_log log;
+};
+
 int main(int argc, char* argv[])
 {
-	ifstream in;
-	string line;
-	// custom struct vector: <wavelength, f-value, loggf>
-	std::vector<std::tuple<double, double, string>> values;
+	cifstream in;
+	// wavelength, f-value, loggf
+	std::vector<fplot_ident> values;
 	double scale = 1.0;
 	bool asUnit = false;
+	diagnostics diag;
+	unsigned nthreads = thread::hardware_concurrency();
+	string png_file;
+	string ps_file;
 
 	if(argc < 2)
 	{
 		cout << "Transforms lines in TOSS format (wvl+log gf) into" << endl;
 		cout << "WRPLOT idents to use in a f over lambda plot" << endl << "------------------------------------------------" << endl;
-		cout << "Usage: toss_to_fplot <filename> <scalefactor=1.0> <u=false>" << endl;
+		cout << "Usage: toss_to_fplot <filename> <scalefactor=1.0> <u=false> <options>" << endl;
+		cout << "Options: diag=<number>, rej=<file>, threads=<number>, png=<file>, ps=<file>" << endl;
+		cout << "diag: number of deviating lines printed (default 5)" << endl;
+		cout << "rej:  write all deviating lines to a file" << endl;
+		cout << "threads: number of parser threads (default: all cores)" << endl;
+		cout << "png:  also write a raster preview of the idents (PNG, or PPM for other names)" << endl;
+		cout << "ps:   the same drawing as compact PostScript" << endl;
 		return(0);
 	}
 	else if(argc >= 3)
@@ -48,6 +70,35 @@ int main(int argc, char* argv[])
 			ss2 >> std::boolalpha >> asUnit;
 		}
 		cout << "** output units (cm/U): " << (asUnit ? "U" : "cm") << endl;
+
+		// options
+		for(int i = 4; i < argc; i++)
+		{
+			string s(argv[i]);
+			if (s.substr(0,5) == "diag=")
+			{
+				stringstream ss3(s.substr(5));
+				ss3 >> diag.max_examples;
+			}
+			else if (s.substr(0,8) == "threads=")
+			{
+				stringstream ss3(s.substr(8));
+				ss3 >> nthreads;
+			}
+			else if (s.substr(0,4) == "png=")
+			{
+				png_file = s.substr(4);
+			}
+			else if (s.substr(0,3) == "ps=")
+			{
+				ps_file = s.substr(3);
+			}
+			else if (s.substr(0,4) == "rej=")
+			{
+				if(!diag.open_rejects(s.substr(4)))
+					cout << "** ERROR: couldn't open file: " << s.substr(4) << endl;
+			}
+		}
 	}
 
 	// open file and read line by line
@@ -56,42 +107,57 @@ int main(int argc, char* argv[])
 	in.open(argv[1]);
 	if(in.is_open())
 	{
-		while(getline(in,line))
-		{
-			double wvl,j_low,j_up,loggf,gA,f;
-			int g_low;
-			string dump;
-			stringstream ss(line);
-
-			ss >> wvl >> dump >> dump >> j_low >> dump >> dump >> j_up >> loggf >> gA;
-			ss.clear();
-			g_low = (2*j_low)+1;
+		// reader thread, parser threads, results in file order
+		run_line_pipeline<parsed_batch>(in, nthreads,
+			[](const string& text, parsed_batch& r)
+			{
+				for_each_line(text, [&](const string& line)
+				{
+					double wvl,j_low,j_up,loggf,gA,e_low,e_up;
+					string dump, info;
+					fplot_ident id;
 
-			f = pow(10,loggf) / g_low;
+					// plain numbers in place, anything else with a stream
+					const char* p = line.c_str();
+					if(!(parse_number(p, wvl) && parse_number(p, e_low) && parse_word(p) && parse_number(p, j_low) && parse_number(p, e_up)
+						&& parse_word(p) && parse_number(p, j_up) && parse_number(p, loggf) && parse_number(p, gA)))
+					{
+						stringstream ss(line);
+						ss >> wvl >> dump >> dump >> j_low >> dump >> dump >> j_up >> loggf >> gA;
+					}
 
-			// check if f-value and gA deviate
-			double f2 = gA * 1.49919E-16 * wvl * wvl / g_low;
-			double ratio = f/f2;
-			double diff = abs(1-ratio);
-			if(diff > 0.5)
+					// check if f-value and gA deviate
+					if(make_fplot_ident(wvl, j_low, loggf, gA, id, info))
+						r.values.push_back(id);
+					else
+						r.log.report("deviating f-value/gA", info);
+				});
+			},
+			[&](parsed_batch& r)
 			{
-				// error: print out some useful information
-				cout << "** deviating f-value/gA found:\n";
-				cout << "*** " << wvl << " gA:" << gA << " f:" << f << " f2:" << f2 << " ratio:" << ratio << " diff:" << diff << endl;
-				cout << "*** jlow:" << j_low << " glow:" << g_low << endl;
-			}
-			else
-				values.push_back(std::make_tuple(wvl, f, to_string(loggf)));
-		}
+				values.insert(values.end(), make_move_iterator(r.values.begin()), make_move_iterator(r.values.end()));
+				r.log.replay(diag);
+			});
 
 		// sort by first value, i.e., wavelength
 		std::sort(values.begin(),values.end());
-		for(const auto &v:values)
+		// blocks of idents are formatted while the writer thread prints
+		// the last ones
+		async_writer writer(cout);
+		for(size_t i0 = 0; i0 < values.size(); i0 += 10000)
 		{
+			ostringstream os;
 			// ID length by units or cm
-			cout << "\\IDLENG " << std::get<1>(v) * scale << (asUnit ? "U" : "") << endl;
-			cout << "\\IDENT  " << std::get<0>(v) << "    " << std::get<2>(v) << endl;
+			write_fplot(os, values.begin() + i0, values.begin() + std::min(values.size(), i0 + 10000), scale, asUnit);
+			writer.write(os.str());
 		}
+		writer.close();
+		if(!png_file.empty() && !write_fplot_preview(png_file, values, argv[1], nthreads))
+			cout << "** ERROR: couldn't write preview: " << png_file << endl;
+		if(!ps_file.empty() && !write_fplot_ps(ps_file, values, argv[1]))
+			cout << "** ERROR: couldn't write PostScript: " << ps_file << endl;
+		diag.summary(cout);
 	}
+
 	return 0;
 }
\ No newline at end of file
@@ -12,122 +12,26 @@
 #include <fstream>
 #include <sstream>
 #include <vector>
+#include <unordered_map>
+#include <thread>
+#include <memory>
+#include <chrono>
 #include <algorithm>
 #include <iomanip>
-#include <numeric>
+#include <cctype>
+#include <cstdlib>
 #include <math.h>
-
-// struct for levels
-struct level
-{
-	int mult;
-	int n;		// from config, for skipping levels
-	int p;		// from config/term, should be the same
-	int l;		// from term
-	double energy;
-	double J;	// read in, but currently not used
-
-	std::string name;
-	std::string conf;
-	std::string term;
-	std::string L;
-	std::string parity;
-
-	// compare to any A10-string (name)
-	bool operator==(const std::string& s)
-	{
-		return (name == s);
-	}
-	// compare by energy
-	bool operator==(const double& d)
-	{
-		return (energy == d);
-	}
-};
-// different sorting
-struct
-{
-	bool operator()(const level& i, const level& j)
-	{
-		if (i.l == j.l)
-			return i.energy < j.energy;
-		return i.l < j.l;
-	}
-}sort_by_L;
-struct
-{
-	bool operator()(const level& i, const level& j)
-	{
-		return i.energy < j.energy;
-	}
-}sort_by_E;
-
-// struct for lines
-struct transition
-{
-	level low, up;
-	double wvl;
-	double gf;
-	double gA;
-	std::string name;
-
-	// sort by wavelength
-	bool operator()(const transition& i, const transition& j)
-	{
-		if (i.wvl == j.wvl)
-			return i.gf < j.gf;
-		return i.wvl < j.wvl;
-	}
-}sort_by_wvl;
-
-// struct to keep track of top labels
-struct mul_lp
-{
-	int mult;
-	int l;
-	int p; // parity
-
-	// sort by l, parity
-	bool operator()(const mul_lp& i, const mul_lp& j)
-	{
-		if (i.l == j.l)
-			return i.p < j.p;
-		return i.l < j.l;
-	}
-}sort_by_lp;
-// compare 2 items of same multiplicity
-bool operator==(const mul_lp& lhs, const mul_lp& rhs)
-{
-	return (lhs.l == rhs.l) && (lhs.p == rhs.p);
-}
-
-// collection of levels for one type of multiplicity
-struct levels_mult
-{
-	int mult;
-	std::vector<mul_lp> multis;
-	std::vector<level> levels;
-
-	bool operator==(const int& m)
-	{
-		return (mult == m);
-	}
-	bool operator()(const levels_mult& i, const levels_mult& j)
-	{
-		return i.mult < j.mult;
-	}
-}sort_by_mult;
-
-auto sum_labels = [](const int lhs, const levels_mult& rhs)
-{
-	return lhs + rhs.multis.size();
-};
-
-
-// functions to convert angular momentum letters to numbers
-// and vice versa
-int det_L(const char c);
-std::string get_L(const int l);
+#include "diagnostics.h"
+#include "compressed_stream.h"
+#include "grotrian_layout.h"
+#include "grotrian_sweep.h"
+#include "grotrian_series.h"
+#include "raster_preview.h"
+#include "ps_writer.h"
+#include "build_cache.h"
+#include "file_watch.h"
+#include "parse_arena.h"
+#include "record_schema.h"
 
 // trim from start (in place)
 static inline void ltrim(std::string& s) {
@@ -150,177 +54,105 @@ static inline void trim(std::string& s) {
 }
 
 
-int main(int argc, char* argv[])
+// line as read, the levels are found by their energies
+struct toss_line
 {
-	using namespace std;
-	if (argc < 3)
-	{
-		cout << "\nUsage: toss_to_grotrian <levels file> <ionlimit> <options>\n";
-		cout << "\nOptions: lf=<file>, e=<number>, n=<number>, l=<number>, c=<Term><parity>\n";
-		cout << "lf adds an file with transitions, expected to be in TOSS format\n";
-		cout << "Exclude levels/configurations from the diagram which have\n";
-		cout << "energy >= e, principal quantum number >= n, angular momentum qn >= l\n";
-		cout << "or which have a certain configuration i.e. 3Po or 4Se" << endl;
-		return 0;
-	}
-
-	// default values
-	double skip_e = 9.9e+30;
-	int skip_n = 26;
-	int skip_l = 23;
-	double offset = 0.0;
-	vector<string> skip_conf;
-	string line_file;
+	grotrian_line tr;
+	double e_low;
+	double e_up;
+};
 
-	// get ion limit
-	double ionlimit;
-	try {
-		stringstream ss_ion(argv[2]);
-		ss_ion >> ionlimit;
-	}
-	catch (...) {
-		cout << "could not read ionization limit: " << argv[2] << endl;
-		return -1;
-	}
-	// get all options, start with arg #4
-	for (int i = 3; i < argc; i++)
-	{
-		string s(argv[i]);
-		if (s.substr(0, 3) == "lf=")
-		{
-			line_file = s.substr(3);
-		}
-		else if (s.substr(0, 2) == "e=")
-		{
-			stringstream ss(s.substr(2));
-			ss >> skip_e;
-		}
-		else if (s.substr(0, 2) == "n=")
-		{
-			stringstream ss(s.substr(2));
-			ss >> skip_n;
-		}
-		else if (s.substr(0, 2) == "l=")
-		{
-			stringstream ss(s.substr(2));
-			ss >> skip_l;
-		}
-		else if (s.substr(0, 2) == "c=")
-		{
-			skip_conf.push_back(s.substr(2));
-		}
-		else if (s.substr(0, 4) == "off=")
-		{
-			stringstream ss(s.substr(4));
-			ss >> offset;
-		}
-	}
+// one ion: level/line file, ionization limit and what was read; the
+// messages go to log and diag, so ions can be read on threads
+struct toss_ion
+{
+	std::string level_file;
+	std::string line_file;
+	double ionlimit = 0.0;
+	grotrian_level_table levels;
+	std::vector<toss_line> records;
+	std::vector<grotrian_line> lines;
+	diagnostics_log diag;
+	std::string log;
+	grotrian_layout lay;
+};
 
+// reads the levels of one ion; false if there are none
+bool read_toss_levels(toss_ion& ion, const grotrian_options& read_opt, std::ostream& log)
+{
+	using namespace std;
 	// buffers for input, in/out stream, line buffer
-	vector<level> vec_levels;
-	vector<transition> vec_lines;
-	ifstream in;
+	grotrian_level_table& vec_levels = ion.levels;
+	diagnostics_log& diag = ion.diag;
+	cifstream in;
 	string line;
-	// different multiplicities
-	vector<levels_mult> all_multiplets;
-
-	string atom;
-	int total;
-	double unit;
+	stringstream ss;
+	vec_levels.clear();
+	diag.events.clear();
 
 	// open file and read line by line
-	cout << "** attempting to open level file: " << argv[1] << endl;
-	in.open(argv[1]);
+	log << "** attempting to open level file: " << ion.level_file << endl;
+	in.open(ion.level_file.c_str());
 	if (in.is_open())
 	{
 		// read in stuff
 		while (getline(in, line))
 		{
-			level lev;
+			grotrian_level lev;
 			trim(line);
-			stringstream ss(line);
-			ss >> lev.energy;
+			// fields are read in place, the stream only if the energy
+			// is no plain number
+			const char* q = line.c_str();
+			if (!parse_number(q, lev.energy))
+			{
+				ss.str(line);
+				ss.clear();
+				ss >> lev.energy;
+			}
 
+			// the name is the rest without leading blanks, short lines
+			// give empty columns (and an error below)
 			auto pos = line.find_first_of(" ");
-			string rest = line.substr(pos);
-			trim(rest);
-			lev.name = rest;
+			text_view rest = text_view(line).sub(pos == string::npos ? line.size() : pos);
+			while (!rest.empty() && isspace((unsigned char)rest[0]))
+				rest = rest.sub(1);
 
 			// read in configuration and term
-			lev.term = rest.substr(7, 2);
-			std::transform(lev.term.begin(), lev.term.end(), lev.term.begin(), ::toupper);
-			lev.conf = rest.substr(3, 3);
+			text_view t = toss_level_record::term::get(rest), c = toss_level_record::conf::get(rest);
+			string term(t.p, t.n);
+			std::transform(term.begin(), term.end(), term.begin(), ::toupper);
+			lev.conf.assign(c.p, c.n);
 			std::transform(lev.conf.begin(), lev.conf.end(), lev.conf.begin(), ::tolower);
 
-			// read in J
-			ss.str(rest.substr(6, 1));
-			ss.clear();
-			ss >> lev.J;
-
-			// convert multiplicity (i.e., 2S+1) to int, convert L to int
-			ss.str(lev.term.substr(0, 1));
-			ss.clear();
-			ss >> lev.mult;
-			if (lev.mult < 1 || lev.mult > 9)
-			{
-				cout << "** Error with multiplicity:" << endl << line << endl;
-				continue;
-			}
-			lev.L = lev.term.substr(1, 1);
-			lev.l = det_L(lev.L.c_str()[0]);
-			if (lev.l < 0)
+			// multiplicity (i.e., 2S+1) and L
+			string error;
+			if (!grotrian_term(term, lev, error))
 			{
-				cout << "** Error with total angular momentum L:" << endl << line << endl;
+				diag.report(error, line);
 				continue;
 			}
 
 			// get n from configuration
-			ss.str(lev.conf.substr(0, 2));
-			ss.clear();
-			ss >> lev.n;
+			parse_int(text_view(lev.conf).sub(0, 2), lev.n);
 
 			// get parity
-			string p = rest.substr(9, 1);
+			text_view p = toss_level_record::parity::get(rest);
 			if (p == "O" || p == "o")
-			{
 				lev.p = 1;
-				lev.parity = "o";
-			}
 			else if (p == " " || p.size() == 0)
-			{
 				lev.p = 0;
-				lev.parity = "e";
-			}
 			else
 			{
-				cout << "** length:" << p.size() << endl;
-				cout << "** Error with parity: " << endl << "** " << line << endl;
+				diag.report("Error with parity", line);
 				continue;
 			}
 
-			// check if we should skip this e, n, or l
-			if (lev.energy >= skip_e || lev.n >= skip_n || lev.l >= skip_l)
+			// check if we should skip this e, n, l or term
+			if (grotrian_skip(lev, read_opt))
 				continue;
 
-			// check if should skip this term
-			ss.str(lev.term);
-			ss.clear();
-			ss << lev.parity;
-			bool skip = false;
-			for (const auto& x : skip_conf)
-			{
-				if (x == ss.str())
-				{
-					skip = true;
-					break;
-				}
-			}
-			if (skip)
-			{
-				continue;
-			}
-
 			// all good -> add to vector
+			lev.index = vec_levels.size();
 			vec_levels.push_back(lev);
 		}
 		// end getline
@@ -329,436 +161,505 @@ int main(int argc, char* argv[])
 		// check if we have found any levels
 		if (vec_levels.size() < 1)
 		{
-			cout << "** found no levels **" << endl;
-			return -1;
+			log << "** found no levels **" << endl;
+			return false;
 		}
 	}
 	else
 	{
-		cout << "Could not open level file: " << argv[1] << endl;
-		return -1;
+		log << "Could not open level file: " << ion.level_file << endl;
+		return false;
 	}
+	return true;
+}
+
+// reads the lines of one ion, they are matched to the levels later
+void read_toss_lines(toss_ion& ion, std::ostream& log)
+{
+	using namespace std;
+	cifstream in;
+	string line;
+	stringstream ss;
+	ion.records.clear();
 
-	cout << "** attempting to open line file: " << line_file << endl;
-	in.open(line_file.c_str());
+	log << "** attempting to open line file: " << ion.line_file << endl;
+	in.open(ion.line_file.c_str());
 	if (in.is_open())
 	{
 		while (getline(in, line))
 		{
-			stringstream ss(line);
-			transition tr;
-			double e_low, e_up, j_low, j_up;
+			toss_line t;
+			double j_low, j_up, gA;
 			string p_low, p_up;
 			double loggf;
 
-			ss >> tr.wvl >> e_low >> p_low >> j_low >> e_up >> p_up >> j_up >> loggf >> tr.gA;
-			tr.gf = pow(10, loggf);
-
-			// check if we find both levels
-			auto it = find(vec_levels.begin(), vec_levels.end(), e_low);
-			if (it == vec_levels.end())
-				continue;
-			else
-				tr.low = *it;
-			it = find(vec_levels.begin(), vec_levels.end(), e_up);
-			if (it == vec_levels.end())
-				continue;
-			else
-				tr.up = *it;
-
-			tr.name = line;
-			vec_lines.push_back(tr);
+			// plain numbers without a stream, anything else (header and
+			// empty lines) as before
+			const char* p = line.c_str();
+			if (!(parse_number(p, t.tr.wvl) && parse_number(p, t.e_low) && parse_word(p) && parse_number(p, j_low) && parse_number(p, t.e_up)
+				&& parse_word(p) && parse_number(p, j_up) && parse_number(p, loggf) && parse_number(p, gA)))
+			{
+				ss.str(line);
+				ss.clear();
+				if (!(ss >> t.tr.wvl >> t.e_low >> p_low >> j_low >> t.e_up >> p_up >> j_up >> loggf >> gA))
+					continue;
+			}
+			t.tr.gf = pow(10, loggf);
+			ion.records.push_back(t);
 		}
 		in.close();
 	}
 	else
 	{
 		// do not abort, but let the user know there are no lines drawn
-		cout << " ** Could not open line file: " << line_file << "\n **" << endl;
+		log << " ** Could not open line file: " << ion.line_file << "\n **" << endl;
 	}
+}
 
+// lines whose levels are both drawn
+void match_toss_lines(toss_ion& ion)
+{
+	// levels are found by energy, the first one in the file counts
+	std::unordered_map<double, int> by_energy;
+	for (size_t i = 0; i < ion.levels.size(); i++)
+		by_energy.emplace(ion.levels.energy[i], ion.levels.index[i]);
 
-	// determine different terms and sort
-	sort(vec_levels.begin(), vec_levels.end(), sort_by_E);
-	for (const auto& i : vec_levels)
+	ion.lines.clear();
+	for (const auto& t : ion.records)
 	{
-		// check if we had this multiplicity before
-		auto it = find(all_multiplets.begin(), all_multiplets.end(), i.mult);
-		if (it == all_multiplets.end())
-		{
-			// does not exist yet
-			vector<level> v;
-			v.push_back(i);
-			vector<mul_lp> m;
-			all_multiplets.push_back({ i.mult,m,v });
-		}
-		else
-		{
-			// add to correct collection
-			it->levels.push_back(i);
-		}
+		auto low = by_energy.find(t.e_low);
+		auto up = by_energy.find(t.e_up);
+		if (low == by_energy.end() || up == by_energy.end())
+			continue;
+		grotrian_line tr = t.tr;
+		tr.low = low->second;
+		tr.up = up->second;
+		ion.lines.push_back(tr);
 	}
-	sort(all_multiplets.begin(), all_multiplets.end(), sort_by_mult);
-
-	// # of total columns
-	// one for each mlp combination
-	// one for each separator between groups (== all_multis size - 1)
-	// + 1 extra for space at left/right border --> all_multis.size + size of all mlp_vectors
-	total = all_multiplets.size();
-	for (auto& i : all_multiplets)
+}
+
+// reads the levels and lines of one ion; false if there are no levels
+bool read_toss_ion(toss_ion& ion, const grotrian_options& read_opt, std::ostream& log)
+{
+	if (!read_toss_levels(ion, read_opt, log))
+		return false;
+	read_toss_lines(ion, log);
+	match_toss_lines(ion);
+	return true;
+}
+
+// key of the layout of one ion: content of its files, ionization limit
+// and the options the layout depends on
+std::string toss_layout_key(const toss_ion& ion, const grotrian_options& opt)
+{
+	build_hash h;
+	h.add("toss_to_grotrian layout " __DATE__ " " __TIME__);
+	h.add_file(ion.level_file);
+	h.add_file(ion.line_file);
+	std::stringstream ss;
+	ss << std::setprecision(17) << ion.ionlimit;
+	h.add(ss.str());
+	h.add(grotrian_layout_signature(opt));
+	return h.hex();
+}
+
+// reads and lays out one ion, or takes layout and messages from the build
+// cache if its files and options are unchanged; false if there are no levels
+bool layout_toss_ion(toss_ion& ion, const grotrian_options& opt, const build_cache& cache)
+{
+	using namespace std;
+	string key;
+	if (cache.is_open())
 	{
-		// add for top labels
-		sort(i.levels.begin(), i.levels.end(), sort_by_L);
-		for (const auto& j : i.levels)
+		key = toss_layout_key(ion, opt);
+		string data;
+		if (cache.get(key, data))
 		{
-			mul_lp mlp;
-			mlp.mult = j.mult;
-			mlp.l = j.l;
-			mlp.p = j.p;
-			// check if we had this mult/L/P before
-			auto it = find(i.multis.begin(), i.multis.end(), mlp);
-			if (it == i.multis.end())
-				i.multis.push_back(mlp);
+			stringstream ss(data);
+			if (read_cache_log(ss, ion.log, ion.diag) && read_grotrian_layout(ss, ion.lay))
+				return true;
+			ion.diag.events.clear();
 		}
-		sort(i.multis.begin(), i.multis.end(), sort_by_lp);
-		total += i.multis.size();
 	}
 
-	// get x-positions / width of one column
-	unit = 100.0 / total;
-
-	// energy low/high
-	double low, high;
-	low = vec_levels.front().energy;
-	high = vec_levels.back().energy;
-	double yoffset = (ionlimit * 0.02);
-
-
-	// make plot
-	cout << fixed << setprecision(2);
-	cout << endl << "PAPERFORMAT A3Q" << endl;
-	cout << "MULTIPLOT START" << endl;
-	cout << "** y min/max: " << low << "/" << high << endl;
-	cout << "** y offset: " << yoffset << endl << endl;
-
-	cout << "PLOT: labels" << endl;
-	cout << "\\OFS 2.0 2.0" << endl;
-	cout << "\\INBOX" << endl;
-	cout << "\\PEN 1" << endl;
-	cout << "\\FONT=HELVET" << endl;
-	cout << "\\LETTERSIZE=0.25" << endl;
-	cout << "\\NOCOPYRIGHT" << endl;
-	cout << "\\LUN 50.0 " << (ionlimit + 2 * yoffset) / 1000 * 1.03 << " -2.9 0.0 0.30 Grotrian diagram of " << argv[1] << endl;
-	cout << "HEADER :\\CENTER\\" << endl;
-	cout << "X-ACHSE:\\CENTER\\" << endl;
-	cout << "Y-ACHSE:\\CENTER\\ energy / 1000 cm&H-1&M" << endl;
-	cout << "    MASSTAB       MINIMUM       MAXIMUM    TEILUNGEN     BESCHRIFT.    DARUNTER" << endl;
-	cout << "X: 38.00CM              0.0         100.0         10.0          10            0.0 NOLAB NOTICK-BOTH" << endl;
-	cout << "Y: 25.70CM            " << (-yoffset) / 1000 << "        " << (ionlimit + 2 * yoffset) / 1000 << "         ";
-	cout << (ionlimit < 1.0e+6 ? 10 : (ionlimit < 8.0e+6 ? 50 : (ionlimit < 16.0e+6 ? 100 : 200))) << "           ";
-	cout << (ionlimit < 1.0e+6 ? 100 : (ionlimit < 8.0e+6 ? 500 : (ionlimit < 16.0e+6 ? 1000 : 2000))) << "            0.0" << endl;
-	cout << "N=  ?  PLOTSYMBOL 9 SYMBOLSIZE 0.1 PEN 1 XYTABLE SELECT 1 2 COLOR=1" << endl;
-	cout << "FINISH" << endl;
-	cout << "END" << endl << endl;
-
-	cout << "PLOT: Grotrian Diagram of TOSS File: " << argv[1] << endl;
-	cout << "\\OFS 2.0 2.0" << endl;
-	cout << "\\INBOX" << endl;
-	cout << "\\PEN 1" << endl;
-	cout << "\\FONT=HELVET" << endl;
-	cout << "\\LETTERSIZE=0.25" << endl;
-	cout << "\\NOCOPYRIGHT" << endl;
-	cout << "HEADER :\\CENTER\\" << endl;
-	cout << "X-ACHSE:\\CENTER\\" << endl;
-	cout << "Y-ACHSE:\\CENTER\\" << endl;
-	cout << "    MASSTAB       MINIMUM       MAXIMUM    TEILUNGEN     BESCHRIFT.    DARUNTER" << endl;
-	cout << "X: 38.00CM              0.0         100.0         10.0          10            0.0 NOTICK-BOTH" << endl;
-	cout << "Y: 25.70CM         " << (-yoffset) << "      " << (ionlimit + 2 * yoffset) << "      10000        100000            0.0 NOTICK-BOTH" << endl;
-	cout << "N=  ?  PLOTSYMBOL 9 SYMBOLSIZE 0.1 PEN 1 XYTABLE SELECT 1 2 COLOR=1" << endl;
-	cout << "0 " << ionlimit << endl;
-	cout << "100 " << ionlimit << endl;
-	cout << "FINISH" << endl;
-	cout << "** ionization limit: " << ionlimit << endl << endl;
-
-	stringstream ss_levels, ss_labels, ss_top, ss_seps;
-	ss_levels << fixed << setprecision(2);
-	ss_labels << fixed << setprecision(2);
-	ss_top << fixed << setprecision(2);
-	ss_seps << fixed << setprecision(1);
-
-	int before = 0;
-	for (const auto& i : all_multiplets)
+	stringstream log;
+	bool ok = read_toss_ion(ion, opt, log);
+	if (ok)
+		ion.lay = layout_grotrian(ion.levels, ion.lines, ion.ionlimit, opt);
+	ion.log = log.str();
+	if (ok && cache.is_open())
 	{
-		// separators
-		// 0.5 units space left side + #units before + #units current
-		int width = i.multis.size();
-		double xpos = unit * (0.5 + before + width + 0.5);
-		if (xpos < 100)
-			ss_seps << "\\LINUN " << xpos << " YMIN " << xpos << " YMAX 0.0 0.0 SIZE=0.1 SYMBOL=9" << endl;
-		// label, centered in that area
-		ss_seps << "\\LUN " << (unit * before + (unit * width * 0.5) + unit * 0.5) << " " << ionlimit + yoffset * 0.4 << " -0.2 0.0 0.20 S=" << ((i.mult - 1.0) * 0.5) << endl;
-
-		// top labels
-		cout << fixed << setprecision(3);
-		ss_labels << fixed << setprecision(3);
-		int top_offset = 0;
-		for (const auto& j : i.multis)
-		{
-			// todo: percentage instead of 0.4?
-			double xlabelpos = unit * (before + top_offset + 0.5 + 0.4);
-			ss_top << "\\LUN " << xlabelpos << " YMAX 0.000 0.080 0.2 " << "&H" << j.mult << "&M" << get_L(j.l) << (j.p == 0 ? "" : "&Ho&M") << endl;
-			top_offset++;
-		}
-		// levels
-		for (const auto& j : i.levels)
+		stringstream ss;
+		write_cache_log(ss, ion.log, ion.diag);
+		write_grotrian_layout(ss, ion.lay);
+		cache.put(key, ss.str());
+	}
+	return ok;
+}
+
+// several ions, each one read and laid out on its own worker, written as
+// panels of one MULTIPLOT in the order given
+int write_toss_series(toss_ion& first, const std::vector<std::string>& series, const grotrian_options& opt, bool shared, unsigned nthreads,
+	const std::string& png_file, const std::string& ps_file, const build_cache& cache, diagnostics& diag)
+{
+	using namespace std;
+	vector<toss_ion> ions(1 + series.size());
+	ions[0] = first;
+	for (size_t i = 0; i < series.size(); i++)
+	{
+		// <level file>,<ionlimit>[,<line file>]
+		stringstream ss(series[i]);
+		string ion;
+		getline(ss, ions[i + 1].level_file, ',');
+		getline(ss, ion, ',');
+		getline(ss, ions[i + 1].line_file);
+		stringstream ss_ion(ion);
+		if (!(ss_ion >> ions[i + 1].ionlimit))
 		{
-			// find position
-			mul_lp lp;
-			lp.l = j.l;
-			lp.p = j.p;
-			auto it = find(i.multis.begin(), i.multis.end(), lp);
-			int pos = it - i.multis.begin() + before;
-			double xlevelpos = unit * (pos + 0.5 + 0.5) + offset * unit;
-			// actual level - offset to the left
-			ss_levels << "\\LINUN " << (xlevelpos - unit * 0.3) << " " << j.energy << " " << (xlevelpos) << " " << j.energy << " 0.0 0.0" << endl;
-			// label next to level
-			ss_labels << "\\LUN " << (xlevelpos + unit * 0.1) << " " << j.energy << " -0.0 -0.05 0.17 " << j.conf << endl;
+			cout << "** could not read ionization limit of ion: " << series[i] << endl;
+			return -1;
 		}
-		// increase offset
-		before += width + 1;
 	}
 
-	// check if we have found any lines
-	if (vec_lines.size() < 1)
+	vector<char> ok(ions.size(), 0);
+	grotrian_parallel(ions.size(), nthreads, [&](size_t i)
+	{
+		ok[i] = layout_toss_ion(ions[i], opt, cache);
+	});
+
+	// messages in the order of the ions
+	vector<grotrian_layout> lays;
+	vector<string> titles;
+	for (size_t i = 0; i < ions.size(); i++)
 	{
-		cout << "** found no lines **" << endl;
+		cout << ions[i].log;
+		ions[i].diag.replay(diag);
+		if (!ok[i])
+			return -1;
+		lays.push_back(ions[i].lay);
+		titles.push_back(ions[i].level_file);
 	}
-	else
+	write_grotrian_series(cout, lays, titles, opt, shared);
+	vector<const grotrian_layout*> ptrs;
+	for (const auto& lay : lays)
+		ptrs.push_back(&lay);
+	if (!png_file.empty() && !write_grotrian_preview(png_file, raster_grotrian_panels(ptrs, titles, opt, shared), opt, nthreads))
+		cout << "** ERROR: couldn't write preview: " << png_file << endl;
+	if (!ps_file.empty() && !write_grotrian_ps(ps_file, raster_grotrian_panels(ptrs, titles, opt, shared), opt))
+		cout << "** ERROR: couldn't write PostScript: " << ps_file << endl;
+	diag.summary(cout);
+	return 0;
+}
+
+//------------------------------------------------------------------------
+// watch mode: the diagram is written to out_file (and png/ps) again after
+// every change of the level or line file; only the changed file is read
+// again and only multiplicities with changed levels are laid out again,
+// the outputs are replaced by rename; runs until interrupted
+//------------------------------------------------------------------------
+int watch_toss(toss_ion& ion, const grotrian_options& opt, const std::string& out_file, const std::string& png_file, const std::string& ps_file,
+	unsigned nthreads)
+{
+	using namespace std;
+	grotrian_incremental_layout inc;
+	bool have_levels = read_toss_levels(ion, opt, cout);
+	read_toss_lines(ion, cout);
+	vector<string> files = { ion.level_file };
+	if (!ion.line_file.empty())
+		files.push_back(ion.line_file);
+	file_watch watch(files);
+	cout << "** watching " << ion.level_file << (ion.line_file.empty() ? "" : " and " + ion.line_file)
+		<< (watch.notified() ? " (inotify)" : " (polling)") << ", output: " << out_file << endl;
+
+	auto start = chrono::steady_clock::now();
+	for (;;)
 	{
-		stringstream sslines;
-		sslines << fixed << setprecision(2);
-		sort(vec_lines.begin(), vec_lines.end(), sort_by_wvl);
-		for (const auto& i : vec_lines)
+		if (have_levels)
 		{
-			// connecting line between levels
-			// find position
-			auto getxpos = [&](level lev)
+			match_toss_lines(ion);
+			grotrian_layout lay = inc.update(ion.levels, ion.lines, ion.ionlimit, opt);
+			// the plot ends every line with endl, it is flushed only once here
+			ostringstream text;
+			write_grotrian(text, lay, ion.level_file, opt);
+			bool ok = replace_file(out_file, [&](const string& tmp)
 			{
-				mul_lp lp;
-				lp.l = lev.l;
-				lp.p = lev.p;
-				int ibefore = 0;
-				int res = 0;
-				for (const auto& j : all_multiplets)
-				{
-					if (lev.mult == j.mult)
-					{
-						auto it = find(j.multis.begin(), j.multis.end(), lp);
-						res = (it - j.multis.begin() + ibefore);
-						break;
-					}
-					else
-					{
-						// increase by size of that area + separator
-						ibefore += j.multis.size() + 1;
-					}
-				}
-				return res;
-			};
-
-			// width of a level = 0.3 units, position = xpos + 0.5 + 0.5
-			// --> 0.15 to the left from the right end of level line
-			double lowpos = unit * (getxpos(i.low) + 0.85);
-			double highpos = unit * (getxpos(i.up) + 0.85);
-			sslines << "\\LINUN " << (lowpos) << " " << i.low.energy << " " << (highpos) << " " << (i.up.energy) << " 0.0 0.0" << endl;
+				cofstream out(tmp);
+				out << text.str();
+				out.close();
+				return !out.fail();
+			});
+			if (!ok)
+				cout << "** ERROR: couldn't write: " << out_file << endl;
+			vector<raster_grotrian_panel> panels = raster_grotrian_panels({ &lay }, { ion.level_file }, opt, false);
+			if (!png_file.empty() && !replace_file(png_file, [&](const string& tmp) { return write_grotrian_preview(tmp, panels, opt, nthreads); }))
+				cout << "** ERROR: couldn't write preview: " << png_file << endl;
+			if (!ps_file.empty() && !replace_file(ps_file, [&](const string& tmp) { return write_grotrian_ps(tmp, panels, opt); }))
+				cout << "** ERROR: couldn't write PostScript: " << ps_file << endl;
+
+			diagnostics diag;
+			ion.diag.replay(diag);
+			diag.summary(cout);
+			auto ms = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start).count();
+			cout << "** " << lay.levels.size() << " levels, " << lay.lines.size() << " lines, " << inc.rebuilt << " of " << inc.groups.size()
+				<< " multiplicities laid out again, written in " << ms << " ms" << endl;
 		}
-		cout << "** connecting lines: **" << endl;
-		cout << "\\DEFINECOLOR 9 0.6 0.6 0.6" << endl;
-		cout << "\\PEN=1" << endl;
-		cout << "\\COLOR=9" << endl;
-		cout << sslines.str();
-		cout << "\\COLOR=1" << endl;
-		cout << "** total # lines: " << vec_lines.size() << " " << endl;
-		cout << "** end connecting lines **" << endl << endl;
-	}
 
-	cout << "** start levels **" << endl;
-	cout << "\\PEN=2" << endl;
-	cout << "\\COLOR=1" << endl;
-	cout << ss_levels.str();
-	cout << "** total # levels: " << vec_levels.size() << " " << endl;
-	cout << "** end levels **" << endl << endl;
-
-	cout << "** start inside labels **" << endl;
-	cout << "\\COLOR=2" << endl;
-	cout << ss_labels.str();
-	cout << "\\COLOR=1" << endl;
-	cout << "** total # inside labels: " << vec_levels.size() << " " << endl;
-	cout << "** end inside labels **" << endl << endl;
-
-	cout << "** start top labels **" << endl;
-	cout << "\\PEN=5" << endl;
-	cout << "\\COLOR=1" << endl;
-	cout << ss_top.str();
-	cout << "\\PEN=1" << endl;
-	cout << "** total # top labels: " << std::accumulate(all_multiplets.begin(), all_multiplets.end(), 0, sum_labels) << " " << endl;
-	cout << "** end top labels **" << endl << endl;
-
-	cout << "** start separators ** " << endl;
-	cout << ss_seps.str();
-	cout << "** end separators ** " << endl << endl;
-
-	cout << "END" << endl << "MULTIPLOT END" << endl << endl;
-	in.close();
-
-	// end
+		vector<int> changed = watch.wait();
+		start = chrono::steady_clock::now();
+		for (int f : changed)
+		{
+			cout << "** changed: " << files[f] << endl;
+			if (f == 0)
+				have_levels = read_toss_levels(ion, opt, cout);
+			else
+				read_toss_lines(ion, cout);
+		}
+	}
 	return 0;
 }
 
-int det_L(const char c)
+int main(int argc, char* argv[])
 {
-	int l = -1;
-	switch (c)
+	using namespace std;
+	if (argc < 3)
 	{
-	case 's':
-	case 'S':
-		l = 0;
-		break;
-	case 'p':
-	case 'P':
-		l = 1;
-		break;
-	case 'd':
-	case 'D':
-		l = 2;
-		break;
-	case 'f':
-	case 'F':
-		l = 3;
-		break;
-	case 'g':
-	case 'G':
-		l = 4;
-		break;
-	case 'h':
-	case 'H':
-		l = 5;
-		break;
-	case 'i':
-	case 'I':
-		l = 6;
-		break;
-	case 'k':
-	case 'K':
-		l = 7;
-		break;
-	case 'l':
-	case 'L':
-		l = 8;
-		break;
-	case 'm':
-	case 'M':
-		l = 9;
-		break;
-	case 'n':
-	case 'N':
-		l = 10;
-		break;
-	case 'o':
-	case 'O':
-		l = 11;
-		break;
-	case 'q':
-	case 'Q':
-		l = 12;
-		break;
-	case 'r':
-	case 'R':
-		l = 13;
-		break;
-	case 't':
-	case 'T':
-		l = 14;
-		break;
-	case 'u':
-	case 'U':
-		l = 15;
-		break;
-	case 'v':
-	case 'V':
-		l = 16;
-		break;
-	case 'w':
-	case 'W':
-		l = 17;
-		break;
-	case 'x':
-	case 'X':
-		l = 18;
-		break;
-	case 'y':
-	case 'Y':
-		l = 19;
-		break;
-	case 'z':
-	case 'Z':
-		l = 20;
-		break;
-	default:
-		break;
+		cout << "\nUsage: toss_to_grotrian <levels file> <ionlimit> <options>\n";
+		cout << "\nOptions: lf=<file>, e=<number>, n=<number>, l=<number>, c=<Term><parity>, diag=<number>, rej=<file>\n";
+		cout << "lf adds an file with transitions, expected to be in TOSS format\n";
+		cout << "Exclude levels/configurations from the diagram which have\n";
+		cout << "energy >= e, principal quantum number >= n, angular momentum qn >= l\n";
+		cout << "or which have a certain configuration i.e. 3Po or 4Se\n";
+		cout << "diag is the number of bad levels printed per error, rej writes all of them to a file\n";
+		cout << "sweep=<file> writes one diagram per line \"<output file> <options>\" of the file,\n";
+		cout << "the input is read only once, threads=<number> diagrams are built at the same time\n";
+		cout << "zoom=<Emin>:<Emax> draws only this energy window (cm^-1) as a panel of its own,\n";
+		cout << "several zoom options give one panel per window\n";
+		cout << "ion=<levels file>,<ionlimit>[,<line file>] adds a further ion (several allowed),\n";
+		cout << "all ions are drawn side by side in one MULTIPLOT, shared=true puts them on one energy scale\n";
+		cout << "png=<file> also writes a raster preview of the diagram (PNG, or PPM for other names),\n";
+		cout << "ps=<file> the same drawing as compact PostScript\n";
+		cout << "cache=<dir> build cache: a run with unchanged input files and options copies its output\n";
+		cout << "from the directory, layouts are reused if only zoom, off, png or ps changed\n";
+		cout << "watch=<file> writes the diagram to the file and again after every change of the level\n";
+		cout << "or line file (png/ps too), until interrupted" << endl;
+		return 0;
 	}
-	return l;
-}
 
-std::string get_L(const int l)
-{
-	switch (l)
+	// default values
+	grotrian_options opt;
+	string line_file;
+	string sweep_file;
+	string png_file;
+	string ps_file;
+	string rej_file;
+	string cache_dir;
+	string watch_file;
+	vector<string> series;
+	bool shared = false;
+	unsigned nthreads = thread::hardware_concurrency();
+	diagnostics diag;
+
+	// get ion limit
+	double ionlimit;
+	try {
+		stringstream ss_ion(argv[2]);
+		ss_ion >> ionlimit;
+	}
+	catch (...) {
+		cout << "could not read ionization limit: " << argv[2] << endl;
+		return -1;
+	}
+	// get all options, start with arg #4
+	for (int i = 3; i < argc; i++)
 	{
-	case 0:
-		return "S";
-	case 1:
-		return "P";
-	case 2:
-		return "D";
-	case 3:
-		return "F";
-	case 4:
-		return "G";
-	case 5:
-		return "H";
-	case 6:
-		return "I";
-	case 7:
-		return "K";
-	case 8:
-		return "L";
-	case 9:
-		return "M";
-	case 10:
-		return "N";
-	case 11:
-		return "O";
-	case 12:
-		return "Q";
-	case 13:
-		return "R";
-	case 14:
-		return "T";
-	case 15:
-		return "U";
-	case 16:
-		return "V";
-	case 17:
-		return "W";
-	case 18:
-		return "X";
-	case 19:
-		return "Y";
-	case 20:
-		return "Z";
-
-	default:
-		std::cout << "** problem converting l: " << l << std::endl;
-		return "?";
+		string s(argv[i]);
+		if (s.substr(0, 3) == "lf=")
+		{
+			line_file = s.substr(3);
+		}
+		else if (s.substr(0, 2) == "e=")
+		{
+			stringstream ss(s.substr(2));
+			ss >> opt.skip_e;
+		}
+		else if (s.substr(0, 2) == "n=")
+		{
+			stringstream ss(s.substr(2));
+			ss >> opt.skip_n;
+		}
+		else if (s.substr(0, 2) == "l=")
+		{
+			stringstream ss(s.substr(2));
+			ss >> opt.skip_l;
+		}
+		else if (s.substr(0, 2) == "c=")
+		{
+			opt.skip_conf.push_back(s.substr(2));
+		}
+		else if (s.substr(0, 4) == "off=")
+		{
+			stringstream ss(s.substr(4));
+			ss >> opt.offset;
+		}
+		else if (s.substr(0, 5) == "zoom=")
+		{
+			if (!grotrian_zoom(s.substr(5), opt))
+				cout << "** could not read zoom window: " << s.substr(5) << endl;
+		}
+		else if (s.substr(0, 5) == "diag=")
+		{
+			stringstream ss(s.substr(5));
+			ss >> diag.max_examples;
+		}
+		else if (s.substr(0, 4) == "rej=")
+		{
+			rej_file = s.substr(4);
+			if (!diag.open_rejects(rej_file))
+				cout << "** could not open file: " << rej_file << endl;
+		}
+		else if (s.substr(0, 6) == "sweep=")
+		{
+			sweep_file = s.substr(6);
+		}
+		else if (s.substr(0, 4) == "png=")
+		{
+			png_file = s.substr(4);
+		}
+		else if (s.substr(0, 3) == "ps=")
+		{
+			ps_file = s.substr(3);
+		}
+		else if (s.substr(0, 4) == "ion=")
+		{
+			series.push_back(s.substr(4));
+		}
+		else if (s.substr(0, 6) == "cache=")
+		{
+			cache_dir = s.substr(6);
+		}
+		else if (s.substr(0, 6) == "watch=")
+		{
+			watch_file = s.substr(6);
+		}
+		else if (s.substr(0, 7) == "shared=")
+		{
+			stringstream ss(s.substr(7));
+			ss >> boolalpha >> shared;
+		}
+		else if (s.substr(0, 8) == "threads=")
+		{
+			stringstream ss(s.substr(8));
+			ss >> nthreads;
+		}
+	}
+	// a sweep filters later, for every variant
+	const grotrian_options read_opt = sweep_file.empty() ? opt : grotrian_options();
+	if (!sweep_file.empty() && !series.empty())
+	{
+		cout << "** sweep= and ion= cannot be used together" << endl;
+		return -1;
+	}
+	if (!watch_file.empty() && (!sweep_file.empty() || !series.empty() || !cache_dir.empty()))
+	{
+		cout << "** watch= draws one ion, without sweep=, ion= or cache=" << endl;
+		return -1;
 	}
-}
\ No newline at end of file
+	if (!watch_file.empty())
+	{
+		toss_ion ion;
+		ion.level_file = argv[1];
+		ion.line_file = line_file;
+		ion.ionlimit = ionlimit;
+		return watch_toss(ion, opt, watch_file, png_file, ps_file, nthreads);
+	}
+
+	// build cache: a run with the same input files and options is only
+	// copied back, its printed output and files are stored otherwise
+	build_cache cache;
+	string run_key;
+	unique_ptr<output_capture> capture;
+	vector<string> outputs;
+	if (!cache_dir.empty())
+	{
+		vector<string> inputs = { argv[1], line_file, sweep_file };
+		for (const auto& ion : series)
+		{
+			stringstream ss(ion);
+			string level_file, limit, lines;
+			getline(ss, level_file, ',');
+			getline(ss, limit, ',');
+			getline(ss, lines);
+			inputs.push_back(level_file);
+			inputs.push_back(lines);
+		}
+		run_key = build_run_key("toss_to_grotrian " __DATE__ " " __TIME__, vector<string>(argv + 1, argv + argc), inputs);
+		if (!cache.open(cache_dir))
+			cout << "** could not open build cache: " << cache_dir << endl;
+		else if (cache.restore(run_key, cout))
+		{
+			cout << "** build cache: unchanged, output of run " << run_key << endl;
+			return 0;
+		}
+		else
+			capture.reset(new output_capture(cout));
+		for (const auto& f : { png_file, ps_file, rej_file })
+		{
+			if (!f.empty())
+				outputs.push_back(f);
+		}
+	}
+	auto stored = [&](int rc)
+	{
+		if (rc == 0 && capture && !cache.store(run_key, capture->text(), outputs))
+			cout << "** could not store in build cache: " << cache_dir << endl;
+		return rc;
+	};
+
+	toss_ion first;
+	first.level_file = argv[1];
+	first.line_file = line_file;
+	first.ionlimit = ionlimit;
+	if (!series.empty())
+		return stored(write_toss_series(first, series, opt, shared, nthreads, png_file, ps_file, cache, diag));
+
+	// a sweep needs the levels and lines, a single diagram only the layout
+	bool ok = sweep_file.empty() ? layout_toss_ion(first, opt, cache) : read_toss_ion(first, read_opt, cout);
+	cout << first.log;
+	first.diag.replay(diag);
+	if (!ok)
+		return -1;
+	grotrian_level_table& vec_levels = first.levels;
+	vector<grotrian_line>& vec_lines = first.lines;
+
+	if (!sweep_file.empty())
+	{
+		vector<grotrian_variant> variants;
+		vector<string> failed;
+		string error;
+		if (!read_grotrian_sweep(sweep_file, opt, variants, error))
+		{
+			cout << "** " << error << endl;
+			return -1;
+		}
+		int n = run_grotrian_sweep(vec_levels, vec_lines, ionlimit, variants, argv[1], nthreads, failed);
+		cout << "** sweep: " << n << " of " << variants.size() << " diagrams written" << endl;
+		for (const auto& f : failed)
+			cout << "** ERROR: no levels or couldn't write: " << f << endl;
+		diag.summary(cout);
+		for (const auto& v : variants)
+			outputs.push_back(v.file);
+		return stored(failed.empty() ? 0 : -1);
+	}
+
+	// columns, positions and the WRPLOT input
+	const grotrian_layout& lay = first.lay;
+	write_grotrian(cout, lay, argv[1], opt);
+	if (!png_file.empty() && !write_grotrian_preview(png_file, raster_grotrian_panels({ &lay }, { argv[1] }, opt, false), opt, nthreads))
+		cout << "** ERROR: couldn't write preview: " << png_file << endl;
+	if (!ps_file.empty() && !write_grotrian_ps(ps_file, raster_grotrian_panels({ &lay }, { argv[1] }, opt, false), opt))
+		cout << "** ERROR: couldn't write PostScript: " << ps_file << endl;
+	diag.summary(cout);
+
+	// end
+	return stored(0);
+}
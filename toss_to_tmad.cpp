@@ -0,0 +1,322 @@
+//========================================================================
+// Name        : toss_to_tmad.cpp
+// Author      : Michael Knoerzer
+// Version     : 1.0 (2026-10-18)
+// Copyright   : Copyright (c) 2026
+// Description : Writes a TMAD model atom (ATOM, L and RBB sections)
+//             : from a level/line table, optionally with superlevels
+//             : C++11 !
+//========================================================================
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include <algorithm>
+#include <numeric>
+#include <math.h>
+#include "atomic_data.h"
+using namespace std;
+
+// one level of the model atom
+struct model_level
+{
+	string name;
+	double energy;	// g-weighted
+	double g;
+	int mult;
+	int p;
+};
+
+// sum of all lines between two model levels
+struct model_line
+{
+	int low, up;
+	double gf;
+};
+
+// multiplicity from a term like "3P*", 0 if unknown
+int term_mult(const string& term)
+{
+	if (term.size() >= 2 && isdigit(term[0]) && isalpha(term[1]))
+		return term[0] - '0';
+	return 0;
+}
+
+// n in base 36 (0-9, A-Z), for level numbers in few characters
+string base36(int n)
+{
+	string s;
+	do
+	{
+		s.insert(s.begin(), "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ"[n % 36]);
+		n /= 36;
+	} while (n > 0);
+	return s;
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc < 5)
+	{
+		cout << "\nUsage: toss_to_tmad <source> <ionlimit> <element> <charge> <options>\n";
+		cout << "\nSources: nist:<file>, adamant:<level file>,<line file>, toss:<file>, tmad:<file>\n";
+		cout << "ionlimit in cm^-1, 0 takes it from the source (TMAD only)\n";
+		cout << "\nOptions: super=<number>, code=<string>, out=<file>\n";
+		cout << "super: bundle levels of same parity/multiplicity into superlevels\n";
+		cout << "       within energy bands of this width (cm^-1)\n";
+		cout << "       without it, fine structure levels are combined into LS terms\n";
+		cout << "code:  element code at the start of the level names\n";
+		cout << "out:   output file (default <element><charge>.tmad)" << endl;
+		return 0;
+	}
+
+	// default values
+	double ionlimit = atof(argv[2]);
+	string element = argv[3];
+	int charge = atoi(argv[4]);
+	double band = 0.0;
+	string code;
+	string out_file = element + argv[4] + ".tmad";
+	transform(element.begin(), element.end(), element.begin(), ::toupper);
+
+	for (int i = 5; i < argc; i++)
+	{
+		string s(argv[i]);
+		if (s.substr(0, 6) == "super=")
+		{
+			stringstream ss(s.substr(6));
+			ss >> band;
+		}
+		else if (s.substr(0, 5) == "code=")
+		{
+			code = s.substr(5);
+		}
+		else if (s.substr(0, 4) == "out=")
+		{
+			out_file = s.substr(4);
+		}
+	}
+
+	// element code as expected by tmad_to_grotrian:
+	// 2 letter elements always have 3 characters
+	if (code.empty())
+	{
+		if (element.size() == 2)
+			code = element + "123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ"[min(charge, 34)];
+		else
+			code = element + to_string(charge + 1);
+	}
+	const size_t alen = element.size() == 2 ? 3 : code.size();
+	if (code.size() != alen || alen > 6)
+	{
+		cout << "** ERROR: element code must have " << alen << " characters: " << code << endl;
+		return -1;
+	}
+
+	atomic_data data;
+	cout << "** attempting to read source: " << argv[1] << endl;
+	if (!read_source(argv[1], data))
+	{
+		cout << "** ERROR: couldn't read source: " << argv[1] << endl;
+		return -1;
+	}
+	if (ionlimit <= 0.0)
+		ionlimit = data.ionlimit;
+	if (data.levels.empty() || ionlimit <= 0.0)
+	{
+		cout << "** found no levels or no ionization limit **" << endl;
+		return -1;
+	}
+	cout << "** " << data.levels.size() << " levels, " << data.lines.size() << " lines" << endl;
+
+	// map source levels to model levels, hash on the grouping key
+	vector<int> lmap(data.levels.size(), -1);
+	vector<model_level> model;
+	unordered_map<string, int> groups;
+
+	vector<int> order(data.levels.size());
+	iota(order.begin(), order.end(), 0);
+	sort(order.begin(), order.end(), [&](int i, int j) { return data.levels[i].energy < data.levels[j].energy; });
+
+	// current band per parity/multiplicity: (model level, lowest energy)
+	unordered_map<int, pair<int, double>> bands;
+	for (int i : order)
+	{
+		const atomic_level& l = data.levels[i];
+		int mult = term_mult(l.term);
+		double g = 2 * l.J + 1;
+		int m = -1;
+
+		if (band > 0.0)
+		{
+			// superlevel: new one if the band is full
+			int key = mult * 2 + l.p;
+			auto it = bands.find(key);
+			if (it != bands.end() && l.energy - it->second.second <= band)
+				m = it->second.first;
+			else
+				bands[key] = make_pair((int)model.size(), l.energy);
+		}
+		else if (!l.term.empty())
+		{
+			// LS term
+			string key = l.config + "_" + l.term + (l.p ? "o" : "e");
+			auto it = groups.find(key);
+			if (it != groups.end())
+				m = it->second;
+			else
+				groups[key] = model.size();
+		}
+
+		if (m < 0)
+		{
+			m = model.size();
+			model.push_back({ "", 0.0, 0.0, mult, l.p });
+		}
+		model[m].energy += g * l.energy;
+		model[m].g += g;
+		lmap[i] = m;
+	}
+	for (auto& m : model)
+		m.energy /= m.g;
+
+	// sort by energy, the ground state has to be the first level
+	vector<int> morder(model.size()), mrank(model.size());
+	iota(morder.begin(), morder.end(), 0);
+	sort(morder.begin(), morder.end(), [&](int i, int j) { return model[i].energy < model[j].energy; });
+	for (size_t i = 0; i < morder.size(); i++)
+		mrank[morder[i]] = i;
+
+	// names: code + config (up to 7 characters) + term and parity (3
+	// characters)
+	unordered_set<string> names;
+	const size_t room = tmad_level_record::code_conf::width - code.size();
+	int serial = 0;
+	vector<int> first(model.size(), -1);
+	for (int i : order)
+	{
+		if (first[lmap[i]] < 0)
+			first[lmap[i]] = i;
+	}
+	for (size_t k = 0; k < model.size(); k++)
+	{
+		const atomic_level& l = data.levels[first[k]];
+		string conf, term;
+		if (band > 0.0)
+		{
+			// superlevels are marked by an X instead of L
+			conf = "SL" + to_string(mrank[k]);
+			term = (model[k].mult > 0 ? to_string(model[k].mult) : string("0")) + "X";
+		}
+		else
+		{
+			conf = l.config;
+			transform(conf.begin(), conf.end(), conf.begin(), ::toupper);
+			conf.erase(remove(conf.begin(), conf.end(), '.'), conf.end());
+			term = l.term.substr(0, 2);
+			transform(term.begin(), term.end(), term.begin(), ::toupper);
+		}
+		term.resize(2, ' ');
+		term += model[k].p ? "O" : " ";
+		string name = tmad_level_record::name_columns::format(code + conf, term);
+		// not unique (config too long or unknown, cut to the column): the
+		// energy rank instead of the config if it fits, else the next
+		// free base 36 number
+		bool ranked = false;
+		while (!names.insert(name).second)
+		{
+			string tag = "#" + to_string(mrank[k]);
+			if (ranked || tag.size() > room)
+			{
+				tag = base36(serial++);
+				if (tag.size() < room)
+					tag = "#" + tag;
+			}
+			if (tag.size() > room)
+			{
+				cout << "** ERROR: no unique level names left for " << model.size() << " levels, code " << code << endl;
+				return -1;
+			}
+			name = tmad_level_record::name_columns::format(code + tag, term);
+			ranked = true;
+		}
+		model[k].name = name;
+	}
+
+	// lines: hash aggregation on (low, up) of the model levels
+	unordered_map<uint64_t, int> line_index;
+	vector<model_line> lines;
+	line_index.reserve(data.lines.size());
+	int internal = 0;
+	for (const auto& t : data.lines)
+	{
+		int lo = lmap[t.low];
+		int up = lmap[t.up];
+		if (lo == up)
+		{
+			internal++;
+			continue;
+		}
+		if (model[lo].energy > model[up].energy)
+			swap(lo, up);
+		uint64_t key = ((uint64_t)lo << 32) | (uint32_t)up;
+		auto it = line_index.find(key);
+		if (it == line_index.end())
+		{
+			line_index.emplace(key, lines.size());
+			lines.push_back({ lo, up, pow(10.0, t.loggf) });
+		}
+		else
+			lines[it->second].gf += pow(10.0, t.loggf);
+	}
+	sort(lines.begin(), lines.end(), [&](const model_line& i, const model_line& j)
+	{
+		if (mrank[i.low] == mrank[j.low])
+			return mrank[i.up] < mrank[j.up];
+		return mrank[i.low] < mrank[j.low];
+	});
+
+	// write
+	ofstream out(out_file.c_str());
+	if (!out.is_open())
+	{
+		cout << "** ERROR: couldn't open file: " << out_file << endl;
+		return -1;
+	}
+	out << ". model atom written by toss_to_tmad from " << argv[1] << endl;
+	if (band > 0.0)
+		out << ". superlevels, energy band " << band << " cm^-1" << endl;
+	out << "ATOM" << endl;
+	out << element << " " << charge << endl;
+	out << "L" << endl;
+	string rec;
+	for (int k : morder)
+	{
+		rec.clear();
+		tmad_level_record::line::put(rec, model[k].name, (ionlimit - model[k].energy) * c_light, model[k].g);
+		out << rec << "\n";
+	}
+	out << "0" << endl;
+	out << "RBB" << endl;
+	for (const auto& t : lines)
+	{
+		// f_ik of the combined line
+		rec.clear();
+		tmad_rbb_record::line::put(rec, model[t.low].name, model[t.up].name, 3, 3, t.gf / model[t.low].g);
+		out << rec << "\n";
+	}
+	out << "0" << endl;
+	out.close();
+
+	cout << "** model levels: " << model.size() << ", RBB transitions: " << lines.size();
+	if (internal > 0)
+		cout << " (" << internal << " lines inside superlevels skipped)";
+	cout << endl << "** written to: " << out_file << endl;
+
+	return 0;
+}
@@ -0,0 +1,83 @@
+//========================================================================
+// Name        : vec_math.h
+// Author      : Michael Knoerzer
+// Version     : 1.0 (2026-10-18)
+// Copyright   : Copyright (c) 2026
+// Description : Batched exp/pow10 kernels written so that the compiler
+//             : can vectorize them (no branches, no library calls)
+//             : compile with -O3 -fno-trapping-math (and -march=native)
+//             : to get SIMD code, the clamps are not if-converted otherwise
+//             : C++11 !
+//========================================================================
+#ifndef VEC_MATH_H
+#define VEC_MATH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__GNUC__)
+#define VEC_RESTRICT __restrict__
+#else
+#define VEC_RESTRICT
+#endif
+
+// exp(x) for one value: range reduction x = n*ln2 + r, |r| <= ln2/2,
+// Taylor polynomial for exp(r) and 2^n built directly in the exponent bits;
+// relative error < 1e-14, results below exp(-708) are flushed to 0
+inline double exp_kernel(double x)
+{
+	const double log2e = 1.4426950408889634;
+	const double ln2_hi = 6.93145751953125e-1;
+	const double ln2_lo = 1.42860682030941723212e-6;
+
+	double xc = x > -708.0 ? x : -708.0;
+	xc = xc < 709.0 ? xc : 709.0;
+	// t >= -1022, so truncation of t + 1024.5 rounds to nearest
+	double t = xc * log2e;
+	int n = (int)(t + 1024.5) - 1024;
+	double r = xc - n * ln2_hi - n * ln2_lo;
+
+	double p = 1.0 / 39916800.0;
+	p = p * r + 1.0 / 3628800.0;
+	p = p * r + 1.0 / 362880.0;
+	p = p * r + 1.0 / 40320.0;
+	p = p * r + 1.0 / 5040.0;
+	p = p * r + 1.0 / 720.0;
+	p = p * r + 1.0 / 120.0;
+	p = p * r + 1.0 / 24.0;
+	p = p * r + 1.0 / 6.0;
+	p = p * r + 0.5;
+	p = p * r + 1.0;
+	p = p * r + 1.0;
+
+	int64_t bits = (int64_t)(n + 1023) << 52;
+	double scale;
+	std::memcpy(&scale, &bits, sizeof(double));
+	double y = p * scale;
+	return x < -708.0 ? 0.0 : y;
+}
+
+// y[i] = exp(x[i])
+inline void vexp(const double* VEC_RESTRICT x, double* VEC_RESTRICT y, std::size_t n)
+{
+	for (std::size_t i = 0; i < n; i++)
+		y[i] = exp_kernel(x[i]);
+}
+
+// y[i] = 10^x[i]
+inline void vpow10(const double* VEC_RESTRICT x, double* VEC_RESTRICT y, std::size_t n)
+{
+	const double ln10 = 2.302585092994046;
+	for (std::size_t i = 0; i < n; i++)
+		y[i] = exp_kernel(x[i] * ln10);
+}
+
+// y[i] = exp(a * x[i]), i.e. Boltzmann factors with a = -hc/kT
+inline void vexp_scaled(const double* VEC_RESTRICT x, double a, double* VEC_RESTRICT y, std::size_t n)
+{
+	for (std::size_t i = 0; i < n; i++)
+		y[i] = exp_kernel(a * x[i]);
+}
+
+#endif